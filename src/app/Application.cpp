@@ -9,6 +9,7 @@
 #include "ChartsViewer.h"
 #include "ProjectData.h"
 #include "InlineStyleDef.h"
+#include "charts/FftPlanCache.h"
 
 Application::Application(int& argc, char** argv) : QApplication(argc, argv)
 {
@@ -18,6 +19,9 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
 	QApplication::setApplicationDisplayName("实验平台");
 	QApplication::setWindowIcon(QIcon(":/image/logo.png"));
 
+	// 复用上次运行测量得到的FFT计划
+	PSDA::FftPlanCache::loadWisdom(PSDA::FftPlanCache::defaultWisdomPath());
+
 	QTranslator* translator = new QTranslator(this);
 	if (translator->load(QString("translations/qt_zh_CN.qm")))
 	{
@@ -44,6 +48,7 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
 
 Application::~Application()
 {
+	PSDA::FftPlanCache::saveWisdom(PSDA::FftPlanCache::defaultWisdomPath());
 	if (_mainWindow)
 	{
 		delete _mainWindow;
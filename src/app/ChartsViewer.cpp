@@ -6,6 +6,7 @@
 #include "Application.h"
 #include "ProjectData.h"
 #include "charts/ChartPainter.h"
+#include "charts/PSDAnalyzer.h"
 
 ChartsViewer::ChartsViewer(QWidget* parent) : NativeBaseWindow(parent), ui(new Ui::ChartsViewerClass())
 {
@@ -33,13 +34,22 @@ ChartsViewer::ChartsViewer(QWidget* parent) : NativeBaseWindow(parent), ui(new U
 	radioGroup->addButton(ui->radioButtonAll);
 	radioGroup->addButton(ui->radioButtonOnlyts);
 	radioGroup->addButton(ui->radioButtonOnlyfs);
+	radioGroup->addButton(ui->radioButtonOnlyst);
 	connect(radioGroup, qOverload<QAbstractButton*>(&QButtonGroup::buttonClicked), this, &ChartsViewer::modeChanged);
 
 	connect(ui->checkBoxShowSeg, &QCheckBox::stateChanged, this, &ChartsViewer::updateSegCharts);
+
+	connect(&_summaryWatcher, &QFutureWatcher<QMap<QString, ChartSummary>>::finished, this, &ChartsViewer::chartSummariesFinished);
+	connect(&_spectrogramWatcher, &QFutureWatcher<QMap<QString, PSDA::Spectrogram>>::finished, this, &ChartsViewer::spectrogramsFinished);
 }
 
 ChartsViewer::~ChartsViewer()
 {
+	// 进度回调引用了本窗口，须等后台计算结束
+	if (auto projData = cApp->getProjData())
+		projData->cancelChartSummaries();
+	_summaryWatcher.waitForFinished();
+	_spectrogramWatcher.waitForFinished();
 	delete ui;
 }
 
@@ -99,32 +109,48 @@ void ChartsViewer::updateCharts()
 		ui->customFlowWidget->setSuitableItemSize(1000, 180);
 		break;
 	}
+	case ChartsViewer::ShowMode::ONLYST:
+	{
+		ui->customFlowWidget->setSuitableItemSize(1000, 360);
+		break;
+	}
 	default:
 		break;
 	}
 
+	auto type = ui->comboBoxAnalyseDim->currentData().value<ResType>();
+	auto wcname = ui->comboBoxWorkConditions->currentData(Qt::DisplayRole).toString();
+	// 时频谱在第一次显示时按传感器在后台计算，完成后重新绘制
+	QStringList missingSpectrograms;
+	auto addChart = [&](const QString& sensorname) {
+		if (mode == ShowMode::ONLYST && !_currentCharts->hasSpectrogram(sensorname))
+		{
+			missingSpectrograms.append(sensorname);
+			return;
+		}
+		auto widget = _currentCharts->getChart(sensorname, int(mode));
+		if (widget)
+			ui->customFlowWidget->addItem(new CustomFlowWidgetItem(widget, ""));
+	};
+
 	auto index = ui->comboBoxSense->currentIndex();
 	if (0 == index)
 	{
 		for (int i = 1; i < ui->comboBoxSense->count(); i++)
 		{
-			auto sensorname = ui->comboBoxSense->itemData(i, Qt::DisplayRole).toString();
-			auto widget = _currentCharts->getChart(sensorname, int(mode));
-			ui->customFlowWidget->addItem(new CustomFlowWidgetItem(widget,""));
+			addChart(ui->comboBoxSense->itemData(i, Qt::DisplayRole).toString());
 		}
 	}
 	else
 	{
-		auto sensorname = ui->comboBoxSense->currentText();
-		auto widget = _currentCharts->getChart(sensorname, int(mode));
-		ui->customFlowWidget->addItem(new CustomFlowWidgetItem(widget, ""));
+		addChart(ui->comboBoxSense->currentText());
 	}
+	requestSpectrograms(missingSpectrograms);
 
-	auto type = ui->comboBoxAnalyseDim->currentData().value<ResType>();
-	auto wcname = ui->comboBoxWorkConditions->currentData(Qt::DisplayRole).toString();
+	// 分段数据没有时频谱
 	auto hasSegData = cApp->getProjData()->hasSegData(type, wcname);
 	ui->checkBoxShowSeg->setEnabled(hasSegData);
-	if (0 == ui->comboBoxSense->currentIndex())
+	if (0 == ui->comboBoxSense->currentIndex() || mode == ShowMode::ONLYST)
 	{
 		ui->checkBoxShowSeg->setEnabled(false);
 		ui->checkBoxShowSeg->setChecked(false);
@@ -202,6 +228,10 @@ ChartsViewer::ShowMode ChartsViewer::getShowMode()
 	{
 		return ShowMode::ONLYFS;
 	}
+	else if (ui->radioButtonOnlyst->isChecked())
+	{
+		return ShowMode::ONLYST;
+	}
 	return ShowMode::ALL;
 }
 
@@ -223,15 +253,32 @@ void ChartsViewer::dimSelectChanged(int index)
 
 void ChartsViewer::wcSelectChanged(int index)
 {
-	if (_currentCharts)
-	{
-		delete _currentCharts;
-	}
+	// 上一个工况未完成的计算不再需要
+	cApp->getProjData()->cancelChartSummaries();
+	delete _currentCharts;
+	_currentCharts = nullptr;
+	_requestedSpectrograms.clear();
 	auto type = ui->comboBoxAnalyseDim->currentData().value<ResType>();
 	auto wcname = ui->comboBoxWorkConditions->itemData(index, Qt::DisplayRole).toString();
 
 	auto sensenames = cApp->getProjData()->geSensorNames(type, wcname);
-	_currentCharts = cApp->getProjData()->getCharts(type, wcname);
+	// 功率谱在后台计算，完成后由chartSummariesFinished绘图；进度回调在工作线程中，转到界面线程显示
+	ui->labelProgress->setText("功率谱计算中...");
+	_summaryWatcher.setFuture(cApp->getProjData()->computeChartSummariesAsync(type, QStringList{ wcname },
+		[this](int finished, int total) {
+			QMetaObject::invokeMethod(this, [this, finished, total]() {
+				if (_summaryWatcher.isRunning())
+					ui->labelProgress->setText(QString("功率谱计算中 %1/%2").arg(finished).arg(total));
+				}, Qt::QueuedConnection);
+		}));
+
+	// 只有动态实验工况可以查看时频图
+	const bool dynamic = cApp->getProjData()->isDynamicWorkingCondition(wcname);
+	ui->radioButtonOnlyst->setEnabled(dynamic);
+	if (!dynamic && ui->radioButtonOnlyst->isChecked())
+	{
+		ui->radioButtonAll->setChecked(true);
+	}
 
 	ui->comboBoxSense->blockSignals(true);
 	ui->comboBoxSense->clear();
@@ -247,6 +294,62 @@ void ChartsViewer::wcSelectChanged(int index)
 	emit wcSelectChangedSignal(type, wcname);
 }
 
+void ChartsViewer::chartSummariesFinished()
+{
+	ui->labelProgress->clear();
+	// 结果只对应发起时的工况，工况已切换时(已被取消)结果中没有当前工况
+	auto type = ui->comboBoxAnalyseDim->currentData().value<ResType>();
+	auto wcname = ui->comboBoxWorkConditions->currentData(Qt::DisplayRole).toString();
+	const auto summaries = _summaryWatcher.result();
+	if (_currentCharts || !summaries.contains(wcname))
+		return;
+
+	_currentCharts = cApp->getProjData()->createCharts(type, summaries[wcname]);
+	updateCharts();
+}
+
+void ChartsViewer::requestSpectrograms(const QStringList& sensorNames)
+{
+	// 同一时间只计算一批，进行中的一批完成后重新绘制时再请求其余传感器
+	if (_spectrogramWatcher.isRunning())
+		return;
+	QStringList pending;
+	for (const auto& sensorname : sensorNames)
+	{
+		if (!_requestedSpectrograms.contains(sensorname))
+			pending.append(sensorname);
+	}
+	if (pending.isEmpty())
+		return;
+
+	for (const auto& sensorname : pending)
+	{
+		_requestedSpectrograms.insert(sensorname);
+	}
+	auto type = ui->comboBoxAnalyseDim->currentData().value<ResType>();
+	auto wcname = ui->comboBoxWorkConditions->currentData(Qt::DisplayRole).toString();
+	ui->labelProgress->setText("时频谱计算中...");
+	_spectrogramWatcher.setFuture(cApp->getProjData()->computeSpectrogramsAsync(type, wcname, pending));
+}
+
+void ChartsViewer::spectrogramsFinished()
+{
+	if (!_summaryWatcher.isRunning())
+		ui->labelProgress->clear();
+	// 工况已切换时结果属于之前的绘图，丢弃
+	if (!_currentCharts)
+		return;
+	const auto spectrograms = _spectrogramWatcher.result();
+	for (auto iter = spectrograms.begin(); iter != spectrograms.end(); ++iter)
+	{
+		if (_requestedSpectrograms.contains(iter.key()) && !_currentCharts->hasSpectrogram(iter.key()))
+			_currentCharts->setSpectrogram(iter.key(), iter.value());
+	}
+	// 仍在查看时频谱时重新绘制，并请求计算期间新选择的传感器
+	if (getShowMode() == ShowMode::ONLYST)
+		updateCharts();
+}
+
 //void ChartsViewer::senseSelectChanged(int index)
 //{
 //	//auto type = ui->comboBoxAnalyseDim->itemData(index).value<ResType>();
@@ -1,7 +1,11 @@
 #pragma once
 #include "ui/base/NativeBaseWindow.h"
 
+#include <QFutureWatcher>
+#include <QSet>
+
 #include "ProjectData.h"
+#include "charts/PSDAnalyzer.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class ChartsViewerClass; };
@@ -28,7 +32,7 @@ protected:
 
 private:
 
-	enum class ShowMode { ALL, ONLYTS, ONLYFS };
+	enum class ShowMode { ALL, ONLYTS, ONLYFS, ONLYST };
 	ShowMode getShowMode();
 
 private:
@@ -38,7 +42,16 @@ private:
 	Q_SLOT void updateCharts();
 	Q_SLOT void updateSegCharts(int state);
 	Q_SLOT void modeChanged(QAbstractButton* button);
+	// 后台计算完成后在界面线程绘图
+	Q_SLOT void chartSummariesFinished();
+	Q_SLOT void spectrogramsFinished();
+	// 在后台计算还没有请求过的传感器的时频谱
+	void requestSpectrograms(const QStringList& sensorNames);
 private:
 	Ui::ChartsViewerClass* ui;
 	ChartPainter* _currentCharts{};
+	// 功率谱与时频谱在后台计算，界面线程只绘图；切换工况时取消未完成的计算
+	QFutureWatcher<QMap<QString, ChartSummary>> _summaryWatcher{};
+	QFutureWatcher<QMap<QString, PSDA::Spectrogram>> _spectrogramWatcher{};
+	QSet<QString> _requestedSpectrograms{};	//当前工况已请求过时频谱的传感器
 };
@@ -108,13 +108,17 @@ void MainWindow::wcSelectChangedSlot(ResType type, QString wcname)
 
 	auto pos = cApp->getProjData()->getSensorPositions(type);
 	if (pos.isEmpty())
+	{
+		_currentData.reset();
+		_currentColumns.clear();
 		return;
-	auto& exdata = cApp->getProjData()->getExtraData(type, wcname);
+	}
+	auto names = resetPlaybackData();
+	const auto& exdata = *_currentData;
 	_widgetRp->setRange(0, exdata.dataCount - 1);
 	auto weight = _widgetSvs->getCurrentWeight();
 	double min, max;
 	bool firstCompare = true;
-	QStringList names;
 	for (auto i = 0; i < pos.count(); i++)
 	{
 		auto fullName = pos[i].name + ((_currentDimType == ResType::GVA || _currentDimType == ResType::GVD) ? (QString("-") + weight) : "");
@@ -131,7 +135,6 @@ void MainWindow::wcSelectChangedSlot(ResType type, QString wcname)
 				min = qMin(exdata.statistics[fullName].min, min);
 				max = qMax(exdata.statistics[fullName].max, max);
 			}
-			names.append(pos[i].name);
 		}
 	}
 	_widgetSvs->resetMinmaxThresholdValue(max,min);
@@ -152,6 +155,32 @@ void MainWindow::wcSelectChangedSlot(ResType type, QString wcname)
 	}
 }
 
+QStringList MainWindow::resetPlaybackData()
+{
+	auto pos = cApp->getProjData()->getSensorPositions(_currentDimType);
+	auto weight = _widgetSvs->getCurrentWeight();
+	auto exdata = cApp->getProjData()->getExtraData(_currentDimType, _currentWcname, false);
+	QStringList names;
+	QStringList fullNames;
+	for (auto i = 0; i < pos.count(); i++)
+	{
+		auto fullName = pos[i].name + ((_currentDimType == ResType::GVA || _currentDimType == ResType::GVD) ? (QString("-") + weight) : "");
+		if (exdata->statistics.contains(fullName))
+		{
+			names.append(pos[i].name);
+			fullNames.append(fullName);
+		}
+	}
+	// 只加载有测点位置的传感器
+	_currentData = cApp->getProjData()->getExtraData(_currentDimType, _currentWcname, fullNames);
+	_currentColumns.clear();
+	for (const auto& fullName : fullNames)
+	{
+		_currentColumns.append(_currentData->data.value(fullName));
+	}
+	return names;
+}
+
 void MainWindow::headerMenuTriggered() {
 	auto chartsViewerVisible = cApp->getChartsViewer()->isVisible();
 	auto isSetData = !(cApp->getProjData()->getRootDirpath().isEmpty());
@@ -196,6 +225,10 @@ void MainWindow::importDataPkgTriggered() {
 	{
 		OpeMessageBox::info(this, "消息", "数据包打开成功");
 		ui->headerWidget->setTitle(cApp->getProjData()->getRootName());
+		_currentData.reset();
+		_currentColumns.clear();
+		// 数据包索引已建立，图表在选择工况时才加载数据
+		cApp->getChartsViewer()->fill();
 	}
 	else
 	{
@@ -248,22 +281,14 @@ void MainWindow::saveToLoaclTriggered()
 
 void MainWindow::handleTimestampChanged(int index)
 {
-	if (_currentWcname.isEmpty())
+	// 每帧只按下标取值，数据列在工况或权重变化时已经准备好
+	if (_currentWcname.isEmpty() || !_currentData)
 		return;
-	auto pos = cApp->getProjData()->getSensorPositions(_currentDimType);
-	if (pos.isEmpty())
-		return;
-	auto& exdata = cApp->getProjData()->getExtraData(_currentDimType, _currentWcname);
-	auto weight = _widgetSvs->getCurrentWeight();
 	QVector<float> values;
-	for (auto i = 0; i < pos.count(); i++)
+	values.reserve(_currentColumns.count());
+	for (auto column : _currentColumns)
 	{
-		auto fullName = pos[i].name + ((_currentDimType == ResType::GVA || _currentDimType == ResType::GVD) ? (QString("-") + weight) : "");
-		if (exdata.statistics.contains(fullName))
-		{
-
-			values.push_back(exdata.data[fullName][index]);
-		}
+		values.push_back(column ? column[index] : 0.0);
 	}
 	_sceneValue->setSensorValues(values);
 	for (size_t i = 0; i < values.count(); i++)
@@ -276,9 +301,10 @@ void MainWindow::handleTimestampChanged(int index)
 void MainWindow::handleWeightChanged(const QString& value)
 {
 	auto pos = cApp->getProjData()->getSensorPositions(_currentDimType);
-	if (pos.isEmpty())
+	if (pos.isEmpty() || _currentWcname.isEmpty())
 		return;
-	auto& exdata = cApp->getProjData()->getExtraData(_currentDimType, _currentWcname);
+	resetPlaybackData();
+	const auto& exdata = *_currentData;
 	auto weight = _widgetSvs->getCurrentWeight();
 	double min, max;
 	bool firstCompare = true;
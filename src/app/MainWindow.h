@@ -41,6 +41,9 @@ private slots:
 	void handleWeightChanged(const QString& value);
 	void handleMinMaxThresholdChanged();
 	void handleDispmentScaledChanged(float value);
+private:
+	// 重新获取当前工况有测点位置的传感器数据(工况或权重变化时)，返回这些测点的名字
+	QStringList resetPlaybackData();
 private:
 	Ui::MainWindowClass* ui;
 
@@ -51,4 +54,6 @@ private:
 	SceneCtrl* _sceneCtrl{ nullptr };
 	ResType _currentDimType{ ResType::FP };
 	QString _currentWcname{""};
+	ExtraDataHandle _currentData{};				//当前工况数据，持有期间数据列不会被释放
+	QVector<SampleColumn> _currentColumns{};	//有测点位置的传感器数据列，与setSensorNames的顺序一致
 };
@@ -3,15 +3,57 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QSemaphore>
+#include <QSettings>
+#include <QThread>
 #include <QVariant>
 #include <QtConcurrent>
 
+#include "StatsIndex.h"
+#include "StatsKernel.h"
 #include "rwmat/ReadWriteMatFile.h"
+#include "rwmat/DataCache.h"
+#include "rwmat/MatBlockConsumers.h"
 #include "charts/ChartPainter.h"
+#include "charts/PsdEngine.h"
+#include "charts/PSDAnalyzer.h"
+
+namespace
+{
+	// 绘图摘要的作业：时域曲线对应变、脉动压力使用去运行均值后的波动数据
+	QVector<PsdEngine::Job> chartJobs(ResType dimtype, const QStringList& wcnames, const QVector<ExtraDataHandle>& snapshots,
+		const PSDA::WelchConfig& welch)
+	{
+		const bool removemean = (dimtype == ResType::Strain || dimtype == ResType::FP);
+		QVector<PsdEngine::Job> jobs;
+		for (int i = 0; i < snapshots.count(); ++i)
+		{
+			jobs.append({ dimtype, wcnames[i], snapshots[i], removemean, welch });
+		}
+		return jobs;
+	}
+}
 
 ProjectData::ProjectData(QObject* parent)
 	: QObject(parent)
+	, _psdEngine(std::make_shared<PsdEngine>())
 {
+	setIngestConcurrency(0, _ingestIoSlots);
+
+	// 常驻内存预算取自应用配置(MB，0表示不限制)，首次运行时写入默认值便于修改
+	QSettings appSettings;
+	if (!appSettings.contains(MEMORY_BUDGET_KEY))
+	{
+		appSettings.setValue(MEMORY_BUDGET_KEY, DEFAULT_MEMORY_BUDGET_MB);
+	}
+	setMemoryBudget(appSettings.value(MEMORY_BUDGET_KEY, DEFAULT_MEMORY_BUDGET_MB).toLongLong() * 1024 * 1024);
+	// float存储同样取自应用配置，缓存按存储精度区分，切换后重新处理
+	if (!appSettings.contains(FLOAT_STORAGE_KEY))
+	{
+		appSettings.setValue(FLOAT_STORAGE_KEY, false);
+	}
+	setFloatStorage(appSettings.value(FLOAT_STORAGE_KEY, false).toBool());
+
 	//obj, Z朝上
 	_sensorPostions[ResType::FP].push_back({ "P2",0.0,-2.152344,1.090410 });
 	_sensorPostions[ResType::FP].push_back({ "P3",0.0,-2.656265,1.770372 });
@@ -114,6 +156,9 @@ ProjectData::ProjectData(QObject* parent)
 
 ProjectData::~ProjectData()
 {
+	// 后台的绘图摘要计算持有引擎与数据快照，取消后自行结束
+	_psdEngine->cancel();
+	_ingestPool.waitForDone();
 }
 
 bool ProjectData::setDataPackage(const QString& dirPath, const QString& savePath/* = QString()*/, bool save /*= false*/)
@@ -134,7 +179,10 @@ bool ProjectData::setDataPackage(const QString& dirPath, const QString& savePath
 	_rootDirPath = QDir(dirPath).absolutePath();
 
 	if (!save)
-		return true;
+	{
+		clearLoadedData();
+		return buildPackageIndex();
+	}
 
 	return this->saveBackground(savePath, _rootName);
 }
@@ -146,41 +194,38 @@ bool ProjectData::loadForVisual()
 		qDebug() << "You need to set data package first.";
 		return false;
 	}
-	if (!loadWorkingConditions(getFullPathFromDirByAppointFolder("工况列表", _rootDirPath), _workingConditions))
+	if (_packageIndex.isEmpty() && !buildPackageIndex())
 	{
 		qDebug() << "Loading working conditions failed.";
 		return false;
 	}
-	QVector<QPair<QString, ResType>>resFloderInfo;
-	resFloderInfo.append({ "脉动压力",ResType::FP });
-	resFloderInfo.append({ "主闸振动加速度",ResType::GVA });
-	resFloderInfo.append({ "主闸振动位移",ResType::GVD });
-	resFloderInfo.append({ "#14主闸V11V12振动加速度",ResType::GVAExtra });
-	resFloderInfo.append({ "#14主闸V11V12振动位移",ResType::GVDExtra });
-	resFloderInfo.append({ "闸墩振动加速度",ResType::GPVA });
-	resFloderInfo.append({ "闸墩振动位移",ResType::GPVD });
-	resFloderInfo.append({ "系统油压",ResType::SysOP });
-	resFloderInfo.append({ "启闭机行程",ResType::SysStroke });
-	resFloderInfo.append({ "应力",ResType::Strain });
-	resFloderInfo.append({ "油压",ResType::OP });
-	resFloderInfo.append({ "启闭力",ResType::HC });
-	resFloderInfo.append({ "#13孔洞振动加速度",ResType::VA13 });
-	resFloderInfo.append({ "#13孔洞振动位移",ResType::VD13 });
-	resFloderInfo.append({ "#15孔洞振动加速度",ResType::VA15 });
-	resFloderInfo.append({ "#15孔洞振动位移",ResType::VD15 });
-	for (auto i = 0;i < resFloderInfo.count(); ++i)
+	// 所有维度的所有未加载工况摊平成一个任务列表并行加载，再按维度、文件名顺序合并，结果与串行加载一致
+	// 缓存有效的工况只读取缓存头部，数据列在访问时映射
+	QVector<IngestJob> jobs;
+	for (auto dim = _packageIndex.begin(); dim != _packageIndex.end(); ++dim)
 	{
-		auto folder = resFloderInfo[i];
-		auto folderFullpath = getFullPathFromDirByAppointFolder(folder.first, _rootDirPath);
-		QMap<QString, AnalyseData> analyseDatas;
-		qDebug() << "Start process :" << folder.first;
-		if (!loadAnalyseDataFile(folderFullpath, _workingConditions, analyseDatas, folder.second))
+		auto& loaded = _analyseDatas[dim.key()];
+		for (auto entry = dim.value().begin(); entry != dim.value().end(); ++entry)
+		{
+			if (!loaded.contains(entry.key()) && !openCachedCondition(dim.key(), entry.key()))
+			{
+				jobs.append({ dim.key(), entry.key(), entry.value().filepath, &_dimSettings[dim.key()] });
+			}
+		}
+	}
+
+	auto results = runIngestJobs(jobs);
+	for (auto i = 0; i < jobs.count(); ++i)
+	{
+		if (!results[i].ok)
 		{
-			qDebug() << "Loading resource data failed. floder:" << folder.first << " file:" << folderFullpath;
 			continue;
 		}
-		_analyseDatas[folder.second] = analyseDatas;
+		adoptIngested(jobs[i].type, jobs[i].wcName, results[i].exdata);
 	}
+	// 本次加载的数据均可淘汰
+	_residency.beginRequest();
+	enforceResidencyBudget();
 	return true;
 }
 
@@ -232,24 +277,27 @@ bool ProjectData::saveBackground(const QString& saveDir, const QString& filename
 		auto folder = resFloderInfo[i];
 		auto folderFullpath = getFullPathFromDirByAppointFolder(folder.first, _rootDirPath);
 		QMap<QString, AnalyseData> analyseDatas;
+		QMap<QString, ChartSummary> summaries;
 		qDebug() << "Start process :" << folder.first;
-		if (!loadAnalyseDataFile(folderFullpath, wcs, analyseDatas, folder.second, true))
+		if (!summarizeAnalyseDataFile(folderFullpath, wcs, analyseDatas, summaries, folder.second))
 		{
 			qDebug() << "Loading resource data failed. floder:" << folder.first << " file:" << folderFullpath;
 			continue;
 		}
 
+		// 相干系数需要全部传感器的原始数据，不能在流式汇总中得到，逐个工况另外读取
+		const QMap<QString, CoherenceMatrix> coherences = reportCoherences(folderFullpath, wcs, folder.second);
+
 		QString name;
 		QString unit;
 		getResTypeInfo(folder.second, name, unit);
-		if (!saveAnalyseDataToDocx(doc, selection, /*digits[i]*/"", name, unit, folder.second, wcs, analyseDatas))
+		if (!saveAnalyseDataToDocx(doc, selection, /*digits[i]*/"", name, unit, folder.second, wcs, analyseDatas, &summaries, &coherences))
 		{
 			qDebug() << "Save analyse data to docx failed. floder:" << folder.first;
 			continue;
 		}
 		foreach(auto var, analyseDatas)
 		{
-			clearExtraData(var.exData);
 			delete var.charts;
 		}
 		//qDebug() << "Save analyse data to docx succeed. floder:" << folder.first;
@@ -266,9 +314,10 @@ bool ProjectData::saveBackground(const QString& saveDir, const QString& filename
 
 QVector<QPair<QString, ResType>> ProjectData::getDimNames()
 {
-	if (_analyseDatas.isEmpty())
+	// 已建立索引时以索引为准，无需加载数据
+	auto dimtypes = _packageIndex.isEmpty() ? _analyseDatas.keys() : _packageIndex.keys();
+	if (dimtypes.isEmpty())
 		return QVector<QPair<QString, ResType>>();
-	auto dimtypes = _analyseDatas.keys();
 	//std::sort(dimtypes.begin(), dimtypes.end(), &numericCompare);
 	QVector<QPair<QString, ResType>> results;
 	for (auto& type : dimtypes)
@@ -282,6 +331,18 @@ QVector<QPair<QString, ResType>> ProjectData::getDimNames()
 
 QVector<QPair<QString, bool>> ProjectData::geWorkingConditionsNames(ResType dimtype)
 {
+	if (_packageIndex.contains(dimtype))
+	{
+		const auto& entries = _packageIndex[dimtype];
+		auto names = entries.keys();
+		std::sort(names.begin(), names.end(), &numericCompare);
+		QVector<QPair<QString, bool>> results;
+		for (auto& name : names)
+		{
+			results.push_back({ name ,entries[name].hasSegData });
+		}
+		return results;
+	}
 	if (!_analyseDatas.contains(dimtype))
 		return QVector<QPair<QString, bool>>();
 
@@ -298,6 +359,12 @@ QVector<QPair<QString, bool>> ProjectData::geWorkingConditionsNames(ResType dimt
 
 QStringList ProjectData::geSensorNames(ResType dimtype, const QString& wcname)
 {
+	if (_packageIndex.value(dimtype).contains(wcname))
+	{
+		auto names = _packageIndex[dimtype][wcname].sensorNames;
+		std::sort(names.begin(), names.end(), &numericCompare);
+		return names;
+	}
 	if (!_analyseDatas.contains(dimtype))
 		return QStringList();
 
@@ -306,31 +373,149 @@ QStringList ProjectData::geSensorNames(ResType dimtype, const QString& wcname)
 		return QStringList();
 
 	const auto& sensorsData = data[wcname];
-	auto names = sensorsData.exData.data.keys();
+	auto names = sensorsData.exData.statistics.keys();
 	std::sort(names.begin(), names.end(), &numericCompare);
 	return names;
 }
 
 ChartPainter* ProjectData::getCharts(ResType dimtype, const QString& wcname)
 {
-	if (!_analyseDatas.contains(dimtype))
+	// 全过程与各分段的功率谱并行计算，界面线程只负责绘图
+	QMap<QString, ChartSummary> summaries;
+	if (!computeChartSummaries(dimtype, QStringList{ wcname }, summaries) || !summaries.contains(wcname))
 		return nullptr;
 
-	auto& data = _analyseDatas[dimtype];
-	if (!data.contains(wcname))
-		return nullptr;
+	return createCharts(dimtype, summaries[wcname]);
+}
 
-	auto& sensorsData = data[wcname];
+ChartPainter* ProjectData::createCharts(ResType dimtype, const ChartSummary& summary)
+{
 	QString resTitle, resUnit;
 	getResTypeInfo(dimtype, resTitle, resUnit);
 	ChartPainter* chart = new ChartPainter(resTitle, resUnit);
-	chart->setData(sensorsData.exData, (dimtype == ResType::Strain || dimtype == ResType::FP));
+	chart->setSummary(summary);
 
 	return chart;
 }
 
+QVector<ExtraDataHandle> ProjectData::chartSnapshots(ResType dimtype, QStringList& wcnames)
+{
+	QStringList names = wcnames;
+	if (names.isEmpty())
+	{
+		for (const auto& wc : geWorkingConditionsNames(dimtype))
+		{
+			names.append(wc.first);
+		}
+	}
+
+	// 各工况数据驻留并取得只读快照，计算期间即使被淘汰也不会释放
+	QVector<ExtraDataHandle> snapshots;
+	wcnames.clear();
+	for (const auto& wcname : names)
+	{
+		auto sensorsData = ensureResident(dimtype, wcname, QStringList());
+		if (!sensorsData)
+		{
+			qDebug() << "Skipping chart summary of unavailable working condition:" << wcname;
+			continue;
+		}
+		wcnames.append(wcname);
+		snapshots.append(sharedExtraData(sensorsData));
+	}
+	return snapshots;
+}
+
+bool ProjectData::computeChartSummaries(ResType dimtype, const QStringList& wcnames, QMap<QString, ChartSummary>& summaries,
+	const std::function<void(int, int)>& progress)
+{
+	// 1. 各工况数据驻留并取得只读快照
+	QStringList names = wcnames;
+	const QVector<ExtraDataHandle> snapshots = chartSnapshots(dimtype, names);
+	PSDA::WelchConfig welch = welchConfig(dimtype);
+	welch.precision = _displayPrecision;
+
+	// 2. 按工况、分段并行计算
+	QMap<ResType, QMap<QString, ChartSummary>> results;
+	const bool finished = _psdEngine->run(chartJobs(dimtype, names, snapshots, welch), results, progress);
+	summaries = results.value(dimtype);
+	return finished;
+}
+
+QFuture<QMap<QString, ChartSummary>> ProjectData::computeChartSummariesAsync(ResType dimtype, const QStringList& wcnames,
+	const std::function<void(int, int)>& progress)
+{
+	// 1. 驻留与快照修改ProjectData，在调用线程中完成
+	QStringList names = wcnames;
+	const QVector<ExtraDataHandle> snapshots = chartSnapshots(dimtype, names);
+	PSDA::WelchConfig welch = welchConfig(dimtype);
+	welch.precision = _displayPrecision;
+	const QVector<PsdEngine::Job> jobs = chartJobs(dimtype, names, snapshots, welch);
+
+	// 2. 后台只持有引擎、取消标记与快照；取消标记先创建，返回后即可被cancelChartSummaries取消
+	std::shared_ptr<PsdEngine> engine = _psdEngine;
+	PsdEngine::CancelToken token = engine->createCancelToken();
+	return QtConcurrent::run([engine, token, jobs, dimtype, progress]() {
+		QMap<ResType, QMap<QString, ChartSummary>> results;
+		engine->run(jobs, results, progress, token);
+		return results.value(dimtype);
+		});
+}
+
+void ProjectData::cancelChartSummaries()
+{
+	_psdEngine->cancel();
+}
+
+bool ProjectData::computeSpectrogram(ResType dimtype, const QString& wcname, const QString& sensorName, PSDA::Spectrogram& result,
+	int maxColumns)
+{
+	auto sensorsData = ensureResident(dimtype, wcname, QStringList() << sensorName);
+	if (!sensorsData)
+		return false;
+
+	// 持有快照，计算期间数据列即使被淘汰也不会释放
+	const ExtraDataHandle exdata = sharedExtraData(sensorsData);
+	PSDA::WelchConfig welch = welchConfig(dimtype);
+	welch.precision = _displayPrecision;
+	return _psdEngine->spectrogram(exdata->data.value(sensorName), exdata->dataCount, exdata->frequency, welch,
+		maxColumns, result);
+}
+
+QFuture<QMap<QString, PSDA::Spectrogram>> ProjectData::computeSpectrogramsAsync(ResType dimtype, const QString& wcname,
+	const QStringList& sensorNames, int maxColumns)
+{
+	auto sensorsData = ensureResident(dimtype, wcname, sensorNames);
+	const ExtraDataHandle exdata = sensorsData ? sharedExtraData(sensorsData) : ExtraDataHandle();
+	PSDA::WelchConfig welch = welchConfig(dimtype);
+	welch.precision = _displayPrecision;
+
+	std::shared_ptr<PsdEngine> engine = _psdEngine;
+	PsdEngine::CancelToken token = engine->createCancelToken();
+	return QtConcurrent::run([engine, token, exdata, sensorNames, welch, maxColumns]() {
+		// 逐个传感器计算(每个传感器内部按列并行)，整批共用一个取消标记
+		QMap<QString, PSDA::Spectrogram> results;
+		for (const QString& name : sensorNames)
+		{
+			if (!exdata || *token)
+				break;
+			PSDA::Spectrogram spectrogram;
+			if (engine->spectrogram(exdata->data.value(name), exdata->dataCount, exdata->frequency, welch, maxColumns, spectrogram, token))
+				results.insert(name, spectrogram);
+		}
+		return results;
+		});
+}
+
+bool ProjectData::isDynamicWorkingCondition(const QString& wcname) const
+{
+	return _workingConditions.value(wcname).type == 1;
+}
+
 bool ProjectData::hasSegData(ResType dimtype, const QString& wcname)
 {
+	if (_packageIndex.value(dimtype).contains(wcname))
+		return _packageIndex[dimtype][wcname].hasSegData;
 	if (!_analyseDatas.contains(dimtype))
 		return false;
 
@@ -341,17 +526,126 @@ bool ProjectData::hasSegData(ResType dimtype, const QString& wcname)
 	return data[wcname].exData.hasSegData;
 }
 
-ExtraData ProjectData::getExtraData(ResType dimtype, const QString& wcname)
+ExtraDataHandle ProjectData::getExtraData(ResType dimtype, const QString& wcname, bool withSamples/* = true*/)
+{
+	return sharedExtraData(withSamples ? ensureResident(dimtype, wcname, QStringList()) : ensureLoaded(dimtype, wcname));
+}
+
+ExtraDataHandle ProjectData::getExtraData(ResType dimtype, const QString& wcname, const QStringList& sensorNames)
+{
+	// 空列表表示不需要数据，不能当作全部传感器
+	if (sensorNames.isEmpty())
+		return sharedExtraData(ensureLoaded(dimtype, wcname));
+	return sharedExtraData(ensureResident(dimtype, wcname, sensorNames));
+}
+
+SampleColumn ProjectData::getSensorData(ResType dimtype, const QString& wcname, const QString& sensorName)
+{
+	auto data = ensureResident(dimtype, wcname, QStringList() << sensorName);
+	if (!data)
+		return SampleColumn();
+	return data->exData.data.value(sensorName);
+}
+
+bool ProjectData::getWindowStatistics(ResType dimtype, const QString& wcname, const QString& sensorName, qint64 begin, qint64 end, Statistics& stats)
+{
+	auto data = ensureResident(dimtype, wcname, QStringList() << sensorName);
+	if (!data)
+		return false;
+	return windowStatistics(data->exData.data, sensorName, qMax<qint64>(begin, 0), qMin<qint64>(end, data->exData.dataCount), stats);
+}
+
+QVector<QMap<QString, Statistics>> ProjectData::getSegmentStatistics(ResType dimtype, const QString& wcname, int segmentCount)
 {
-	if (_analyseDatas.contains(dimtype))
+	QVector<QMap<QString, Statistics>> result;
+	auto data = ensureLoaded(dimtype, wcname);
+	if (!data || segmentCount < 2 || data->exData.dataCount < segmentCount)
+		return result;
+	const int dataCount = data->exData.dataCount;
+	const auto spans = segmentSpans(dataCount / segmentCount, segmentCount - 1);
+	result.resize(spans.count());
+	// 逐个传感器驻留，统计由索引得到，超出预算时之前的传感器可以被淘汰
+	for (const QString& sensorName : geSensorNames(dimtype, wcname))
 	{
-		const auto& data = _analyseDatas.value(dimtype);
-		if (data.contains(wcname))
+		auto resident = ensureResident(dimtype, wcname, QStringList() << sensorName);
+		if (!resident)
+			continue;
+		for (int i = 0; i < spans.count(); ++i)
 		{
-			return data.value(wcname).exData;
+			Statistics stats;
+			if (windowStatistics(resident->exData.data, sensorName, spans[i].offset, spans[i].offset + spans[i].count, stats))
+				result[i][sensorName] = stats;
 		}
 	}
-	return ExtraData();
+	return result;
+}
+
+void ProjectData::setMemoryBudget(qint64 bytes)
+{
+	_residency.setBudget(bytes);
+	enforceResidencyBudget();
+}
+
+ResidencyManager::Stats ProjectData::getResidencyStats() const
+{
+	return _residency.stats();
+}
+
+void ProjectData::setFloatStorage(bool enable)
+{
+	_floatStorage = enable;
+}
+
+SampleType ProjectData::storagePolicy(ResType dimtype)
+{
+	switch (dimtype)
+	{
+	case ResType::FP:
+	case ResType::GVA:
+	case ResType::GVAExtra:
+	case ResType::GPVA:
+	case ResType::VA13:
+	case ResType::VA15:
+		return SampleType::Float32;
+	default:
+		return SampleType::Float64;
+	}
+}
+
+void ProjectData::setMappedLoading(bool enable)
+{
+	_mappedLoading = enable;
+}
+
+void ProjectData::setCacheEnabled(bool enable)
+{
+	_cacheEnabled = enable;
+}
+
+void ProjectData::setIngestConcurrency(int workers, int ioSlots)
+{
+	_ingestPool.setMaxThreadCount(workers > 0 ? workers : QThread::idealThreadCount());
+	_ingestIoSlots = qBound(1, ioSlots, _ingestPool.maxThreadCount());
+}
+
+void ProjectData::setWelchConfig(ResType dimtype, const PSDA::WelchConfig& config)
+{
+	_welchConfigs[dimtype] = config;
+}
+
+PSDA::WelchConfig ProjectData::welchConfig(ResType dimtype) const
+{
+	return _welchConfigs.value(dimtype, _dimSettings.value(dimtype).welch);
+}
+
+void ProjectData::setDisplayPrecision(PSDA::Precision precision)
+{
+	_displayPrecision = precision;
+}
+
+PSDA::Precision ProjectData::displayPrecision() const
+{
+	return _displayPrecision;
 }
 
 QVector<SensorPositon> ProjectData::getSensorPositions(ResType dimtype)
@@ -380,7 +674,7 @@ QString ProjectData::getSaveDirpath()
 
 bool ProjectData::hasLoadData()
 {
-	return !_analyseDatas.isEmpty();
+	return !_analyseDatas.isEmpty() || !_packageIndex.isEmpty();
 }
 
 QStringList ProjectData::getSegWorkingConditionsNames(const QString& wcname)
@@ -815,6 +1109,38 @@ bool ProjectData::loadAnalyseDataFile(
 )
 {
 	// 1. 读取配置文件
+	DimSettings settings;
+	if (!loadDimSettings(dirPath, settings)) {
+		return false;
+	}
+
+	// 2. 处理目录下的所有MAT文件(并行读取与分段，按文件名顺序合并)
+	QVector<IngestJob> jobs;
+	collectIngestJobs(dirPath, allwcs, settings, type, jobs);
+	auto results = runIngestJobs(jobs);
+
+	// 3. 存储结果
+	for (int i = 0; i < jobs.count(); ++i) {
+		if (!results[i].ok) {
+			continue;
+		}
+		// 创建并配置图表存储结果
+		//if (preGenrateData)
+		//{
+		//	ChartPainter* chart = new ChartPainter(resTitle, resUnit);
+		//	chart->setData(exdata, (type == ResType::Strain || type == ResType::FP));
+		//	analyseData[wcName] = { exdata ,chart };
+		//}
+		//else
+		{
+			analyseData[jobs[i].wcName] = { results[i].exdata ,nullptr };
+		}
+	}
+	return true;
+}
+
+bool ProjectData::loadDimSettings(const QString& dirPath, DimSettings& settings)
+{
 	QFile settingsFile(dirPath + "/settings");
 	if (!settingsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
 		qWarning() << "Failed to open settings file:" << settingsFile.fileName();
@@ -825,59 +1151,480 @@ bool ProjectData::loadAnalyseDataFile(
 	in.setCodec("utf-8");
 
 	// 读取配置文件内容
-	const QStringList sensorNames = in.readLine().split(",");  // 传感器名称列表
-	const QStringList sensorValid = in.readLine().split(",");  // 传感器有效性标记
-	const QStringList segwcnames = in.readLine().split(",");   // 需要分段的工况名称
+	settings.sensorNames = in.readLine().split(",");  // 传感器名称列表
+	settings.sensorValid = in.readLine().split(",");  // 传感器有效性标记
+	settings.segwcnames = in.readLine().split(",");   // 需要分段的工况名称
 	const QStringList valuerange = in.readLine().split(",");   // 极大极小值过滤
+	const QString welch = in.readLine().trimmed();             // 功率谱参数(可选)
 	settingsFile.close();
-	if (sensorNames.isEmpty() || sensorValid.isEmpty() || segwcnames.isEmpty() || valuerange.isEmpty()) {
+	if (settings.sensorNames.isEmpty() || settings.sensorValid.isEmpty() || settings.segwcnames.isEmpty() || valuerange.count() < 2) {
 		qWarning() << "Invalid settings file format";
 		return false;
 	}
 
-	double minValue = valuerange[0].toDouble();
-	double maxValue = valuerange[1].toDouble();
-
-	// 2. 根据资源类型获取相关信息
-	QString resTitle, resUnit;
-	getResTypeInfo(type, resTitle, resUnit);
+	settings.minValue = valuerange[0].toDouble();
+	settings.maxValue = valuerange[1].toDouble();
+	if (!welch.isEmpty() && !PSDA::parseWelchConfig(welch, settings.welch)) {
+		qWarning() << "Invalid Welch config in settings, using defaults:" << welch;
+	}
+	return true;
+}
 
-	// 3. 处理目录下的所有MAT文件
+void ProjectData::collectIngestJobs(
+	const QString& dirPath,
+	const QMap<QString, WorkingConditions>& allwcs,
+	const DimSettings& settings,
+	ResType type,
+	QVector<IngestJob>& jobs
+)
+{
 	QDir resDir(dirPath);
-	const QStringList matFiles = resDir.entryList(QStringList() << "*.mat", QDir::Files);
+	const QStringList matFiles = resDir.entryList(QStringList() << "*.mat", QDir::Files, QDir::Name);
 	for (const QString& matFile : matFiles) {
-		// 3.1 验证工况有效性
+		// 验证工况有效性
 		const QString wcName = QFileInfo(matFile).baseName();
 		if (!allwcs.contains(wcName)) {
 			qDebug() << "Skipping mat file with unmatched working condition:" << matFile;
 			continue;
 		}
-		qDebug() << "Processing mat file:" << resDir.absoluteFilePath(matFile);
+		jobs.append({ type, wcName, resDir.absoluteFilePath(matFile), &settings });
+	}
+}
 
-		// 3.2 读取MAT文件数据
-		ExtraData exdata;
-		exdata.wcname = wcName;
+QVector<ProjectData::IngestResult> ProjectData::runIngestJobs(const QVector<IngestJob>& jobs)
+{
+	QVector<IngestResult> results(jobs.count());
+	IngestResult* out = results.data();
+	const bool mapped = _mappedLoading;
+	const bool cached = _cacheEnabled;
+	// 读取阶段受ioSlots限制，避免多个线程同时随机读盘；分段统计阶段只受线程数限制
+	QSemaphore ioSlots(_ingestIoSlots);
+
+	QVector<QFuture<void>> futures;
+	futures.reserve(jobs.count());
+	for (int i = 0; i < jobs.count(); ++i) {
+		futures.append(QtConcurrent::run(&_ingestPool, [this, &jobs, &ioSlots, out, mapped, cached, i]() {
+			const IngestJob& job = jobs[i];
+			const DimSettings& settings = *job.settings;
+			IngestResult& result = out[i];
+			result.exdata.wcname = job.wcName;
+
+			// 0. 缓存命中时直接映射，跳过解析与统计(区间统计索引随缓存读取)
+			const SampleType storage = storageType(job.type);
+			const QByteArray settingsKey = cacheKey(settings, job.wcName, storage);
+			if (cached && RWMAT::DataCache::load(result.exdata, job.filepath, settingsKey)) {
+				qDebug() << "Loaded data cache for:" << job.filepath;
+				result.ok = true;
+				return;
+			}
+			qDebug() << "Processing mat file:" << job.filepath;
+
+			// 1. 读取MAT文件数据
+			ioSlots.acquire();
+			result.ok = RWMAT::readMatFile(result.exdata, job.filepath, settings.sensorNames, settings.sensorValid,
+				settings.minValue, settings.maxValue, job.type, mapped, storage);
+			ioSlots.release();
+			if (!result.ok) {
+				qWarning() << "Failed to load mat file:" << job.filepath;
+				return;
+			}
+
+			// 2. 建立区间统计索引，处理分段数据（如果需要）
+			buildStatsIndexes(result.exdata.data, result.exdata.dataCount);
+			processSegmentedData(result.exdata, job.wcName, settings.segwcnames, settings.sensorNames, settings.sensorValid);
+
+			// 3. 写入缓存，供下次打开时直接映射
+			if (cached) {
+				ioSlots.acquire();
+				RWMAT::DataCache::save(result.exdata, job.filepath, settingsKey);
+				ioSlots.release();
+			}
+			}));
+	}
+	for (auto& future : futures) {
+		future.waitForFinished();
+	}
+	return results;
+}
+
+SampleType ProjectData::storageType(ResType type) const
+{
+	return _floatStorage ? storagePolicy(type) : SampleType::Float64;
+}
+
+QByteArray ProjectData::cacheKey(const DimSettings& settings, const QString& wcName, SampleType storage)
+{
+	return RWMAT::DataCache::settingsKey(settings.sensorNames, settings.sensorValid,
+		settings.minValue, settings.maxValue, settings.segwcnames.contains(wcName), storage);
+}
+
+QVector<QPair<QString, ResType>> ProjectData::visualResFolders()
+{
+	QVector<QPair<QString, ResType>>resFloderInfo;
+	resFloderInfo.append({ "脉动压力",ResType::FP });
+	resFloderInfo.append({ "主闸振动加速度",ResType::GVA });
+	resFloderInfo.append({ "主闸振动位移",ResType::GVD });
+	resFloderInfo.append({ "#14主闸V11V12振动加速度",ResType::GVAExtra });
+	resFloderInfo.append({ "#14主闸V11V12振动位移",ResType::GVDExtra });
+	resFloderInfo.append({ "闸墩振动加速度",ResType::GPVA });
+	resFloderInfo.append({ "闸墩振动位移",ResType::GPVD });
+	resFloderInfo.append({ "系统油压",ResType::SysOP });
+	resFloderInfo.append({ "启闭机行程",ResType::SysStroke });
+	resFloderInfo.append({ "应力",ResType::Strain });
+	resFloderInfo.append({ "油压",ResType::OP });
+	resFloderInfo.append({ "启闭力",ResType::HC });
+	resFloderInfo.append({ "#13孔洞振动加速度",ResType::VA13 });
+	resFloderInfo.append({ "#13孔洞振动位移",ResType::VD13 });
+	resFloderInfo.append({ "#15孔洞振动加速度",ResType::VA15 });
+	resFloderInfo.append({ "#15孔洞振动位移",ResType::VD15 });
+	return resFloderInfo;
+}
 
-		if (!RWMAT::readMatFile(exdata, resDir.filePath(matFile), sensorNames, sensorValid, minValue, maxValue, type)) {
-			qWarning() << "Failed to load mat file:" << matFile;
+bool ProjectData::buildPackageIndex()
+{
+	_packageIndex.clear();
+	_dimSettings.clear();
+	if (!loadWorkingConditions(getFullPathFromDirByAppointFolder("工况列表", _rootDirPath), _workingConditions))
+	{
+		qDebug() << "Loading working conditions failed.";
+		return false;
+	}
+	for (const auto& folder : visualResFolders())
+	{
+		auto folderFullpath = getFullPathFromDirByAppointFolder(folder.first, _rootDirPath);
+		DimSettings settings;
+		if (!loadDimSettings(folderFullpath, settings))
+		{
+			qDebug() << "Indexing resource data failed. floder:" << folder.first << " file:" << folderFullpath;
 			continue;
 		}
+		// 有效的维度即使没有可用工况也保留(与加载全部数据时一致)
+		const DimSettings& dimSettings = _dimSettings[folder.second] = settings;
+		auto& entries = _packageIndex[folder.second];
+
+		// 只读取MAT文件头(变量维度与SampleFrequency)
+		QVector<IngestJob> jobs;
+		collectIngestJobs(folderFullpath, _workingConditions, dimSettings, folder.second, jobs);
+		for (const auto& job : jobs)
+		{
+			RWMAT::StreamInfo info;
+			if (!RWMAT::readMatHeader(job.filepath, dimSettings.sensorNames, dimSettings.sensorValid, info))
+			{
+				qWarning() << "Failed to read mat header:" << job.filepath;
+				continue;
+			}
+			entries[job.wcName] = { job.filepath, info.sensorNames, info.frequency, info.dataCount, dimSettings.segwcnames.contains(job.wcName) };
+		}
+	}
+	return true;
+}
+
+AnalyseData* ProjectData::ensureLoaded(ResType type, const QString& wcname)
+{
+	auto dim = _analyseDatas.find(type);
+	if (dim != _analyseDatas.end() && dim.value().contains(wcname))
+	{
+		return &dim.value()[wcname];
+	}
+	if (!_packageIndex.value(type).contains(wcname))
+	{
+		return nullptr;
+	}
+	if (openCachedCondition(type, wcname))
+	{
+		return &_analyseDatas[type][wcname];
+	}
 
-		// 3.3 处理分段数据（如果需要）
-		processSegmentedData(exdata, wcName, segwcnames, sensorNames, sensorValid);
+	// 首次访问且没有可用缓存，完整处理该工况(同时写入缓存)
+	QVector<IngestJob> jobs;
+	jobs.append({ type, wcname, _packageIndex[type][wcname].filepath, &_dimSettings[type] });
+	auto results = runIngestJobs(jobs);
+	if (!results[0].ok)
+	{
+		return nullptr;
+	}
+	adoptIngested(type, wcname, results[0].exdata);
+	return &_analyseDatas[type][wcname];
+}
 
-		// 3.4 创建并配置图表存储结果
-		//if (preGenrateData)
-		//{
-		//	ChartPainter* chart = new ChartPainter(resTitle, resUnit);
-		//	chart->setData(exdata, (type == ResType::Strain || type == ResType::FP));
-		//	analyseData[wcName] = { exdata ,chart };
-		//}
-		//else
+bool ProjectData::openCachedCondition(ResType type, const QString& wcname)
+{
+	if (!_cacheEnabled || !_packageIndex.value(type).contains(wcname))
+	{
+		return false;
+	}
+	auto cache = std::make_shared<RWMAT::DataCache::CacheFile>();
+	if (!cache->open(_packageIndex[type][wcname].filepath, cacheKey(_dimSettings[type], wcname, storageType(type))))
+	{
+		return false;
+	}
+	auto& data = _analyseDatas[type][wcname];
+	data = { ExtraData(), nullptr };
+	data.exData.wcname = wcname;
+	cache->fillMetadata(data.exData);
+	_cacheFiles[type][wcname] = cache;
+	return true;
+}
+
+void ProjectData::adoptIngested(ResType type, const QString& wcname, ExtraData& exdata)
+{
+	auto& data = _analyseDatas[type][wcname];
+	data = { exdata, nullptr };
+	data.exData.data.clear();
+	for (const QString& name : exdata.data.names())
+	{
+		adoptColumn(type, wcname, name, exdata, data.exData);
+	}
+
+	// 缓存已在处理时写入，之后被淘汰的列从缓存映射，不必重新解码
+	if (_cacheEnabled)
+	{
+		auto cache = std::make_shared<RWMAT::DataCache::CacheFile>();
+		if (cache->open(_packageIndex.value(type).value(wcname).filepath, cacheKey(_dimSettings[type], wcname, storageType(type))))
+		{
+			_cacheFiles[type][wcname] = cache;
+		}
+	}
+}
+
+void ProjectData::adoptColumn(ResType type, const QString& wcname, const QString& sensorName, const ExtraData& source, ExtraData& target)
+{
+	const int index = source.data.indexOf(sensorName);
+	if (index < 0)
+	{
+		return;
+	}
+	const auto& owner = source.data.owner(index);
+	const auto& statsIndex = source.data.statsIndex(index);
+	const SampleColumn column = source.data.column(index);
+	target.data.insert(sensorName, column, owner, statsIndex);
+	_residency.insert({ type, wcname, sensorName },
+		qint64(source.dataCount) * sampleSize(column.type) + (statsIndex ? statsIndex->bytes() : 0), owner);
+}
+
+bool ProjectData::loadSensorColumns(ResType type, const QString& wcname, const QStringList& sensorNames, ExtraData& exdata)
+{
+	// 1. 从缓存映射各列并读取区间统计索引
+	QStringList missing;
+	auto cache = _cacheFiles.value(type).value(wcname);
+	for (const auto& name : sensorNames)
+	{
+		SampleColumn column;
+		auto owner = cache ? cache->mapColumn(name, column) : nullptr;
+		if (!owner)
+		{
+			missing.append(name);
+			continue;
+		}
+		// 索引读取失败时不建立，区间统计直接扫描窗口
+		auto statsIndex = cache->statsIndex(name);
+		exdata.data.insert(name, column, owner, statsIndex);
+		_residency.insert({ type, wcname, name },
+			qint64(exdata.dataCount) * sampleSize(column.type) + (statsIndex ? statsIndex->bytes() : 0), owner);
+	}
+	if (missing.isEmpty())
+	{
+		return true;
+	}
+
+	// 2. 没有缓存时只解码缺少的传感器(一次读取)
+	if (!_packageIndex.value(type).contains(wcname))
+	{
+		return false;
+	}
+	const DimSettings& settings = _dimSettings[type];
+	QStringList sensorValid = settings.sensorValid;
+	for (int i = 0; i < sensorValid.count(); ++i)
+	{
+		if (i >= settings.sensorNames.count() || !missing.contains(settings.sensorNames[i]))
+			sensorValid[i] = "0";
+	}
+	const QString filepath = _packageIndex[type][wcname].filepath;
+	ExtraData partial;
+	partial.wcname = wcname;
+	if (!RWMAT::readMatFile(partial, filepath, settings.sensorNames, sensorValid,
+		settings.minValue, settings.maxValue, type, _mappedLoading, storageType(type)))
+	{
+		qWarning() << "Failed to load sensors" << missing << "from mat file:" << filepath;
+		return false;
+	}
+	// 分段统计已随工况元数据得到，这里只需要数据列
+	buildStatsIndexes(partial.data, partial.dataCount);
+	for (const QString& name : partial.data.names())
+	{
+		adoptColumn(type, wcname, name, partial, exdata);
+	}
+	return true;
+}
+
+AnalyseData* ProjectData::ensureResident(ResType type, const QString& wcname, const QStringList& sensorNames)
+{
+	// 先开始请求，首次处理加入的数据列同样不会被本次淘汰
+	_residency.beginRequest();
+	auto data = ensureLoaded(type, wcname);
+	if (!data)
+	{
+		return nullptr;
+	}
+	const QStringList names = sensorNames.isEmpty() ? QStringList(data->exData.statistics.keys()) : sensorNames;
+	QStringList missing;
+	for (const auto& name : names)
+	{
+		if (data->exData.statistics.contains(name) && !_residency.access({ type, wcname, name }))
+			missing.append(name);
+	}
+	if (!missing.isEmpty())
+	{
+		loadSensorColumns(type, wcname, missing, data->exData);
+		data->shared.reset();
+	}
+	enforceResidencyBudget();
+	return data;
+}
+
+void ProjectData::enforceResidencyBudget()
+{
+	for (const auto& key : _residency.evict())
+	{
+		auto dim = _analyseDatas.find(key.type);
+		if (dim == _analyseDatas.end() || !dim.value().contains(key.wcname))
+			continue;
+		auto& data = dim.value()[key.wcname];
+		data.exData.data.remove(key.sensorName);
+		data.shared.reset();
+	}
+}
+
+ExtraDataHandle ProjectData::sharedExtraData(AnalyseData* data)
+{
+	if (!data)
+	{
+		static const ExtraDataHandle empty = std::make_shared<const ExtraData>();
+		return empty;
+	}
+	if (!data->shared)
+	{
+		data->shared = std::make_shared<const ExtraData>(data->exData);
+	}
+	return data->shared;
+}
+
+void ProjectData::clearLoadedData()
+{
+	// 数据列的内存由驻留管理持有，随之一起释放
+	for (auto& dim : _analyseDatas)
+	{
+		for (auto& data : dim)
 		{
-			analyseData[wcName] = { exdata ,nullptr };
+			delete data.charts;
+		}
+	}
+	_analyseDatas.clear();
+	_residency.clear();
+	_cacheFiles.clear();
+	_packageIndex.clear();
+	_dimSettings.clear();
+}
+
+bool ProjectData::summarizeAnalyseDataFile(
+	const QString& dirPath,
+	const QMap<QString, WorkingConditions>& allwcs,
+	QMap<QString, AnalyseData>& analyseData,
+	QMap<QString, ChartSummary>& summaries,
+	ResType type
+)
+{
+	// 1. 读取配置文件
+	DimSettings settings;
+	if (!loadDimSettings(dirPath, settings)) {
+		return false;
+	}
+
+	// 2. 逐个文件流式读取(各消费者只保存当前传感器的状态，文件之间串行以保证内存上限)
+	QVector<IngestJob> jobs;
+	collectIngestJobs(dirPath, allwcs, settings, type, jobs);
+	const bool removemean = (type == ResType::Strain || type == ResType::FP);
+	const PSDA::WelchConfig welch = _welchConfigs.value(type, settings.welch);
+	for (const auto& job : jobs) {
+		qDebug() << "Streaming mat file:" << job.filepath;
+		const bool hasSegData = settings.segwcnames.contains(job.wcName);
+
+		// 2.1 组装消费者：全过程统计、分段统计、全过程与各分段的降采样时域曲线和功率谱
+		std::vector<std::unique_ptr<RWMAT::BlockConsumer>> holder;
+		auto make = [&holder](RWMAT::BlockConsumer* consumer) {
+			holder.emplace_back(consumer);
+			return consumer;
+		};
+		// 与ChartPainter::processSensorData一致：功率谱使用去运行均值后的波动数据，时域图按removemean选择
+		auto makeChartPipeline = [&](RWMAT::DownsampleConsumer*& ds, RWMAT::PsdConsumer*& psd) {
+			ds = static_cast<RWMAT::DownsampleConsumer*>(make(new RWMAT::DownsampleConsumer()));
+			psd = static_cast<RWMAT::PsdConsumer*>(make(new RWMAT::PsdConsumer(welch)));
+			if (removemean) {
+				return QVector<RWMAT::BlockConsumer*>{ make(new RWMAT::FluctuationConsumer(1.96, { ds, psd })) };
+			}
+			return QVector<RWMAT::BlockConsumer*>{ ds, make(new RWMAT::FluctuationConsumer(1.96, { psd })) };
+		};
+
+		RWMAT::StatsConsumer stats;
+		RWMAT::SegmentStatsConsumer segStats;
+		QVector<RWMAT::BlockConsumer*> consumers{ &stats };
+		RWMAT::DownsampleConsumer* ds = nullptr;
+		RWMAT::PsdConsumer* psd = nullptr;
+		consumers += makeChartPipeline(ds, psd);
+
+		QVector<RWMAT::DownsampleConsumer*> segDs;
+		QVector<RWMAT::PsdConsumer*> segPsd;
+		if (hasSegData) {
+			consumers.append(&segStats);
+			for (int i = 0; i < SEGMENT_COUNT - 1; ++i) {
+				RWMAT::DownsampleConsumer* sds = nullptr;
+				RWMAT::PsdConsumer* spsd = nullptr;
+				consumers.append(make(new RWMAT::SegmentWindowConsumer(i, makeChartPipeline(sds, spsd))));
+				segDs.append(sds);
+				segPsd.append(spsd);
+			}
 		}
 
+		RWMAT::StreamInfo info;
+		info.wcname = job.wcName;
+		if (!RWMAT::streamMatFile(job.filepath, settings.sensorNames, settings.sensorValid,
+			settings.minValue, settings.maxValue, consumers, info)) {
+			qWarning() << "Failed to stream mat file:" << job.filepath;
+			continue;
+		}
+
+		// 2.2 存储统计结果(不含原始数据)
+		ExtraData exdata;
+		exdata.wcname = job.wcName;
+		exdata.frequency = info.frequency;
+		exdata.dataCount = info.dataCount;
+		exdata.senseCount = info.sensorNames.size();
+		exdata.startTime = QDateTime::currentDateTime();
+		exdata.statistics = stats.statistics();
+		exdata.hasSegData = hasSegData;
+		if (hasSegData && segStats.dataCountEach() > 0) {
+			exdata.dataCountEach = segStats.dataCountEach();
+			exdata.segStatistics = segStats.segStatistics();
+		}
+		analyseData[job.wcName] = { exdata, nullptr };
+
+		// 2.3 存储绘图摘要
+		auto collect = [](const RWMAT::DownsampleConsumer* ds, const RWMAT::PsdConsumer* psd) {
+			QMap<QString, SignalSummary> result = ds->summaries();
+			for (auto iter = result.begin(); iter != result.end(); ++iter) {
+				iter.value().freqs = psd->freqs().value(iter.key());
+				iter.value().pxx = psd->pxx().value(iter.key());
+				PSDA::findPeaks(iter.value().freqs, iter.value().pxx, PSDA::PeakCriteria(), iter.value().peaks);
+			}
+			return result;
+		};
+		ChartSummary& summary = summaries[job.wcName];
+		summary.data = collect(ds, psd);
+		if (!exdata.segStatistics.isEmpty()) {
+			for (int i = 0; i < segDs.count(); ++i) {
+				summary.segData.append(collect(segDs[i], segPsd[i]));
+			}
+		}
 	}
 	return true;
 }
@@ -896,53 +1643,84 @@ void ProjectData::processSegmentedData(
 	}
 
 	const int segmentSize = exdata.dataCount / SEGMENT_COUNT;
-	const int offset = segmentSize / 2;
 	exdata.dataCountEach = segmentSize;
 
-	// 分段处理（总段数-1，因为每段是相邻两段的中间区域）
-	for (int i = 0; i < SEGMENT_COUNT - 1; i++) {
-		QMap<QString, double*> segData;
+	// 分段处理（总段数-1，因为每段是相邻两段的中间区域），分段只是全过程数据中的区间，不拷贝数据
+	exdata.segments = segmentSpans(segmentSize, SEGMENT_COUNT - 1);
+	for (const auto& span : exdata.segments) {
 		QMap<QString, Statistics> segStatistics;
 
 		for (int si = 0; si < sensorNames.size(); ++si) {
-			if (sensorValid[si] != "1") {
+			if (sensorValid[si] != "1" || !exdata.data.contains(sensorNames[si])) {
 				continue;
 			}
 			auto sensorName = sensorNames[si];
-			// 分配内存并复制数据
-			double* data = new double[segmentSize];
-			const int startIdx = i * segmentSize + offset;
-
-			// 初始化统计信息
+			// 有区间统计索引时不重新扫描
 			Statistics stats;
-			stats.max = exdata.data[sensorName][startIdx];
-			stats.min = exdata.data[sensorName][startIdx];
-			stats.rms = 0.0;
-
-			// 处理每个数据点
-			for (int j = 0; j < segmentSize; j++) {
-				const double value = exdata.data[sensorName][startIdx + j];
-				data[j] = value;
-
-				// 更新统计信息
-				stats.max = qMax(stats.max, value);
-				stats.min = qMin(stats.min, value);
-				stats.rms += value * value;
-			}
-
-			// 完成RMS计算
-			stats.rms = sqrt(stats.rms / segmentSize);
+			windowStatistics(exdata.data, sensorName, span.offset, span.offset + span.count, stats);
 
 			// 存储结果
-			segData[sensorName] = data;
 			segStatistics[sensorName] = stats;
 		}
 
-		exdata.segData.append(segData);
 		exdata.segStatistics.append(segStatistics);
 	}
 }
 
+QMap<QString, CoherenceMatrix> ProjectData::reportCoherences(
+	const QString& dirPath,
+	const QMap<QString, WorkingConditions>& allwcs,
+	ResType type
+)
+{
+	QMap<QString, CoherenceMatrix> result;
+	DimSettings settings;
+	if (!loadDimSettings(dirPath, settings)) {
+		return result;
+	}
+	QVector<IngestJob> jobs;
+	collectIngestJobs(dirPath, allwcs, settings, type, jobs);
+	const PSDA::WelchConfig welch = _welchConfigs.value(type, settings.welch);
+	for (const auto& job : jobs) {
+		// 1. 只读取该工况的数据(可映射时不拷贝)，不写缓存、不加入驻留管理，离开作用域即释放
+		RawData exdata;
+		exdata.wcname = job.wcName;
+		if (!RWMAT::readMatFile(exdata, job.filepath, settings.sensorNames, settings.sensorValid,
+			settings.minValue, settings.maxValue, type, _mappedLoading)) {
+			qWarning() << "Failed to read mat file for coherence:" << job.filepath;
+			continue;
+		}
+		CoherenceMatrix coherence;
+		coherence.sensorNames = exdata.data.names();
+		std::sort(coherence.sensorNames.begin(), coherence.sensorNames.end(), &numericCompare);
+		const int n = coherence.sensorNames.count();
+		if (n < 2) {
+			continue;
+		}
+		QVector<SampleColumn> columns;
+		for (const QString& name : coherence.sensorNames) {
+			columns.append(exdata.data.value(name));
+		}
+
+		// 2. 互谱只保留相干系数矩阵；直流分量与zeroBins置零的低频频点不计入平均(见CrossSpectra::meanCoherence)
+		PSDA::CrossSpectra spectra;
+		if (!_psdEngine->crossSpectra(columns, exdata.dataCount, exdata.frequency, welch, spectra) || spectra.freqs.count() < 2) {
+			qDebug() << "Skipping coherence of working condition:" << job.wcName;
+			continue;
+		}
+		const double minFreq = spectra.freqs[qBound(1, welch.zeroBins, spectra.freqs.count() - 1)];
+		const double maxFreq = spectra.freqs.last();
+		coherence.values.resize(n * n);
+		for (int a = 0; a < n; ++a) {
+			for (int b = 0; b < n; ++b) {
+				coherence.values[a * n + b] = spectra.meanCoherence(a, b, minFreq, maxFreq);
+			}
+		}
+		result[job.wcName] = coherence;
+	}
+	return result;
+}
+
 bool ProjectData::saveAnalyseDataToDocx(
 	QAxObject* doc,
 	QAxObject* selection,
@@ -951,7 +1729,9 @@ bool ProjectData::saveAnalyseDataToDocx(
 	const QString& unit,
 	ResType type,
 	const QMap<QString, WorkingConditions>& wcs,
-	QMap<QString, AnalyseData>& analyseData
+	QMap<QString, AnalyseData>& analyseData,
+	const QMap<QString, ChartSummary>* summaries,
+	const QMap<QString, CoherenceMatrix>* coherences
 )
 {
 	if (analyseData.isEmpty())
@@ -968,6 +1748,22 @@ bool ProjectData::saveAnalyseDataToDocx(
 	selection->dynamicCall("TypeParagraph()");
 
 
+	// 没有流式读取的摘要时，先并行计算全部工况的摘要
+	QMap<QString, ChartSummary> computedSummaries;
+	if (!summaries)
+	{
+		QVector<PsdEngine::Job> jobs;
+		const PSDA::WelchConfig welch = welchConfig(type);
+		for (auto iter = analyseData.begin(); iter != analyseData.end(); ++iter)
+		{
+			jobs.append({ type, iter.key(), sharedExtraData(&iter.value()), (type == ResType::Strain || type == ResType::FP), welch });
+		}
+		QMap<ResType, QMap<QString, ChartSummary>> results;
+		_psdEngine->run(jobs, results);
+		computedSummaries = results.value(type);
+		summaries = &computedSummaries;
+	}
+
 	QStringList sensorsName;
 	WorkingConditionsList dataWcs;
 	QStringList dataWcNames = analyseData.keys();
@@ -1005,13 +1801,15 @@ bool ProjectData::saveAnalyseDataToDocx(
 			for (int i = 0; i < dataWcNames.count(); i++)
 			{
 				const auto& fps = analyseData[dataWcNames[i]].exData.statistics;
+				const ChartSummary wcSummary = summaries->value(dataWcNames[i]);
 				for (int j = 0; j < tempSN.count(); j++)
 				{
 					auto sensorname = tempSN[j];
 					auto stats = fps[sensorname];
-					fillTableDataCell(table, 3 + i * 3 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
-					fillTableDataCell(table, 3 + i * 3 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
-					fillTableDataCell(table, 3 + i * 3 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+					fillTableDataCell(table, 3 + i * 4 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
+					fillTableDataCell(table, 3 + i * 4 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
+					fillTableDataCell(table, 3 + i * 4 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+					fillTableDataCell(table, 3 + i * 4 + 3, 3 + j, dominantFrequencyText(wcSummary.data, sensorname), true);
 				}
 			}
 			skipTable(selection);
@@ -1027,13 +1825,15 @@ bool ProjectData::saveAnalyseDataToDocx(
 		for (int i = 0; i < dataWcNames.count(); i++)
 		{
 			const auto& fps = analyseData[dataWcNames[i]].exData.statistics;
+			const ChartSummary wcSummary = summaries->value(dataWcNames[i]);
 			for (int j = 0; j < sensorsName.count(); j++)
 			{
 				auto sensorname = sensorsName[j];
 				auto stats = fps[sensorname];
-				fillTableDataCell(table, 3 + i * 3 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
-				fillTableDataCell(table, 3 + i * 3 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
-				fillTableDataCell(table, 3 + i * 3 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+				fillTableDataCell(table, 3 + i * 4 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
+				fillTableDataCell(table, 3 + i * 4 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
+				fillTableDataCell(table, 3 + i * 4 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+				fillTableDataCell(table, 3 + i * 4 + 3, 3 + j, dominantFrequencyText(wcSummary.data, sensorname), true);
 			}
 		}
 		skipTable(selection);
@@ -1058,7 +1858,14 @@ bool ProjectData::saveAnalyseDataToDocx(
 		getResTypeInfo(type, resTitle, resUnit);
 
 		ChartPainter* chart = new ChartPainter(resTitle, resUnit);
-		chart->setData(analyseData[dataWcNames[i]].exData, (type == ResType::Strain || type == ResType::FP));
+		if (summaries && summaries->contains(dataWcNames[i]))
+		{
+			chart->setSummary(summaries->value(dataWcNames[i]));
+		}
+		else
+		{
+			chart->setData(analyseData[dataWcNames[i]].exData, (type == ResType::Strain || type == ResType::FP), welchConfig(type));
+		}
 		chart->save(exportRootPath, 450, 170);
 		chart->saveSeg(exportRootPath, 450, 170);
 
@@ -1082,6 +1889,11 @@ bool ProjectData::saveAnalyseDataToDocx(
 			setNormalSelectionStyle(selection, ParagraphFormat::ChartCaption);
 			addCaption(selection, "时域/频谱分析-" + sensorsName[j], false);
 		}
+
+		if (coherences && coherences->contains(dataWcNames[i]))
+		{
+			addCoherenceTables(doc, selection, titlename, wcdesp, coherences->value(dataWcNames[i]));
+		}
 	}
 
 	if (!dataWcs.count())
@@ -1133,15 +1945,17 @@ bool ProjectData::saveAnalyseDataToDocx(
 				addCaption(selection, titlename + "特征值-" + wcdsp, true);
 				auto segtable = createSegEigenvalueTable(doc, selection, dataWcs[i], wcsSeg, tempSN);
 				const auto& fpsegs = analyseData[dataWcs[i].name].exData.segStatistics;
+				const auto segSummaries = summaries->value(dataWcs[i].name).segData;
 				for (int j = 0; j < tempSN.count(); j++)
 				{
 					auto sn = tempSN[j];
 					for (auto k = 0; k < fpsegs.count(); k++)
 					{
 						auto stats = fpsegs[k][sn];
-						fillTableDataCell(segtable, 3 + k * 3 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
-						fillTableDataCell(segtable, 3 + k * 3 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
-						fillTableDataCell(segtable, 3 + k * 3 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+						fillTableDataCell(segtable, 3 + k * 4 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
+						fillTableDataCell(segtable, 3 + k * 4 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
+						fillTableDataCell(segtable, 3 + k * 4 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+						fillTableDataCell(segtable, 3 + k * 4 + 3, 3 + j, dominantFrequencyText(segSummaries.value(k), sn), true);
 						sensorMaxValue[sn].push_back(stats.max);
 						sensorMinValue[sn].push_back(stats.min);
 						sensorRmsValue[sn].push_back(stats.rms);
@@ -1157,15 +1971,17 @@ bool ProjectData::saveAnalyseDataToDocx(
 			auto segtable = createSegEigenvalueTable(doc, selection, dataWcs[i], wcsSeg, sensorsName);
 
 			const auto& fpsegs = analyseData[dataWcs[i].name].exData.segStatistics;
+			const auto segSummaries = summaries->value(dataWcs[i].name).segData;
 			for (int j = 0; j < sensorsName.count(); j++)
 			{
 				auto sn = sensorsName[j];
 				for (auto k = 0; k < fpsegs.count(); k++)
 				{
 					auto stats = fpsegs[k][sn];
-					fillTableDataCell(segtable, 3 + k * 3 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
-					fillTableDataCell(segtable, 3 + k * 3 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
-					fillTableDataCell(segtable, 3 + k * 3 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+					fillTableDataCell(segtable, 3 + k * 4 + 0, 3 + j, QString::number(stats.max, 'f', 2), true);
+					fillTableDataCell(segtable, 3 + k * 4 + 1, 3 + j, QString::number(stats.min, 'f', 2), true);
+					fillTableDataCell(segtable, 3 + k * 4 + 2, 3 + j, QString::number(stats.rms, 'f', 2), true);
+					fillTableDataCell(segtable, 3 + k * 4 + 3, 3 + j, dominantFrequencyText(segSummaries.value(k), sn), true);
 					sensorMaxValue[sn].push_back(stats.max);
 					sensorMinValue[sn].push_back(stats.min);
 					sensorRmsValue[sn].push_back(stats.rms);
@@ -1242,38 +2058,6 @@ QString ProjectData::getFullPathFromDirByAppointFolder(const QString& foldername
 	return QString();
 }
 
-void ProjectData::clearExtraData(ExtraData& extra)
-{
-	// 1. 清理 RawData 部分的 data 成员（double* 数组）
-	for (auto it = extra.data.begin(); it != extra.data.end(); ++it) {
-		delete[] it.value(); // 删除每个传感器对应的 double 数组
-	}
-	extra.data.clear();
-
-	// 2. 清理 statistics (QMap<QString, Statistics> 不需要特殊清理)
-	extra.statistics.clear();
-
-	// 3. 清理 segData 中的 double* 数组
-	for (auto& segMap : extra.segData) {
-		for (auto it = segMap.begin(); it != segMap.end(); ++it) {
-			delete[] it.value(); // 删除分段数据中的 double 数组
-		}
-		segMap.clear();
-	}
-	extra.segData.clear();
-
-	// 4. 清理 segStatistics (QMap<QString, Statistics> 不需要特殊清理)
-	extra.segStatistics.clear();
-
-	// 5. 重置其他成员
-	extra.wcname.clear();
-	extra.frequency = 100;
-	extra.senseCount = 0;
-	extra.dataCount = 0;
-	extra.dataCountEach = 0;
-	extra.hasSegData = false;
-}
-
 void ProjectData::setNormalSelectionStyle(QAxObject* selection, ParagraphFormat pf)
 {
 	QScopedPointer<QAxObject> paragraphFormat(selection->querySubObject("ParagraphFormat"));
@@ -1364,7 +2148,7 @@ void ProjectData::addCaption(QAxObject* selection, const QString& text, bool isT
 QAxObject* ProjectData::createEigenvalueTable(QAxObject* doc, QAxObject* selection, WorkingConditionsList wcs, const QStringList& sensorsNames)
 {
 	int cols = sensorsNames.count() + 2;
-	int rows = wcs.count() * 3 + 2;
+	int rows = wcs.count() * 4 + 2;
 
 	QAxObject* tables(doc->querySubObject("Tables"));
 	QAxObject* table = tables->querySubObject("Add(Range*, int, int,QVariant,QVariant)"
@@ -1391,16 +2175,18 @@ QAxObject* ProjectData::createEigenvalueTable(QAxObject* doc, QAxObject* selecti
 	//填充工况
 	for (int i = 0; i < wcs.count(); i++)
 	{
-		fillTableHeaderCell(table, 3 + i * 3, 1, wcs[i].description);
+		fillTableHeaderCell(table, 3 + i * 4, 1, wcs[i].description);
 
-		fillTableHeaderCell(table, 3 + i * 3, 2, "max");
-		fillTableHeaderCell(table, 3 + i * 3 + 1, 2, "min");
-		fillTableHeaderCell(table, 3 + i * 3 + 2, 2, "σ");
+		fillTableHeaderCell(table, 3 + i * 4, 2, "max");
+		fillTableHeaderCell(table, 3 + i * 4 + 1, 2, "min");
+		fillTableHeaderCell(table, 3 + i * 4 + 2, 2, "σ");
+		fillTableHeaderCell(table, 3 + i * 4 + 3, 2, "主频(Hz)");
 	}
 	for (int i = 0; i < wcs.count(); i++)
 	{
-		mergeCells(table, 3 + i * 3, 1, 3 + i * 3 + 1, 1);
-		mergeCells(table, 3 + i * 3, 1, 3 + i * 3 + 2, 1);
+		mergeCells(table, 3 + i * 4, 1, 3 + i * 4 + 1, 1);
+		mergeCells(table, 3 + i * 4, 1, 3 + i * 4 + 2, 1);
+		mergeCells(table, 3 + i * 4, 1, 3 + i * 4 + 3, 1);
 	}
 
 	return table;
@@ -1427,6 +2213,60 @@ QAxObject* ProjectData::createSegEigenvalueTable(QAxObject* doc, QAxObject* sele
 	return createEigenvalueTable(doc, selection, wcsTemp, sensorsNames);
 }
 
+QAxObject* ProjectData::createCoherenceTable(QAxObject* doc, QAxObject* selection, const QStringList& rowNames, const QStringList& colNames)
+{
+	QAxObject* tables(doc->querySubObject("Tables"));
+	QAxObject* table = tables->querySubObject("Add(Range*, int, int,QVariant,QVariant)"
+		, selection->querySubObject("Range")->asVariant(), rowNames.count() + 1, colNames.count() + 1, "1", "2");
+
+	fillTableHeaderCell(table, 1, 1, "测点");
+	for (auto i = 0; i < colNames.count(); i++)
+	{
+		fillTableHeaderCell(table, 1, 2 + i, colNames[i]);
+	}
+	for (auto i = 0; i < rowNames.count(); i++)
+	{
+		fillTableHeaderCell(table, 2 + i, 1, rowNames[i]);
+	}
+	return table;
+}
+
+void ProjectData::addCoherenceTables(QAxObject* doc, QAxObject* selection, const QString& titlename, const QString& wcdesp,
+	const CoherenceMatrix& coherence)
+{
+	const QStringList& sensorsNames = coherence.sensorNames;
+	const int n = sensorsNames.count();
+	if (n < 2 || coherence.values.count() != n * n)
+		return;
+
+	// 与特征值表一致：测点超过9个时每6个测点(列)一张表
+	const int step = n > 9 ? 6 : n;
+	for (int start = 0; start < n; start += step)
+	{
+		const QStringList colNames = sensorsNames.mid(start, step);
+		setNormalSelectionStyle(selection, ParagraphFormat::ChartCaption);
+		addCaption(selection, titlename + "测点间平均相干系数-" + wcdesp, true);
+		auto table = createCoherenceTable(doc, selection, sensorsNames, colNames);
+		for (int r = 0; r < n; r++)
+		{
+			for (int c = 0; c < colNames.count(); c++)
+			{
+				fillTableDataCell(table, 2 + r, 2 + c, QString::number(coherence.values[r * n + start + c], 'f', 2), true);
+			}
+		}
+		skipTable(selection);
+	}
+}
+
+QString ProjectData::dominantFrequencyText(const QMap<QString, SignalSummary>& data, const QString& sensorName)
+{
+	// 峰值在分析时已按功率从大到小求出，第一个即为主频
+	const auto iter = data.constFind(sensorName);
+	if (iter == data.constEnd() || iter.value().peaks.isEmpty())
+		return "-";
+	return QString::number(iter.value().peaks.first().frequency, 'f', 2);
+}
+
 void ProjectData::fillTableDataCell(QAxObject* table, int row, int col, const QString& text, bool centerAlign)
 {
 	QScopedPointer<QAxObject> cell(table->querySubObject("Cell(int, int)", row, col));
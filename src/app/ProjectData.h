@@ -1,13 +1,24 @@
 #pragma once
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include <QDateTime>
+#include <QFuture>
 #include <QMap>
 #include <QVector>
 #include <QObject>
 #include <qaxobject.h>
 #include <QString>
 #include <QDir>
+#include <QThreadPool>
+
+#include "ResidencyManager.h"
+#include "SampleBlock.h"
+#include "Statistics.h"
+#include "charts/SpectralPeaks.h"
+#include "charts/WelchConfig.h"
 
 //工况数据解析存储结构
 #define WORKING_CONDITIONS_LINE_COUNT 10
@@ -28,11 +39,6 @@ struct WorkingConditions
 typedef QList<WorkingConditions> WorkingConditionsList;
 
 //原始数据解析存储结构（含初步的统计计算）
-struct Statistics {
-	double max{ 0.0 };//最大值
-	double min{ 0.0 };//最小值
-	double rms{ 0.0 };//均方根
-};
 struct RawData
 {
 	QString wcname{ "" };					//从属于的工况名称
@@ -40,29 +46,87 @@ struct RawData
 	int senseCount{ 0 };					//传感器数量
 	int dataCount{ 0 };						//数据点数量
 	QDateTime startTime{};					//开始时间(绝对时间)
-	QMap<QString, double*>data{};			//原始数据<传感器编号，数值>
+	SampleTable data{};						//原始数据<传感器编号，数值>，内存随最后一个引用释放
 	QMap<QString, Statistics>statistics{};	//统计数据<传感器编号，数值>
 	bool hasSegData{ false };				//是否存在时序分割数据
 };
 //数据分段数量，将会有9个中间数据点，数据点前后各0.5*num个数量的数据进行重分析与统计
 #define SEGMENT_COUNT 10
+//传感器数据常驻内存预算的应用配置项(MB)及其默认值
+#define MEMORY_BUDGET_KEY "Data/MemoryBudgetMB"
+#define DEFAULT_MEMORY_BUDGET_MB 4096
+//是否按维度以float存储采样数据的应用配置项(见ProjectData::setFloatStorage)，默认关闭
+#define FLOAT_STORAGE_KEY "Data/FloatStorage"
+//分段区间，为全过程数据列中的连续区间，所有传感器共用
+struct SegmentSpan
+{
+	int offset{ 0 };	//起点在全过程数据中的下标
+	int count{ 0 };		//数据点数量
+};
+//第i段从i*dataCountEach + dataCountEach/2开始(每段位于相邻两段的中间)
+inline QVector<SegmentSpan> segmentSpans(int dataCountEach, int segmentCount)
+{
+	QVector<SegmentSpan> spans;
+	for (int i = 0; i < segmentCount; ++i)
+	{
+		spans.append({ i * dataCountEach + dataCountEach / 2, dataCountEach });
+	}
+	return spans;
+}
 struct ExtraData :public RawData
 {
 	int dataCountEach{ 0 };						//数据点数量
-	QVector<QMap<QString, double*>>segData{};
+	QVector<SegmentSpan>segments{};				//分段区间(不拷贝数据)
 	QVector<QMap<QString, Statistics>>segStatistics{};
+
+	//第i段中传感器的数据，传感器未驻留时返回空视图
+	SampleColumn segmentData(int i, const QString& sensorName) const
+	{
+		return data.value(sensorName).mid(segments[i].offset);
+	}
+};
+//只读共享的工况数据，复制只增加引用计数；持有期间其中的数据列不会被释放(即使已被淘汰)
+typedef std::shared_ptr<const ExtraData> ExtraDataHandle;
+
+//不保留原始数据时(流式读取)用于绘图的摘要：降采样后的时域曲线与功率谱
+struct SignalSummary
+{
+	QVector<double> times{};	//时域曲线横轴(s)
+	QVector<double> values{};	//时域曲线纵轴
+	double duration{ 0.0 };		//最后一个数据点的时间(s)
+	double min{ 0.0 };			//时域最小值
+	double max{ 0.0 };			//时域最大值
+	QVector<double> freqs{};	//频率(Hz)
+	QVector<double> pxx{};		//功率谱密度
+	QVector<PSDA::SpectralPeak> peaks{};	//功率谱峰值，按功率从大到小排列，第一个为主频
+};
+struct ChartSummary
+{
+	QMap<QString, SignalSummary> data{};				//全过程<传感器编号，摘要>
+	QVector<QMap<QString, SignalSummary>> segData{};	//分段
+};
+//工况各测点两两之间在分析频带内的平均相干系数(报告中的相干系数表)
+struct CoherenceMatrix
+{
+	QStringList sensorNames{};	//测点顺序
+	QVector<double> values{};	//values[a * n + b]为测点a与b的平均相干系数
 };
 
 enum class ResType { FP, GVA, GVD, GVAExtra, GVDExtra, GPVA, GPVD, Strain, OP, SysOP, SysStroke, HC, VA13, VD13, VA15, VD15 };
 Q_DECLARE_METATYPE(ResType);
 
 class ChartPainter;
+class PsdEngine;
 class FPChart;
+namespace RWMAT { namespace DataCache { class CacheFile; }; };
+namespace PSDA { struct Spectrogram; struct CrossSpectra; };
 
+// exData中的统计信息常驻，data只含当前驻留的传感器
 struct AnalyseData
 {
 	ExtraData exData;
 	ChartPainter* charts;
+	ExtraDataHandle shared{};	//exData的只读快照，exData变化时重置，下次获取时重新生成
 };
 
 struct SensorPositon {
@@ -88,6 +152,41 @@ private:
 	QMap<ResType, QMap<QString, AnalyseData>> _analyseDatas;
 	QMap<ResType, QVector<SensorPositon>> _sensorPostions;
 
+	bool _mappedLoading{ true };
+	bool _cacheEnabled{ true };	//是否使用.svcache二进制缓存
+	bool _floatStorage{ false };	//是否按storagePolicy以float存储采样数据
+
+	QThreadPool _ingestPool{};	//数据加载专用线程池
+	std::shared_ptr<PsdEngine> _psdEngine;	//绘图摘要(功率谱)的并行计算，异步计算持有引用直到结束
+	int _ingestIoSlots{ 2 };	//同时读取MAT文件的任务数上限
+
+	// 单个维度文件夹的settings配置
+	struct DimSettings
+	{
+		QStringList sensorNames{};	// 传感器名称列表
+		QStringList sensorValid{};	// 传感器有效性标记
+		QStringList segwcnames{};	// 需要分段的工况名称
+		double minValue{ 0.0 };		// 极小值过滤
+		double maxValue{ 0.0 };		// 极大值过滤
+		PSDA::WelchConfig welch{};	// 功率谱参数(可选的第5行，缺省时与原先固定参数一致)
+	};
+	// 数据包索引中的一个工况(只来自MAT文件头)
+	struct IndexEntry
+	{
+		QString filepath{};			// MAT文件路径
+		QStringList sensorNames{};	// 有效传感器
+		int frequency{ 100 };		// 采集频率
+		int dataCount{ 0 };			// 裁剪后的数据点数量
+		bool hasSegData{ false };	// 是否需要分段
+	};
+	QMap<ResType, DimSettings> _dimSettings;					//各维度settings，加载任务引用其中的元素
+	QMap<ResType, PSDA::WelchConfig> _welchConfigs;			//通过setWelchConfig覆盖的各维度功率谱参数
+	PSDA::Precision _displayPrecision{ PSDA::Precision::Float };	//界面显示的功率谱与时频谱的FFT精度
+	QMap<ResType, QMap<QString, IndexEntry>> _packageIndex;	//数据包索引<维度，<工况名，索引>>
+
+	ResidencyManager _residency;	//传感器数据的驻留管理，超出预算时淘汰最久未使用的数据列
+	QMap<ResType, QMap<QString, std::shared_ptr<RWMAT::DataCache::CacheFile>>> _cacheFiles;	//已校验的缓存文件，用于按列重新映射
+
 public:
 	ProjectData(QObject* parent = nullptr);
 	~ProjectData();
@@ -96,12 +195,14 @@ public:
 	// dirPath:	给入原始数据包的文件夹，这个文件夹应该包含"工况列表"、"应力"等Mat数据文件夹
 	// savePath:给入希望保存到的文件夹路径，必须是文件夹
 	// saveBackground:	是否保存
+	// 不保存时会建立数据包索引(只读取工况列表、各维度settings与MAT文件头)，维度、工况、传感器列表立即可查，
+	// 原始数据在首次通过getExtraData/getCharts访问时才加载
 	bool setDataPackage(const QString& dirPath, const QString& savePath = QString(), bool save = false);
 
 	// 必须后于setDataPackage执行，内部执行相应数据的读取、处理、存储操作
-	// 额外注意点，这个接口是为了可视化的逻辑而准备的，会一次性把所有数据与处理好数据都加载到内存里
-	// 以便快速查看，通常会达到几个G的占用，源数据文件越大，占用越多，会有个极限，暂时没有测出来
-	// Tips：优化方案也有，暂时没时间改了，希望将saveBackground逻辑都合并起来
+	// 额外注意点，这个接口是为了可视化的逻辑而准备的，会一次性把所有工况都处理一遍(未命中缓存的工况写入缓存)
+	// 常驻内存受setMemoryBudget限制，超出预算的数据列会被淘汰，再次访问时从缓存映射或重新解码
+	// 已建立索引时可以不调用，数据会在访问时按工况逐个加载
 	bool loadForVisual();
 
 	// 必须后于setDataPackage执行，内部执行相应数据的读取、处理、存储操作
@@ -120,12 +221,78 @@ public:
 	QVector<QPair<QString, bool>> geWorkingConditionsNames(ResType dimtype);
 	//通过枚举量以及工况名，获取当前状态全部传感器的名字列表
 	QStringList geSensorNames(ResType dimtype, const QString& wcname);
-	//通过枚举量以及工况名，获取当前状态全部传感器的绘图
+	//通过枚举量以及工况名，获取当前状态全部传感器的绘图(阻塞直到功率谱计算完成，界面中使用computeChartSummariesAsync)
 	ChartPainter* getCharts(ResType dimtype, const QString& wcname);
+	//由绘图摘要创建维度的绘图(标题与单位取自维度)，须在界面线程调用
+	ChartPainter* createCharts(ResType dimtype, const ChartSummary& summary);
 	//通过枚举量以及工况名，获取当前工况有没有分断数据
 	bool hasSegData(ResType dimtype, const QString& wcname);
+	// 并行计算维度下各工况的绘图摘要(时域曲线与全过程、分段的功率谱，FFT精度为displayPrecision)，wcnames为空时计算全部工况
+	// 计算期间涉及的工况数据全部驻留；progress(finished, total)在工作线程中调用
+	// 被取消时返回false，summaries只含已全部完成的工况
+	bool computeChartSummaries(ResType dimtype, const QStringList& wcnames, QMap<QString, ChartSummary>& summaries,
+		const std::function<void(int, int)>& progress = std::function<void(int, int)>());
+	// 同computeChartSummaries，但不阻塞：数据驻留与快照在调用线程(界面线程)中完成，功率谱在后台计算，结果为summaries
+	// 可用QFutureWatcher在完成时绘图(createCharts)；被取消时结果只含已全部完成的工况
+	QFuture<QMap<QString, ChartSummary>> computeChartSummariesAsync(ResType dimtype, const QStringList& wcnames,
+		const std::function<void(int, int)>& progress = std::function<void(int, int)>());
+	// 取消所有正在进行的绘图摘要、时频谱与互谱计算(含异步计算)，可在任意线程调用；之后开始的计算不受影响
+	void cancelChartSummaries();
+	// 单个传感器全过程的时频谱(用于查看动态实验中频谱随时间的变化)，只加载该传感器，按帧并行计算
+	// maxColumns为时间轴最多列数，超过时相邻帧合并；被取消或数据不足时返回false
+	bool computeSpectrogram(ResType dimtype, const QString& wcname, const QString& sensorName, PSDA::Spectrogram& result,
+		int maxColumns = 1000);
+	// 同computeSpectrogram，但不阻塞：在后台逐个计算sensorNames的时频谱，结果只含计算成功的传感器，被取消时不再开始下一个
+	QFuture<QMap<QString, PSDA::Spectrogram>> computeSpectrogramsAsync(ResType dimtype, const QString& wcname,
+		const QStringList& sensorNames, int maxColumns = 1000);
+	// 工况是否为动态实验(工况列表中的实验类型为1)
+	bool isDynamicWorkingCondition(const QString& wcname) const;
+
+	// 获取工况数据的只读句柄，数据未变化时多次获取返回同一个快照(O(1)，不复制容器)；工况不存在时返回空数据
+	// withSamples为false时只保证统计信息等元数据，data只含当前已驻留的传感器，不触发加载
+	ExtraDataHandle getExtraData(ResType dimtype, const QString& wcname, bool withSamples = true);
+	// 同上，只保证sensorNames中的传感器驻留
+	ExtraDataHandle getExtraData(ResType dimtype, const QString& wcname, const QStringList& sensorNames);
+	// 获取单个传感器的全过程数据，只加载该传感器；在下一次获取数据之前有效(之后可能被淘汰)
+	SampleColumn getSensorData(ResType dimtype, const QString& wcname, const QString& sensorName);
+	// 单个传感器在数据点[begin, end)范围内的统计信息，只加载该传感器；由区间统计索引得到，不重新扫描整个范围
+	bool getWindowStatistics(ResType dimtype, const QString& wcname, const QString& sensorName, qint64 begin, qint64 end, Statistics& stats);
+	// 按segmentCount重新分段的统计信息(分段方式与SEGMENT_COUNT一致：segmentCount-1段，每段位于相邻两段的中间)
+	QVector<QMap<QString, Statistics>> getSegmentStatistics(ResType dimtype, const QString& wcname, int segmentCount);
+
+	// 传感器数据常驻内存的预算(字节)，<=0表示不限制；构造时取应用配置MEMORY_BUDGET_KEY(默认DEFAULT_MEMORY_BUDGET_MB)
+	// 超出预算时淘汰最久未使用的传感器数据列(含分段数据)，一次访问所需的数据不受预算限制
+	void setMemoryBudget(qint64 bytes);
+	// 驻留统计：命中率、当前驻留字节数、淘汰次数
+	ResidencyManager::Stats getResidencyStats() const;
 
-	ExtraData getExtraData(ResType dimtype, const QString& wcname);
+	// 是否以内存映射方式加载未压缩的MAT数据(默认开启)，须在加载数据前设置
+	// 开启后未越界的传感器数据直接指向文件映射区，不再拷贝，常驻内存只与实际访问的数据量相关
+	void setMappedLoading(bool enable);
+
+	// 是否按维度以float存储采样数据，须在加载数据前设置；构造时取应用配置FLOAT_STORAGE_KEY(默认关闭)
+	// 开启后storagePolicy为Float32的维度内存减半，统计与功率谱仍以double累加
+	void setFloatStorage(bool enable);
+	// 各维度开启float存储时的存储精度：脉动压力、振动加速度为Float32，
+	// 位移等需要积分精度的维度以及其他维度保持Float64
+	static SampleType storagePolicy(ResType dimtype);
+
+	// 是否使用处理结果缓存(默认开启)，须在加载数据前设置
+	// 开启后每个工况MAT文件处理完成后写入"<维度文件夹>/.svcache/"，源文件与settings未变化时下次直接映射缓存，跳过解析与统计
+	void setCacheEnabled(bool enable);
+
+	// 并行加载配置，须在加载数据前设置
+	// workers:	工作线程数，<=0时取CPU逻辑核数
+	// ioSlots:	同时读取文件的任务数上限(读取之后的分段统计不受限制)，机械盘建议1~2，固态盘可与workers相同
+	void setIngestConcurrency(int workers, int ioSlots);
+
+	// 维度的功率谱参数(窗函数、分段、去趋势、平均方式等)，覆盖settings第5行的配置，之后计算的绘图摘要与报告生效
+	void setWelchConfig(ResType dimtype, const PSDA::WelchConfig& config);
+	// 维度当前使用的功率谱参数：setWelchConfig设置的值，否则为settings中的配置
+	PSDA::WelchConfig welchConfig(ResType dimtype) const;
+	// 界面显示(getCharts/computeChartSummaries/computeSpectrogram)的FFT精度，默认单精度；报告与互谱始终为双精度
+	void setDisplayPrecision(PSDA::Precision precision);
+	PSDA::Precision displayPrecision() const;
 
 	QVector<SensorPositon> getSensorPositions(ResType dimtype);
 
@@ -160,6 +327,62 @@ private:
 		const QMap<QString, WorkingConditions>& wcs
 	);
 private:
+	// 并行加载的最小单元：一个维度下的一个工况MAT文件
+	struct IngestJob
+	{
+		ResType type{ ResType::FP };
+		QString wcName{};
+		QString filepath{};
+		const DimSettings* settings{ nullptr };
+	};
+	struct IngestResult
+	{
+		bool ok{ false };
+		ExtraData exdata{};
+	};
+
+	// 读取dirPath下的settings文件
+	bool loadDimSettings(const QString& dirPath, DimSettings& settings);
+	// 列出dirPath下所有有效工况的MAT文件(按文件名排序，保证合并顺序确定)
+	void collectIngestJobs(
+		const QString& dirPath,
+		const QMap<QString, WorkingConditions>& allwcs,
+		const DimSettings& settings,
+		ResType type,
+		QVector<IngestJob>& jobs
+	);
+	// 在加载线程池中并行执行全部任务，结果与jobs一一对应
+	QVector<IngestResult> runIngestJobs(const QVector<IngestJob>& jobs);
+	// 可视化涉及的全部维度文件夹<文件夹名，维度>
+	static QVector<QPair<QString, ResType>> visualResFolders();
+	// 建立数据包索引：读取工况列表、各维度settings与MAT文件头，不解码数据
+	bool buildPackageIndex();
+	// 当前配置下维度的存储精度
+	SampleType storageType(ResType type) const;
+	// 影响处理结果的配置生成的缓存键
+	static QByteArray cacheKey(const DimSettings& settings, const QString& wcName, SampleType storage);
+	// 返回已加载的工况数据(统计信息)，未加载时按索引加载该工况；不存在或加载失败返回nullptr
+	// 缓存有效时只读取缓存头部，否则完整处理一遍并写入缓存
+	AnalyseData* ensureLoaded(ResType type, const QString& wcname);
+	// 缓存有效时只以缓存头部建立工况数据，数据列在访问时映射
+	bool openCachedCondition(ResType type, const QString& wcname);
+	// 将完整处理的工况数据交给驻留管理
+	void adoptIngested(ResType type, const QString& wcname, ExtraData& exdata);
+	// 将source中一个传感器的数据交给驻留管理，并放入target
+	void adoptColumn(ResType type, const QString& wcname, const QString& sensorName, const ExtraData& source, ExtraData& target);
+	// 加载指定传感器：优先映射缓存中的列，其余一次解码(只解码这些传感器)
+	bool loadSensorColumns(ResType type, const QString& wcname, const QStringList& sensorNames, ExtraData& exdata);
+	// 确保工况中的指定传感器驻留(为空时为全部传感器)，之后按预算淘汰其他数据列
+	AnalyseData* ensureResident(ResType type, const QString& wcname, const QStringList& sensorNames);
+	// 按预算淘汰，并从exData中移除被淘汰的数据列
+	void enforceResidencyBudget();
+	// 返回data->exData的只读快照，没有时生成
+	ExtraDataHandle sharedExtraData(AnalyseData* data);
+	// 绘图摘要所需的各工况快照(工况数据全部驻留)，wcnames为空时取全部工况，返回时只保留可用的工况
+	QVector<ExtraDataHandle> chartSnapshots(ResType dimtype, QStringList& wcnames);
+	// 释放已加载的数据与索引
+	void clearLoadedData();
+
 	//将各个维度的数据加载到内存
 	void getResTypeInfo(ResType type, QString& name, QString& unit);
 	/**
@@ -182,6 +405,21 @@ private:
 		ResType type,
 		bool pregGenData =false
 	);
+	/**
+	 * @brief 流式汇总数据文件(供saveBackground使用)
+	 *
+	 * 与loadAnalyseDataFile读取相同的文件，但每个MAT文件只顺序流式读取一遍，
+	 * 只保留统计结果(exData中data为空)以及绘图用的降采样时域曲线与功率谱，内存占用与文件大小无关。
+	 *
+	 * @param summaries [out] 各工况的绘图摘要
+	 */
+	bool summarizeAnalyseDataFile(
+		const QString& dirPath,
+		const QMap<QString, WorkingConditions>& wc,
+		QMap<QString, AnalyseData>& analyseData,
+		QMap<QString, ChartSummary>& summaries,
+		ResType type
+	);
 	/**
 	 * @brief 处理分段数据
 	 *
@@ -210,13 +448,24 @@ private:
 		const QString& unit,
 		ResType type,
 		const QMap<QString, WorkingConditions>& wcs,
-		QMap<QString, AnalyseData>& analyseData
-
+		QMap<QString, AnalyseData>& analyseData,
+		const QMap<QString, ChartSummary>* summaries = nullptr,	//不为空时使用摘要绘图(流式汇总的数据没有原始数据)
+		const QMap<QString, CoherenceMatrix>* coherences = nullptr	//不为空时各工况附相干系数表
+	);
+	/**
+	 * @brief 报告用的各工况测点间平均相干系数(供saveBackground使用)
+	 *
+	 * 只处理dirPath这一个维度：逐个工况读取该工况全部传感器的数据，计算互谱(PsdEngine::crossSpectra)后只保留相干系数矩阵，
+	 * 数据随即释放。不经过驻留管理与数据缓存，不需要数据包索引；内存占用为一个工况的数据。
+	 */
+	QMap<QString, CoherenceMatrix> reportCoherences(
+		const QString& dirPath,
+		const QMap<QString, WorkingConditions>& allwcs,
+		ResType type
 	);
 private:
 	//辅助函数：纯定制，无通用性，只是为了方遍从一个rootDir中提取出文件夹名字为foldername的完整文件夹路径
 	QString getFullPathFromDirByAppointFolder(const QString& foldername, QDir rootDir);
-	void clearExtraData(ExtraData& extra);
 private:
 	//以下为写入Docx时的辅助函数，纯定制，无通用性，只是为了该项目读写数据文件使用
 	enum class ParagraphFormat {
@@ -235,6 +484,13 @@ private:
 	//添加表的统一接口
 	QAxObject* createEigenvalueTable(QAxObject* doc, QAxObject* selection, WorkingConditionsList wcs, const QStringList& sensorsNames);
 	QAxObject* createSegEigenvalueTable(QAxObject* doc, QAxObject* selection, WorkingConditions wc, QStringList& wcsSeg, const QStringList& sensorsNames);
+	//相干系数表：第一列为rowNames，第一行为colNames
+	QAxObject* createCoherenceTable(QAxObject* doc, QAxObject* selection, const QStringList& rowNames, const QStringList& colNames);
+	//工况各测点两两之间的平均相干系数表(见reportCoherences)
+	void addCoherenceTables(QAxObject* doc, QAxObject* selection, const QString& titlename, const QString& wcdesp,
+		const CoherenceMatrix& coherence);
+	//特征值表中的主频(功率谱最大峰值的频率)，没有摘要或峰值时为"-"
+	static QString dominantFrequencyText(const QMap<QString, SignalSummary>& data, const QString& sensorName);
 	void fillTableDataCell(QAxObject* table, int row, int col, const QString& text, bool centerAlign);
 	void fillTableHeaderCell(QAxObject* table, int row, int col, const QString& text);
 	void mergeCells(QAxObject* table, int row1, int col1, int row2, int col2);
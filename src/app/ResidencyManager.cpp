@@ -0,0 +1,80 @@
+#include "ResidencyManager.h"
+
+void ResidencyManager::setBudget(qint64 bytes)
+{
+	_stats.budget = qMax<qint64>(bytes, 0);
+}
+
+qint64 ResidencyManager::budget() const
+{
+	return _stats.budget;
+}
+
+void ResidencyManager::beginRequest()
+{
+	_requestTick = ++_tick;
+}
+
+bool ResidencyManager::access(const ResidencyKey& key)
+{
+	auto iter = _entries.find(key);
+	if (iter == _entries.end()) {
+		return false;
+	}
+	// 同一请求内重复访问不重复计数
+	if (iter.value().lastUse < _requestTick) {
+		++_stats.hits;
+	}
+	touch(key, iter.value());
+	return true;
+}
+
+void ResidencyManager::insert(const ResidencyKey& key, qint64 bytes, std::shared_ptr<const void> owner)
+{
+	Entry& entry = _entries[key];
+	++_stats.misses;
+	_stats.bytesResident += bytes - entry.bytes;
+	entry.bytes = bytes;
+	entry.owner = std::move(owner);
+	touch(key, entry);
+}
+
+QVector<ResidencyKey> ResidencyManager::evict()
+{
+	QVector<ResidencyKey> evicted;
+	if (_stats.budget <= 0) {
+		return evicted;
+	}
+	auto iter = _lru.begin();
+	while (_stats.bytesResident > _stats.budget && iter != _lru.end() && iter.key() < _requestTick) {
+		const ResidencyKey key = iter.value();
+		iter = _lru.erase(iter);
+		auto entry = _entries.find(key);
+		_stats.bytesResident -= entry.value().bytes;
+		_entries.erase(entry);
+		++_stats.evictions;
+		evicted.append(key);
+	}
+	return evicted;
+}
+
+void ResidencyManager::clear()
+{
+	_entries.clear();
+	_lru.clear();
+	_stats.bytesResident = 0;
+}
+
+ResidencyManager::Stats ResidencyManager::stats() const
+{
+	return _stats;
+}
+
+void ResidencyManager::touch(const ResidencyKey& key, Entry& entry)
+{
+	if (entry.lastUse != 0) {
+		_lru.remove(entry.lastUse);
+	}
+	entry.lastUse = ++_tick;
+	_lru.insert(entry.lastUse, key);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+enum class ResType;
+
+// 驻留单元：一个维度下一个工况的一个传感器数据列(含其分段数据)
+struct ResidencyKey
+{
+	ResType type;
+	QString wcname{};
+	QString sensorName{};
+
+	bool operator<(const ResidencyKey& other) const
+	{
+		if (type != other.type)
+			return type < other.type;
+		if (wcname != other.wcname)
+			return wcname < other.wcname;
+		return sensorName < other.sensorName;
+	}
+};
+
+/**
+ * @brief 传感器数据的驻留管理(LRU)
+ *
+ * 每个驻留单元持有一个所有者对象，释放所有者即释放该列的内存(自有数组或映射区)。
+ * 超出预算时按最久未使用的顺序淘汰，当前请求(beginRequest之后)访问或加入的单元不会被淘汰，
+ * 因此一次请求需要的数据超过预算时会暂时超出，直到下一次请求。
+ * 只在主线程使用，不做同步。
+ */
+class ResidencyManager
+{
+public:
+	struct Stats
+	{
+		quint64 hits{ 0 };			// 访问时已驻留
+		quint64 misses{ 0 };		// 需要加载(加入的单元数)
+		quint64 evictions{ 0 };		// 被淘汰的单元数
+		qint64 bytesResident{ 0 };	// 当前驻留字节数
+		qint64 budget{ 0 };			// 预算字节数，<=0表示不限制
+
+		double hitRate() const
+		{
+			const quint64 total = hits + misses;
+			return total == 0 ? 0.0 : double(hits) / double(total);
+		}
+	};
+
+	// 设置预算，<=0表示不限制；生效于下一次evict
+	void setBudget(qint64 bytes);
+	qint64 budget() const;
+
+	// 开始一次请求，此后访问或加入的单元在下一次请求之前不会被淘汰
+	void beginRequest();
+
+	// 访问一个单元：已驻留时刷新使用时间并返回true(计为一次命中)，否则返回false
+	bool access(const ResidencyKey& key);
+
+	// 加入(或替换)一个驻留单元，计为一次未命中
+	void insert(const ResidencyKey& key, qint64 bytes, std::shared_ptr<const void> owner);
+
+	// 按预算淘汰最久未使用的单元，释放其所有者，返回被淘汰的键
+	QVector<ResidencyKey> evict();
+
+	// 释放全部单元(统计计数保留)
+	void clear();
+
+	Stats stats() const;
+
+private:
+	struct Entry
+	{
+		qint64 bytes{ 0 };
+		quint64 lastUse{ 0 };
+		std::shared_ptr<const void> owner{};
+	};
+	void touch(const ResidencyKey& key, Entry& entry);
+
+	QMap<ResidencyKey, Entry> _entries;
+	QMap<quint64, ResidencyKey> _lru;	// <最近使用时间，键>，按时间升序
+	quint64 _tick{ 0 };
+	quint64 _requestTick{ 0 };			// 当前请求的起始时间，lastUse不小于它的单元不可淘汰
+	Stats _stats{};
+};
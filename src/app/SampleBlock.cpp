@@ -0,0 +1,68 @@
+#include "SampleBlock.h"
+
+#include <new>
+
+SampleBlock::SampleBlock(int columnCount, int rowCount, SampleType type)
+	: _columnCount(qMax(columnCount, 0))
+	, _rowCount(qMax(rowCount, 0))
+	, _type(type)
+{
+	// 每列长度向上取整到对齐字节数，保证每列起点对齐
+	const qint64 columnBytes = qint64(_rowCount) * sampleSize(type);
+	_columnStride = (columnBytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	const qint64 total = qMax<qint64>(bytes(), ALIGNMENT);
+	_data = static_cast<uchar*>(::operator new[](size_t(total), std::align_val_t(ALIGNMENT)));
+}
+
+SampleBlock::~SampleBlock()
+{
+	::operator delete[](_data, std::align_val_t(ALIGNMENT));
+}
+
+SampleColumn SampleTable::value(const QString& name) const
+{
+	const int index = indexOf(name);
+	return index < 0 ? SampleColumn() : _columns[index];
+}
+
+void SampleTable::insert(const QString& name, SampleColumn column, std::shared_ptr<const void> owner, std::shared_ptr<const StatsIndex> statsIndex)
+{
+	const int index = indexOf(name);
+	if (index >= 0) {
+		_columns[index] = column;
+		_owners[index] = std::move(owner);
+		_statsIndexes[index] = std::move(statsIndex);
+		return;
+	}
+	_index.insert(name, _columns.count());
+	_names.append(name);
+	_columns.append(column);
+	_owners.append(std::move(owner));
+	_statsIndexes.append(std::move(statsIndex));
+}
+
+void SampleTable::remove(const QString& name)
+{
+	const int index = indexOf(name);
+	if (index < 0) {
+		return;
+	}
+	_names.removeAt(index);
+	_columns.remove(index);
+	_owners.remove(index);
+	_statsIndexes.remove(index);
+	// 之后的列前移，重建下标
+	_index.remove(name);
+	for (int i = index; i < _names.count(); ++i) {
+		_index[_names[i]] = i;
+	}
+}
+
+void SampleTable::clear()
+{
+	_names.clear();
+	_columns.clear();
+	_owners.clear();
+	_statsIndexes.clear();
+	_index.clear();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <memory>
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class StatsIndex;
+
+// 采样数据的存储精度
+enum class SampleType { Float64, Float32 };
+
+inline int sampleSize(SampleType type)
+{
+	return type == SampleType::Float32 ? int(sizeof(float)) : int(sizeof(double));
+}
+
+/**
+ * @brief 一列采样数据的只读视图
+ *
+ * 按存储精度访问数据；逐点访问用operator[]，热点循环应先用visit按精度分派一次，再扫描连续内存。
+ */
+struct SampleColumn
+{
+	const void* data{ nullptr };
+	SampleType type{ SampleType::Float64 };
+
+	SampleColumn() {}
+	SampleColumn(const double* values) : data(values), type(SampleType::Float64) {}
+	SampleColumn(const float* values) : data(values), type(SampleType::Float32) {}
+
+	bool isNull() const { return data == nullptr; }
+	explicit operator bool() const { return data != nullptr; }
+
+	double operator[](qint64 index) const
+	{
+		return type == SampleType::Float32 ? double(static_cast<const float*>(data)[index]) : static_cast<const double*>(data)[index];
+	}
+	// 从第index个数据点开始的视图
+	SampleColumn mid(qint64 index) const
+	{
+		if (!data)
+			return SampleColumn();
+		return type == SampleType::Float32 ? SampleColumn(static_cast<const float*>(data) + index)
+			: SampleColumn(static_cast<const double*>(data) + index);
+	}
+	// 以const double*或const float*调用f
+	template<typename F>
+	auto visit(F&& f) const -> decltype(f(static_cast<const double*>(nullptr)))
+	{
+		return type == SampleType::Float32 ? f(static_cast<const float*>(data)) : f(static_cast<const double*>(data));
+	}
+};
+
+/**
+ * @brief 按列存放的采样数据块
+ *
+ * 64字节对齐的连续内存，每列起点同样按64字节对齐，统计、功率谱、回放等热点循环只扫描连续内存。内存随对象析构释放。
+ * 加载数据时每个传感器单独一块(columnCount为1)，驻留管理淘汰一列即可释放该列的内存。
+ */
+class SampleBlock
+{
+public:
+	static constexpr int ALIGNMENT = 64;
+
+	// 分配columnCount列、每列rowCount个type精度数据的内存(不初始化)
+	SampleBlock(int columnCount, int rowCount, SampleType type = SampleType::Float64);
+	~SampleBlock();
+	SampleBlock(const SampleBlock&) = delete;
+	SampleBlock& operator=(const SampleBlock&) = delete;
+
+	int columnCount() const { return _columnCount; }
+	int rowCount() const { return _rowCount; }
+	SampleType type() const { return _type; }
+	// 第index列，T须与type()一致(double或float)
+	template<typename T>
+	T* column(int index) { return reinterpret_cast<T*>(_data + index * _columnStride); }
+	SampleColumn view(int index) const
+	{
+		const uchar* data = _data + index * _columnStride;
+		return _type == SampleType::Float32 ? SampleColumn(reinterpret_cast<const float*>(data)) : SampleColumn(reinterpret_cast<const double*>(data));
+	}
+	// 占用的字节数(含对齐填充)
+	qint64 bytes() const { return qint64(_columnCount) * _columnStride; }
+
+private:
+	uchar* _data{ nullptr };
+	int _columnCount{ 0 };
+	int _rowCount{ 0 };
+	SampleType _type{ SampleType::Float64 };
+	qint64 _columnStride{ 0 };	// 相邻两列起点的距离(字节)
+};
+
+/**
+ * @brief 传感器名到数据列的只读表
+ *
+ * 列可以位于SampleBlock内，也可以直接指向文件映射区，每列共享持有只属于该列的内存所有者，
+ * 复制表只复制指针与引用计数，最后一个引用释放时内存随之释放，无需手动delete[]。
+ * 列顺序即加入顺序，按名查找为哈希表。每列可以附带区间统计索引(见StatsIndex.h)，随列一起替换、移除。
+ */
+class SampleTable
+{
+public:
+	int count() const { return _columns.count(); }
+	bool isEmpty() const { return _columns.isEmpty(); }
+	// 传感器所在列，不存在时返回-1
+	int indexOf(const QString& name) const { return _index.value(name, -1); }
+	bool contains(const QString& name) const { return _index.contains(name); }
+	const QString& name(int index) const { return _names[index]; }
+	const QStringList& names() const { return _names; }
+	SampleColumn column(int index) const { return _columns[index]; }
+	// 按名获取数据列，不存在时返回空视图
+	SampleColumn value(const QString& name) const;
+	const std::shared_ptr<const void>& owner(int index) const { return _owners[index]; }
+	// 第index列的区间统计索引，未建立时为空
+	const std::shared_ptr<const StatsIndex>& statsIndex(int index) const { return _statsIndexes[index]; }
+	void setStatsIndex(int index, std::shared_ptr<const StatsIndex> statsIndex) { _statsIndexes[index] = std::move(statsIndex); }
+
+	// 加入一列，同名时替换；owner为该列内存的所有者(SampleBlock或映射区)
+	void insert(const QString& name, SampleColumn column, std::shared_ptr<const void> owner, std::shared_ptr<const StatsIndex> statsIndex = nullptr);
+	void remove(const QString& name);
+	void clear();
+
+private:
+	QStringList _names{};
+	QVector<SampleColumn> _columns{};
+	QVector<std::shared_ptr<const void>> _owners{};
+	QVector<std::shared_ptr<const StatsIndex>> _statsIndexes{};
+	QHash<QString, int> _index{};
+};
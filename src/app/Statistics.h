@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QtGlobal>
+
+// 一列数据(或其中一段)的统计信息
+struct Statistics {
+	double max{ 0.0 };//最大值
+	double min{ 0.0 };//最小值
+	double rms{ 0.0 };//均方根
+	double mean{ 0.0 };//均值
+	double variance{ 0.0 };//方差(总体方差)
+	double skewness{ 0.0 };//偏度
+	double kurtosis{ 0.0 };//峭度(正态分布为3)
+
+	// 峰峰值
+	double peakToPeak() const { return max - min; }
+	// 峰值因子：峰值/均方根
+	double crestFactor() const { return rms > 0.0 ? qMax(qAbs(max), qAbs(min)) / rms : 0.0; }
+};
@@ -0,0 +1,242 @@
+#include "StatsIndex.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// 直接扫描column的[begin, end)
+	void scanWindow(SampleColumn column, qint64 begin, qint64 end, STATS::Moments& moments)
+	{
+		if (begin >= end) {
+			return;
+		}
+		column.mid(begin).visit([&](auto data) {
+			STATS::accumulate(data, end - begin, moments);
+			});
+	}
+
+	// Neumaier补偿求和，前缀和随块数增长时不累积舍入误差
+	struct CompensatedSum
+	{
+		double sum{ 0.0 };
+		double compensation{ 0.0 };
+
+		void add(double value)
+		{
+			const double next = sum + value;
+			if (std::abs(sum) >= std::abs(value)) {
+				compensation += (sum - next) + value;
+			}
+			else {
+				compensation += (value - next) + sum;
+			}
+			sum = next;
+		}
+
+		double value() const { return sum + compensation; }
+	};
+
+	// 不大于value的最大2的幂次
+	int floorLog2(qint64 value)
+	{
+		int level = 0;
+		while ((qint64(2) << level) <= value) {
+			++level;
+		}
+		return level;
+	}
+}
+
+StatsIndex::StatsIndex(SampleColumn column, qint64 count)
+	: _count(column ? qMax<qint64>(count, 0) : 0)
+{
+	// 1. 各完整块的统计量，合并得到整列均值作为幂和的参考点
+	const int blockCount = int(_count / BLOCK_SIZE);
+	QVector<STATS::Moments> blocks(blockCount);
+	STATS::Moments total;
+	for (int i = 0; i < blockCount; ++i) {
+		scanWindow(column, qint64(i) * BLOCK_SIZE, qint64(i + 1) * BLOCK_SIZE, blocks[i]);
+		total.merge(blocks[i]);
+	}
+	_shift = total.count > 0 ? total.mean : 0.0;
+
+	// 各块中心矩平移到_shift后的幂和，补偿求和得到前缀和
+	CompensatedSum sums[4];
+	QVector<double> mins(blockCount), maxs(blockCount);
+	for (QVector<double>& prefix : _prefixSums) {
+		prefix.resize(blockCount + 1);
+		prefix[0] = 0.0;
+	}
+	for (int i = 0; i < blockCount; ++i) {
+		const STATS::Moments& block = blocks[i];
+		const double n = double(block.count);
+		const double d = block.mean - _shift;
+		const double d2 = d * d;
+		sums[0].add(n * d);
+		sums[1].add(block.m2 + n * d2);
+		sums[2].add(block.m3 + 3.0 * d * block.m2 + n * d2 * d);
+		sums[3].add(block.m4 + 4.0 * d * block.m3 + 6.0 * d2 * block.m2 + n * d2 * d2);
+		for (int k = 0; k < 4; ++k) {
+			_prefixSums[k][i + 1] = sums[k].value();
+		}
+		mins[i] = block.min;
+		maxs[i] = block.max;
+	}
+
+	// 2. 块最值的稀疏表
+	buildSparseTable(mins, maxs);
+}
+
+void StatsIndex::buildSparseTable(const QVector<double>& mins, const QVector<double>& maxs)
+{
+	// 第k层覆盖2^k个块
+	const int blockCount = mins.size();
+	if (blockCount == 0) {
+		return;
+	}
+	_blockMin.append(mins);
+	_blockMax.append(maxs);
+	for (int level = 1; (1 << level) <= blockCount; ++level) {
+		const QVector<double>& lowerMin = _blockMin[level - 1];
+		const QVector<double>& lowerMax = _blockMax[level - 1];
+		const int half = 1 << (level - 1);
+		const int width = blockCount - (1 << level) + 1;
+		QVector<double> levelMin(width), levelMax(width);
+		for (int i = 0; i < width; ++i) {
+			levelMin[i] = std::min(lowerMin[i], lowerMin[i + half]);
+			levelMax[i] = std::max(lowerMax[i], lowerMax[i + half]);
+		}
+		_blockMin.append(levelMin);
+		_blockMax.append(levelMax);
+	}
+}
+
+qint64 StatsIndex::bytes() const
+{
+	qint64 values = 0;
+	for (const QVector<double>& prefix : _prefixSums) {
+		values += prefix.size();
+	}
+	for (int level = 0; level < _blockMin.size(); ++level) {
+		values += _blockMin[level].size() + _blockMax[level].size();
+	}
+	return values * qint64(sizeof(double));
+}
+
+qint64 StatsIndex::serializedBytes(qint64 count)
+{
+	// _shift、4组前缀和(块数+1)、第0层最小值与最大值(块数)
+	const qint64 blockCount = qMax<qint64>(count, 0) / BLOCK_SIZE;
+	return (1 + 4 * (blockCount + 1) + 2 * blockCount) * qint64(sizeof(double));
+}
+
+QByteArray StatsIndex::toBytes() const
+{
+	const int blockCount = _prefixSums[0].size() - 1;
+	QByteArray bytes(int(serializedBytes(_count)), '\0');
+	char* out = bytes.data();
+	auto write = [&out](const double* values, int size) {
+		memcpy(out, values, size_t(size) * sizeof(double));
+		out += size_t(size) * sizeof(double);
+	};
+	write(&_shift, 1);
+	for (const QVector<double>& prefix : _prefixSums) {
+		write(prefix.constData(), prefix.size());
+	}
+	if (blockCount > 0) {
+		write(_blockMin[0].constData(), blockCount);
+		write(_blockMax[0].constData(), blockCount);
+	}
+	return bytes;
+}
+
+std::shared_ptr<const StatsIndex> StatsIndex::fromBytes(const uchar* data, qint64 count)
+{
+	if (!data || count < 0 || count / BLOCK_SIZE > INT_MAX - 1) {
+		return nullptr;
+	}
+	const int blockCount = int(count / BLOCK_SIZE);
+	const uchar* in = data;
+	auto read = [&in](double* values, int size) {
+		memcpy(values, in, size_t(size) * sizeof(double));
+		in += size_t(size) * sizeof(double);
+	};
+	std::shared_ptr<StatsIndex> index(new StatsIndex());
+	index->_count = count;
+	read(&index->_shift, 1);
+	for (QVector<double>& prefix : index->_prefixSums) {
+		prefix.resize(blockCount + 1);
+		read(prefix.data(), prefix.size());
+	}
+	QVector<double> mins(blockCount), maxs(blockCount);
+	read(mins.data(), blockCount);
+	read(maxs.data(), blockCount);
+	if (!std::isfinite(index->_shift) || index->_prefixSums[0][0] != 0.0) {
+		return nullptr;
+	}
+	index->buildSparseTable(mins, maxs);
+	return index;
+}
+
+STATS::Moments StatsIndex::window(SampleColumn column, qint64 begin, qint64 end) const
+{
+	STATS::Moments moments;
+	begin = qBound<qint64>(0, begin, _count);
+	end = qBound<qint64>(0, end, _count);
+	if (!column || begin >= end) {
+		return moments;
+	}
+
+	// 区间内的完整块[firstBlock, lastBlock)，没有完整块时直接扫描
+	const qint64 firstBlock = (begin + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	const qint64 lastBlock = std::min<qint64>(end / BLOCK_SIZE, _prefixSums[0].size() - 1);
+	if (firstBlock >= lastBlock) {
+		scanWindow(column, begin, end, moments);
+		return moments;
+	}
+	scanWindow(column, begin, firstBlock * BLOCK_SIZE, moments);
+	scanWindow(column, lastBlock * BLOCK_SIZE, end, moments);
+
+	const int level = floorLog2(lastBlock - firstBlock);
+	const int a = int(firstBlock);
+	const int b = int(lastBlock) - (1 << level);
+	double sums[4];
+	for (int k = 0; k < 4; ++k) {
+		sums[k] = _prefixSums[k][int(lastBlock)] - _prefixSums[k][a];
+	}
+	moments.merge(STATS::Moments::fromShiftedSums((lastBlock - firstBlock) * BLOCK_SIZE, _shift, sums[0], sums[1], sums[2], sums[3],
+		std::min(_blockMin[level][a], _blockMin[level][b]), std::max(_blockMax[level][a], _blockMax[level][b])));
+	return moments;
+}
+
+void buildStatsIndexes(SampleTable& table, qint64 count)
+{
+	for (int i = 0; i < table.count(); ++i) {
+		if (!table.statsIndex(i)) {
+			table.setStatsIndex(i, std::make_shared<const StatsIndex>(table.column(i), count));
+		}
+	}
+}
+
+bool windowStatistics(const SampleTable& table, const QString& sensorName, qint64 begin, qint64 end, Statistics& stats)
+{
+	const int index = table.indexOf(sensorName);
+	if (index < 0 || begin >= end) {
+		return false;
+	}
+	STATS::Moments moments;
+	if (const auto& statsIndex = table.statsIndex(index)) {
+		moments = statsIndex->window(table.column(index), begin, end);
+	}
+	else {
+		scanWindow(table.column(index), qMax<qint64>(begin, 0), end, moments);
+	}
+	if (moments.count == 0) {
+		return false;
+	}
+	stats = moments.toStatistics();
+	return true;
+}
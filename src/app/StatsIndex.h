@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QVector>
+
+#include "SampleBlock.h"
+#include "StatsKernel.h"
+
+/**
+ * @brief 单个传感器数据列的区间统计索引
+ *
+ * 按BLOCK_SIZE个数据点分块，保存各块相对整列均值的一到四次幂和的前缀和(Neumaier补偿求和)，以及块最小值、最大值的稀疏表(ST表)。
+ * 任意[begin, end)区间中完整的块O(1)得到均值、中心矩与最值，只有首尾不足一块的部分(最多2*(BLOCK_SIZE-1)个点)直接扫描，
+ * 因此分段数量、分析窗口可以在运行时任意指定而无需重新扫描整列。
+ * 索引只保存统计量，不持有数据，查询时传入建立索引时的数据列。附加内存为每块4 + 2 * (floor(log2(块数)) + 1)个double，
+ * 10^7个数据点时约为float64数据的3%(float32数据的6%)。
+ * 缓存文件中只保存前缀和与块最值(每块6个double)，加载时由块最值重建稀疏表，不需要扫描数据。
+ */
+class StatsIndex
+{
+public:
+	static constexpr int BLOCK_SIZE = 1024;
+
+	// 为column的前count个数据点建立索引(扫描一遍)，column为空时count()为0
+	StatsIndex(SampleColumn column, qint64 count);
+
+	qint64 count() const { return _count; }
+	// 索引占用的字节数
+	qint64 bytes() const;
+
+	// [begin, end)区间的统计量，区间超出范围时截取到[0, count)；column须为建立索引时的数据列
+	STATS::Moments window(SampleColumn column, qint64 begin, qint64 end) const;
+
+	// count个数据点的索引序列化后的字节数
+	static qint64 serializedBytes(qint64 count);
+	// 序列化为serializedBytes(count())字节(本机字节序的double)
+	QByteArray toBytes() const;
+	// 由toBytes的结果恢复，data须有serializedBytes(count)字节；内容不合法时返回空
+	static std::shared_ptr<const StatsIndex> fromBytes(const uchar* data, qint64 count);
+
+private:
+	StatsIndex() = default;
+	// 由第0层(单块)最值建立稀疏表
+	void buildSparseTable(const QVector<double>& mins, const QVector<double>& maxs);
+
+	qint64 _count{ 0 };
+	double _shift{ 0.0 };					//幂和的参考点(整列均值)
+	QVector<double> _prefixSums[4]{};		//_prefixSums[k-1][i]为前i个完整块的Σ(x-_shift)^k
+	QVector<QVector<double>> _blockMin{};	//_blockMin[k][i]为第i块起2^k块的最小值
+	QVector<QVector<double>> _blockMax{};
+};
+
+// 为table中还没有索引的数据列建立索引，count为每列的数据点数量
+void buildStatsIndexes(SampleTable& table, qint64 count);
+
+// table中传感器在[begin, end)内的统计信息，有索引时不扫描整个区间，没有索引时end不能超过数据点数量；
+// 传感器不在table中或区间为空时返回false
+bool windowStatistics(const SampleTable& table, const QString& sensorName, qint64 begin, qint64 end, Statistics& stats);
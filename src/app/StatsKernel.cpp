@@ -0,0 +1,487 @@
+#include "StatsKernel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STATS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STATS_TARGET_SSE2
+#define STATS_TARGET_AVX2
+#else
+#define STATS_TARGET_SSE2 __attribute__((target("sse2")))
+#define STATS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	using STATS::Isa;
+	using STATS::Moments;
+
+	constexpr double INF = std::numeric_limits<double>::infinity();
+
+	// 一块数据第一遍的结果
+	struct ChunkSums
+	{
+		double min{ INF };
+		double max{ -INF };
+		double sum{ 0.0 };
+	};
+
+	// 一块数据第二遍的结果：相对块均值的二到四阶中心幂和
+	struct CentralSums
+	{
+		double m2{ 0.0 };
+		double m3{ 0.0 };
+		double m4{ 0.0 };
+	};
+
+	/**
+	 * @brief 第一遍的逐点实现：越界置零、写出、最值与和，同时用于SIMD实现末尾不足一个向量的部分
+	 *
+	 * S为数据精度，D为写出精度，dst为空时不写出；min/max以数据为第二个参数，数据为NaN时保留原值
+	 */
+	template<typename S, typename D>
+	qint64 scalarFirst(const S* src, qint64 count, double minValue, double maxValue, ChunkSums& sums, D* dst)
+	{
+		qint64 clamped = 0;
+		for (qint64 i = 0; i < count; ++i) {
+			double value = double(src[i]);
+			if (value < minValue || value > maxValue) {
+				value = 0.0;
+				++clamped;
+			}
+			if (dst) {
+				dst[i] = D(value);
+			}
+			sums.min = std::min(sums.min, value);
+			sums.max = std::max(sums.max, value);
+			sums.sum += value;
+		}
+		return clamped;
+	}
+
+	// 第二遍的逐点实现：越界置零后累加相对mean的中心幂和
+	template<typename S>
+	void scalarSecond(const S* src, qint64 count, double minValue, double maxValue, double mean, CentralSums& sums)
+	{
+		for (qint64 i = 0; i < count; ++i) {
+			double value = double(src[i]);
+			if (value < minValue || value > maxValue) {
+				value = 0.0;
+			}
+			const double d = value - mean;
+			const double d2 = d * d;
+			sums.m2 += d2;
+			sums.m3 += d2 * d;
+			sums.m4 += d2 * d2;
+		}
+	}
+
+#ifdef STATS_X86
+	// 读取4个数据点为两个向量
+	STATS_TARGET_SSE2 inline void sse2Load(const double* src, __m128d& a, __m128d& b)
+	{
+		a = _mm_loadu_pd(src);
+		b = _mm_loadu_pd(src + 2);
+	}
+
+	STATS_TARGET_SSE2 inline void sse2Load(const float* src, __m128d& a, __m128d& b)
+	{
+		const __m128 v = _mm_loadu_ps(src);
+		a = _mm_cvtps_pd(v);
+		b = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+	}
+
+	// 超出范围的通道置零，并把置零的通道数累加到clamped(比较结果为全1，即-1)
+	STATS_TARGET_SSE2 inline __m128d sse2Clamp(__m128d v, __m128d lo, __m128d hi, __m128i& clamped)
+	{
+		const __m128d out = _mm_or_pd(_mm_cmplt_pd(v, lo), _mm_cmpgt_pd(v, hi));
+		clamped = _mm_sub_epi64(clamped, _mm_castpd_si128(out));
+		return _mm_andnot_pd(out, v);
+	}
+
+	STATS_TARGET_SSE2 inline __m128d sse2Clamp(__m128d v, __m128d lo, __m128d hi)
+	{
+		return _mm_andnot_pd(_mm_or_pd(_mm_cmplt_pd(v, lo), _mm_cmpgt_pd(v, hi)), v);
+	}
+
+	STATS_TARGET_SSE2 inline void sse2Store(double* dst, __m128d v)
+	{
+		_mm_storeu_pd(dst, v);
+	}
+
+	STATS_TARGET_SSE2 inline void sse2Store(float* dst, __m128d v)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(dst), _mm_cvtpd_ps(v));
+	}
+
+	STATS_TARGET_SSE2 inline double sse2Sum(__m128d v)
+	{
+		alignas(16) double lanes[2];
+		_mm_store_pd(lanes, v);
+		return lanes[0] + lanes[1];
+	}
+
+	template<typename S, typename D>
+	STATS_TARGET_SSE2 qint64 sse2First(const S* src, qint64 count, double minValue, double maxValue, ChunkSums& sums, D* dst)
+	{
+		const __m128d lo = _mm_set1_pd(minValue);
+		const __m128d hi = _mm_set1_pd(maxValue);
+		__m128i clamped = _mm_setzero_si128();
+		__m128d vmin = _mm_set1_pd(INF), vmax = _mm_set1_pd(-INF);
+		__m128d suma = _mm_setzero_pd(), sumb = _mm_setzero_pd();
+		qint64 i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128d a, b;
+			sse2Load(src + i, a, b);
+			a = sse2Clamp(a, lo, hi, clamped);
+			b = sse2Clamp(b, lo, hi, clamped);
+			if (dst) {
+				sse2Store(dst + i, a);
+				sse2Store(dst + i + 2, b);
+			}
+			// 数据为第一个操作数，数据为NaN时保留累加值
+			vmin = _mm_min_pd(a, vmin);
+			vmin = _mm_min_pd(b, vmin);
+			vmax = _mm_max_pd(a, vmax);
+			vmax = _mm_max_pd(b, vmax);
+			suma = _mm_add_pd(suma, a);
+			sumb = _mm_add_pd(sumb, b);
+		}
+		alignas(16) double mins[2], maxs[2];
+		alignas(16) qint64 counts[2];
+		_mm_store_pd(mins, vmin);
+		_mm_store_pd(maxs, vmax);
+		_mm_store_si128(reinterpret_cast<__m128i*>(counts), clamped);
+		sums.min = std::min({ sums.min, mins[0], mins[1] });
+		sums.max = std::max({ sums.max, maxs[0], maxs[1] });
+		sums.sum += sse2Sum(_mm_add_pd(suma, sumb));
+		return counts[0] + counts[1] + scalarFirst(src + i, count - i, minValue, maxValue, sums, dst ? dst + i : nullptr);
+	}
+
+	template<typename S>
+	STATS_TARGET_SSE2 void sse2Second(const S* src, qint64 count, double minValue, double maxValue, double mean, CentralSums& sums)
+	{
+		const __m128d lo = _mm_set1_pd(minValue);
+		const __m128d hi = _mm_set1_pd(maxValue);
+		const __m128d vmean = _mm_set1_pd(mean);
+		__m128d m2 = _mm_setzero_pd(), m3 = _mm_setzero_pd(), m4 = _mm_setzero_pd();
+		qint64 i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128d a, b;
+			sse2Load(src + i, a, b);
+			a = _mm_sub_pd(sse2Clamp(a, lo, hi), vmean);
+			b = _mm_sub_pd(sse2Clamp(b, lo, hi), vmean);
+			const __m128d a2 = _mm_mul_pd(a, a);
+			const __m128d b2 = _mm_mul_pd(b, b);
+			m2 = _mm_add_pd(m2, _mm_add_pd(a2, b2));
+			m3 = _mm_add_pd(m3, _mm_add_pd(_mm_mul_pd(a2, a), _mm_mul_pd(b2, b)));
+			m4 = _mm_add_pd(m4, _mm_add_pd(_mm_mul_pd(a2, a2), _mm_mul_pd(b2, b2)));
+		}
+		sums.m2 += sse2Sum(m2);
+		sums.m3 += sse2Sum(m3);
+		sums.m4 += sse2Sum(m4);
+		scalarSecond(src + i, count - i, minValue, maxValue, mean, sums);
+	}
+
+	// 读取8个数据点为两个向量
+	STATS_TARGET_AVX2 inline void avx2Load(const double* src, __m256d& a, __m256d& b)
+	{
+		a = _mm256_loadu_pd(src);
+		b = _mm256_loadu_pd(src + 4);
+	}
+
+	STATS_TARGET_AVX2 inline void avx2Load(const float* src, __m256d& a, __m256d& b)
+	{
+		const __m256 v = _mm256_loadu_ps(src);
+		a = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+		b = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+	}
+
+	STATS_TARGET_AVX2 inline __m256d avx2Clamp(__m256d v, __m256d lo, __m256d hi, __m256i& clamped)
+	{
+		const __m256d out = _mm256_or_pd(_mm256_cmp_pd(v, lo, _CMP_LT_OQ), _mm256_cmp_pd(v, hi, _CMP_GT_OQ));
+		clamped = _mm256_sub_epi64(clamped, _mm256_castpd_si256(out));
+		return _mm256_andnot_pd(out, v);
+	}
+
+	STATS_TARGET_AVX2 inline __m256d avx2Clamp(__m256d v, __m256d lo, __m256d hi)
+	{
+		return _mm256_andnot_pd(_mm256_or_pd(_mm256_cmp_pd(v, lo, _CMP_LT_OQ), _mm256_cmp_pd(v, hi, _CMP_GT_OQ)), v);
+	}
+
+	STATS_TARGET_AVX2 inline void avx2Store(double* dst, __m256d v)
+	{
+		_mm256_storeu_pd(dst, v);
+	}
+
+	STATS_TARGET_AVX2 inline void avx2Store(float* dst, __m256d v)
+	{
+		_mm_storeu_ps(dst, _mm256_cvtpd_ps(v));
+	}
+
+	STATS_TARGET_AVX2 inline double avx2Sum(__m256d v)
+	{
+		alignas(32) double lanes[4];
+		_mm256_store_pd(lanes, v);
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+
+	template<typename S, typename D>
+	STATS_TARGET_AVX2 qint64 avx2First(const S* src, qint64 count, double minValue, double maxValue, ChunkSums& sums, D* dst)
+	{
+		const __m256d lo = _mm256_set1_pd(minValue);
+		const __m256d hi = _mm256_set1_pd(maxValue);
+		__m256i clamped = _mm256_setzero_si256();
+		__m256d vmin = _mm256_set1_pd(INF), vmax = _mm256_set1_pd(-INF);
+		__m256d suma = _mm256_setzero_pd(), sumb = _mm256_setzero_pd();
+		qint64 i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256d a, b;
+			avx2Load(src + i, a, b);
+			a = avx2Clamp(a, lo, hi, clamped);
+			b = avx2Clamp(b, lo, hi, clamped);
+			if (dst) {
+				avx2Store(dst + i, a);
+				avx2Store(dst + i + 4, b);
+			}
+			vmin = _mm256_min_pd(a, vmin);
+			vmin = _mm256_min_pd(b, vmin);
+			vmax = _mm256_max_pd(a, vmax);
+			vmax = _mm256_max_pd(b, vmax);
+			suma = _mm256_add_pd(suma, a);
+			sumb = _mm256_add_pd(sumb, b);
+		}
+		alignas(32) double mins[4], maxs[4];
+		alignas(32) qint64 counts[4];
+		_mm256_store_pd(mins, vmin);
+		_mm256_store_pd(maxs, vmax);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(counts), clamped);
+		sums.min = std::min({ sums.min, mins[0], mins[1], mins[2], mins[3] });
+		sums.max = std::max({ sums.max, maxs[0], maxs[1], maxs[2], maxs[3] });
+		sums.sum += avx2Sum(_mm256_add_pd(suma, sumb));
+		return (counts[0] + counts[1]) + (counts[2] + counts[3])
+			+ scalarFirst(src + i, count - i, minValue, maxValue, sums, dst ? dst + i : nullptr);
+	}
+
+	template<typename S>
+	STATS_TARGET_AVX2 void avx2Second(const S* src, qint64 count, double minValue, double maxValue, double mean, CentralSums& sums)
+	{
+		const __m256d lo = _mm256_set1_pd(minValue);
+		const __m256d hi = _mm256_set1_pd(maxValue);
+		const __m256d vmean = _mm256_set1_pd(mean);
+		__m256d m2 = _mm256_setzero_pd(), m3 = _mm256_setzero_pd(), m4 = _mm256_setzero_pd();
+		qint64 i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256d a, b;
+			avx2Load(src + i, a, b);
+			a = _mm256_sub_pd(avx2Clamp(a, lo, hi), vmean);
+			b = _mm256_sub_pd(avx2Clamp(b, lo, hi), vmean);
+			const __m256d a2 = _mm256_mul_pd(a, a);
+			const __m256d b2 = _mm256_mul_pd(b, b);
+			m2 = _mm256_add_pd(m2, _mm256_add_pd(a2, b2));
+			m3 = _mm256_add_pd(m3, _mm256_add_pd(_mm256_mul_pd(a2, a), _mm256_mul_pd(b2, b)));
+			m4 = _mm256_add_pd(m4, _mm256_add_pd(_mm256_mul_pd(a2, a2), _mm256_mul_pd(b2, b2)));
+		}
+		sums.m2 += avx2Sum(m2);
+		sums.m3 += avx2Sum(m3);
+		sums.m4 += avx2Sum(m4);
+		scalarSecond(src + i, count - i, minValue, maxValue, mean, sums);
+	}
+#endif
+
+	// CPU与操作系统均支持的最高指令集(AVX2还要求系统保存YMM寄存器状态)
+	Isa detectIsa()
+	{
+#if !defined(STATS_X86)
+		return Isa::Scalar;
+#elif defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		bool avx2 = false;
+		if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+		return avx2 ? Isa::AVX2 : (sse2 ? Isa::SSE2 : Isa::Scalar);
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			return Isa::AVX2;
+		}
+		return __builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::Scalar;
+#endif
+	}
+
+	Isa supportedIsa()
+	{
+		static const Isa isa = detectIsa();
+		return isa;
+	}
+
+	std::atomic<Isa>& isaSetting()
+	{
+		static std::atomic<Isa> isa{ supportedIsa() };
+		return isa;
+	}
+
+	// 按当前指令集选择的两遍实现
+	template<typename S, typename D>
+	struct ChunkKernel
+	{
+		qint64(*first)(const S*, qint64, double, double, ChunkSums&, D*);
+		void(*second)(const S*, qint64, double, double, double, CentralSums&);
+	};
+
+	template<typename S, typename D>
+	ChunkKernel<S, D> selectKernel()
+	{
+		switch (STATS::activeIsa()) {
+#ifdef STATS_X86
+		case Isa::AVX2:
+			return { &avx2First<S, D>, &avx2Second<S> };
+		case Isa::SSE2:
+			return { &sse2First<S, D>, &sse2Second<S> };
+#endif
+		default:
+			return { &scalarFirst<S, D>, &scalarSecond<S> };
+		}
+	}
+
+	// 分块执行两遍扫描，每块的结果合并到moments
+	template<typename S, typename D>
+	qint64 chunkedKernel(const S* src, qint64 count, double minValue, double maxValue, Moments& moments, D* dst)
+	{
+		if (!src || count <= 0) {
+			return 0;
+		}
+		const ChunkKernel<S, D> kernel = selectKernel<S, D>();
+		qint64 clamped = 0;
+		for (qint64 offset = 0; offset < count; offset += STATS::CHUNK_SIZE) {
+			const qint64 size = std::min<qint64>(STATS::CHUNK_SIZE, count - offset);
+			ChunkSums sums;
+			clamped += kernel.first(src + offset, size, minValue, maxValue, sums, dst ? dst + offset : nullptr);
+			Moments chunk;
+			chunk.count = size;
+			chunk.min = sums.min;
+			chunk.max = sums.max;
+			chunk.mean = sums.sum / double(size);
+			CentralSums central;
+			kernel.second(src + offset, size, minValue, maxValue, chunk.mean, central);
+			chunk.m2 = central.m2;
+			chunk.m3 = central.m3;
+			chunk.m4 = central.m4;
+			moments.merge(chunk);
+		}
+		return clamped;
+	}
+}
+
+void STATS::Moments::merge(const Moments& other)
+{
+	if (other.count <= 0) {
+		return;
+	}
+	if (count <= 0) {
+		*this = other;
+		return;
+	}
+	// Pébay(2008)的成对合并公式，高阶矩先用合并前的低阶矩更新
+	const double na = double(count);
+	const double nb = double(other.count);
+	const double n = na + nb;
+	const double delta = other.mean - mean;
+	const double deltaN = delta / n;
+	const double deltaN2 = deltaN * deltaN;
+	const double term = delta * deltaN * na * nb;
+	m4 += other.m4 + term * deltaN2 * (na * na - na * nb + nb * nb)
+		+ 6.0 * deltaN2 * (na * na * other.m2 + nb * nb * m2) + 4.0 * deltaN * (na * other.m3 - nb * m3);
+	m3 += other.m3 + term * deltaN * (na - nb) + 3.0 * deltaN * (na * other.m2 - nb * m2);
+	m2 += other.m2 + term;
+	mean += nb * deltaN;
+	count += other.count;
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+}
+
+STATS::Moments STATS::Moments::fromShiftedSums(qint64 count, double shift, double s1, double s2, double s3, double s4, double min, double max)
+{
+	Moments moments;
+	if (count <= 0) {
+		return moments;
+	}
+	// 以delta = s1/n把参考点移到均值，舍入可能带来的微小负值截为0
+	const double n = double(count);
+	const double delta = s1 / n;
+	const double delta2 = delta * delta;
+	moments.count = count;
+	moments.min = min;
+	moments.max = max;
+	moments.mean = shift + delta;
+	moments.m2 = std::max(s2 - s1 * delta, 0.0);
+	moments.m3 = s3 - 3.0 * delta * s2 + 2.0 * n * delta2 * delta;
+	moments.m4 = std::max(s4 - 4.0 * delta * s3 + 6.0 * delta2 * s2 - 3.0 * n * delta2 * delta2, 0.0);
+	return moments;
+}
+
+Statistics STATS::Moments::toStatistics() const
+{
+	Statistics stats;
+	if (count <= 0) {
+		return stats;
+	}
+	const double n = double(count);
+	stats.max = max;
+	stats.min = min;
+	stats.mean = mean;
+	stats.variance = m2 / n;
+	stats.rms = std::sqrt(mean * mean + stats.variance);
+	// 方差相对均值可以忽略(常数数据)时偏度、峭度没有意义
+	if (m2 > 0.0 && stats.variance > std::numeric_limits<double>::epsilon() * mean * mean) {
+		stats.skewness = std::sqrt(n) * m3 / (m2 * std::sqrt(m2));
+		stats.kurtosis = n * m4 / (m2 * m2);
+	}
+	return stats;
+}
+
+qint64 STATS::accumulate(const double* src, qint64 count, double minValue, double maxValue, Moments& moments, double* dst)
+{
+	return chunkedKernel(src, count, minValue, maxValue, moments, dst);
+}
+
+qint64 STATS::accumulate(const double* src, qint64 count, double minValue, double maxValue, Moments& moments, float* dst)
+{
+	return chunkedKernel(src, count, minValue, maxValue, moments, dst);
+}
+
+void STATS::accumulate(const double* src, qint64 count, Moments& moments)
+{
+	chunkedKernel(src, count, -INF, INF, moments, static_cast<double*>(nullptr));
+}
+
+void STATS::accumulate(const float* src, qint64 count, Moments& moments)
+{
+	chunkedKernel(src, count, -INF, INF, moments, static_cast<double*>(nullptr));
+}
+
+STATS::Isa STATS::activeIsa()
+{
+	return isaSetting().load(std::memory_order_relaxed);
+}
+
+STATS::Isa STATS::setIsa(Isa isa)
+{
+	const Isa used = std::min(isa, supportedIsa());
+	isaSetting().store(used, std::memory_order_relaxed);
+	return used;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <limits>
+
+#include <QtGlobal>
+
+#include "Statistics.h"
+
+/**
+ * @brief 单遍统计内核
+ *
+ * 越界置零、最小值、最大值与均值、二到四阶中心矩在一次读取中完成：数据按CHUNK_SIZE分块，
+ * 块内先求和得到块均值，再在仍位于缓存中的数据上累加中心矩，最后按Pébay公式合并到总体，
+ * 避免直接累加平方和在大量数据上的精度损失。运行时按CPU支持的指令集选择AVX2/SSE2/标量实现。
+ * 同一Moments可以依次传入多个数据块累加，也可以在线程之间合并，最值与分块方式无关。
+ * readMatFile、分段统计与流式统计共用这一实现。
+ */
+namespace STATS
+{
+	enum class Isa { Scalar, SSE2, AVX2 };
+
+	// 每块的数据点数量，块内两遍扫描都在缓存中完成
+	constexpr int CHUNK_SIZE = 2048;
+
+	// 可合并的统计累加量
+	struct Moments
+	{
+		qint64 count{ 0 };
+		double min{ std::numeric_limits<double>::infinity() };
+		double max{ -std::numeric_limits<double>::infinity() };
+		double mean{ 0.0 };
+		double m2{ 0.0 };	//二阶中心矩之和 Σ(x-mean)^2
+		double m3{ 0.0 };	//Σ(x-mean)^3
+		double m4{ 0.0 };	//Σ(x-mean)^4
+
+		// 合并另一部分数据的累加量(与先后顺序无关)
+		void merge(const Moments& other);
+		// 由相对参考点shift的幂和sk = Σ(x-shift)^k构造，shift接近均值时不会损失精度
+		static Moments fromShiftedSums(qint64 count, double shift, double s1, double s2, double s3, double s4, double min, double max);
+		// 转换为统计信息，没有数据时全部为0
+		Statistics toStatistics() const;
+	};
+
+	/**
+	 * @brief 越界置零并累加统计量
+	 *
+	 * 超出[minValue, maxValue]的值按0参与统计(NaN不置零，与逐点比较的结果一致)
+	 *
+	 * @param dst 非空时同时写出置零后的数据，可以与src相同
+	 * @return qint64 被置零的数据点数量
+	 */
+	qint64 accumulate(const double* src, qint64 count, double minValue, double maxValue, Moments& moments, double* dst = nullptr);
+	// 同上，写出为float，统计基于置零后、降精度前的值
+	qint64 accumulate(const double* src, qint64 count, double minValue, double maxValue, Moments& moments, float* dst);
+	// 不置零，只统计
+	void accumulate(const double* src, qint64 count, Moments& moments);
+	void accumulate(const float* src, qint64 count, Moments& moments);
+
+	// 当前使用的指令集
+	Isa activeIsa();
+	// 指定使用的指令集(不超过CPU支持的最高指令集)，用于与标量实现对比验证，返回实际使用的指令集
+	Isa setIsa(Isa isa);
+};
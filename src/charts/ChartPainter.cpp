@@ -1,5 +1,9 @@
 #include "ChartPainter.h"
 
+#include <cmath>
+#include <limits>
+
+#include "PsdEngine.h"
 #include "PSDAnalyzer.h"
 
 ChartPainter::~ChartPainter()
@@ -30,6 +34,11 @@ ChartPainter::~ChartPainter()
 	}
 	_imgSegDataFrequencySpectrum.clear();
 
+	for (auto it = _imgSpectrograms.begin(); it != _imgSpectrograms.end(); ++it) {
+		delete it.value();
+	}
+	_imgSpectrograms.clear();
+
 	//必须放最后处理！
 	for (auto& widget : _mixWidgets)
 	{
@@ -40,31 +49,92 @@ ChartPainter::~ChartPainter()
 
 }
 
-void ChartPainter::setData(const ExtraData& exdata, bool removemean)
+void ChartPainter::setData(const ExtraData& exdata, bool removemean, const PSDA::WelchConfig& config)
 {
-	// 全局数据
-	for (auto iter = exdata.data.begin(); iter != exdata.data.end(); ++iter)
-	{
-		processSensorData(iter.key(), iter.value(), exdata.dataCount, exdata.frequency, _imgTimeSeries, _imgFrequencySpectrum, removemean);
-	}
+	// 全过程与分段数据(全过程数据中的区间)的摘要，与PsdEngine计算的结果一致
+	setSummary(PsdEngine::summarize(exdata, removemean, config));
+}
 
-	if (!exdata.hasSegData)
+void ChartPainter::setSummary(const ChartSummary& summary)
+{
+	// 全局数据
+	for (auto iter = summary.data.begin(); iter != summary.data.end(); ++iter)
 	{
-		return;
+		const auto& sensor = iter.value();
+		addSensorCharts(iter.key(), sensor.times, sensor.values, sensor.duration, sensor.min, sensor.max, sensor.freqs, sensor.pxx,
+			_imgTimeSeries, _imgFrequencySpectrum);
 	}
 
 	// 分段数据
-	auto segDataCount = exdata.segData.count();
+	auto segDataCount = summary.segData.count();
 	_imgSegDataTimeSeries.resize(segDataCount);
 	_imgSegDataFrequencySpectrum.resize(segDataCount);
 	for (int i = 0; i < segDataCount; i++)
 	{
-		auto segData = exdata.segData[i];
+		const auto& segData = summary.segData[i];
 		for (auto segiter = segData.begin(); segiter != segData.end(); ++segiter)
 		{
-			processSensorData(segiter.key(), segiter.value(), exdata.dataCountEach, exdata.frequency, _imgSegDataTimeSeries[i], _imgSegDataFrequencySpectrum[i], removemean);
+			const auto& sensor = segiter.value();
+			addSensorCharts(segiter.key(), sensor.times, sensor.values, sensor.duration, sensor.min, sensor.max, sensor.freqs, sensor.pxx,
+				_imgSegDataTimeSeries[i], _imgSegDataFrequencySpectrum[i]);
+		}
+	}
+}
+
+void ChartPainter::setSpectrogram(const QString& sensorname, const PSDA::Spectrogram& spectrogram)
+{
+	const int columnCount = spectrogram.columnCount();
+	const int freqCount = spectrogram.freqs.count();
+	if (columnCount == 0 || freqCount == 0 || spectrogram.power.count() != columnCount * freqCount)
+	{
+		return;
+	}
+	delete _imgSpectrograms.take(sensorname);
+
+	// 1. 功率谱密度换算为dB，显示最大值以下80dB的动态范围(去除的直流分量等0值按下限显示)
+	const double maxPower = *std::max_element(spectrogram.power.constBegin(), spectrogram.power.constEnd());
+	const double maxDb = 10.0 * std::log10(qMax(maxPower, std::numeric_limits<double>::min()));
+	const double minDb = maxDb - 80.0;
+
+	// 2. 创建图表与色图
+	auto chart = new ScalableCustomPlot();
+	chart->setTitle(QString("时频分析 测点%1").arg(sensorname));
+	chart->xAxis->setLabel("时间(s)");
+	chart->yAxis->setLabel("频率(Hz)");
+	// 只有一列时以该列中心为中点，时间范围从0开始
+	const QCPRange timeRange = columnCount > 1 ? QCPRange(spectrogram.times.first(), spectrogram.times.last())
+		: QCPRange(0.0, 2.0 * spectrogram.times.first());
+	const QCPRange freqRange(spectrogram.freqs.first(), spectrogram.freqs.last());
+	auto colorMap = new QCPColorMap(chart->xAxis, chart->yAxis);
+	colorMap->data()->setSize(columnCount, freqCount);
+	colorMap->data()->setRange(timeRange, freqRange);
+	for (int c = 0; c < columnCount; ++c)
+	{
+		const double* column = spectrogram.power.constData() + c * freqCount;
+		for (int i = 0; i < freqCount; ++i)
+		{
+			const double db = column[i] > 0.0 ? 10.0 * std::log10(column[i]) : minDb;
+			colorMap->data()->setCell(c, i, qMax(db, minDb));
 		}
 	}
+
+	// 3. 色标放在坐标区右侧(第0行为标题)
+	auto colorScale = new QCPColorScale(chart);
+	chart->plotLayout()->addElement(1, 1, colorScale);
+	colorScale->setType(QCPAxis::atRight);
+	colorScale->axis()->setLabel(QString("功率谱密度(dB,(%1)²/Hz)").arg(_titleUnit));
+	colorMap->setColorScale(colorScale);
+	colorMap->setGradient(QCPColorGradient::gpJet);
+	colorMap->setDataRange(QCPRange(minDb, maxDb));
+	QCPMarginGroup* marginGroup = new QCPMarginGroup(chart);
+	chart->axisRect()->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+	colorScale->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+
+	chart->xAxis->setRange(timeRange);
+	chart->yAxis->setRange(freqRange);
+	chart->setOriginalRanges();
+	chart->replot();
+	_imgSpectrograms[sensorname] = chart;
 }
 
 void ChartPainter::save(const QString& dirpath, int width, int height)
@@ -140,6 +210,10 @@ QWidget* ChartPainter::getChart(const QString& sensorname, int mode)
 	{
 		return fschart;
 	}
+	if (3 == mode)
+	{
+		return _imgSpectrograms.value(sensorname, nullptr);
+	}
 	if (0 == mode)
 	{
 		QVBoxLayout* layout = new QVBoxLayout;
@@ -192,52 +266,30 @@ QVector<QWidget*> ChartPainter::getSegChart(const QString& sensorname, int mode)
 	return result;
 }
 
-void ChartPainter::processSensorData(
+void ChartPainter::addSensorCharts(
 	const QString& sensorName,
-	double* sensorData,
-	int dataCount,
-	double frequency,
+	const QVector<double>& xData,
+	const QVector<double>& yData,
+	double duration,
+	double min,
+	double max,
+	const QVector<double>& freqs,
+	const QVector<double>& pxx,
 	QMap<QString, ScalableCustomPlot*>& timeSeriesMap,
-	QMap<QString, ScalableCustomPlot*>& frequencySpectrumMap,
-	bool removemean
+	QMap<QString, ScalableCustomPlot*>& frequencySpectrumMap
 )
 {
-	// 准备Y轴数据
-	QVector<double> fluctuation;
-	QVector<double> romData;
-	QVector<double> resata;
-	double min = 0, max = 0;
-	PSDA::preprocessData(sensorData, dataCount, resata, romData, fluctuation, min, max, frequency, 1.96);
-	// 准备时间轴数据
-	QVector<double> xData;
-	if (removemean)
-	{
-		xData.resize(fluctuation.count());
-		for (int i = 0; i < fluctuation.count(); ++i) {
-			xData[i] = double(i) / frequency;
-		}
-		max = *std::max_element(fluctuation.constBegin(), fluctuation.constEnd());;
-		min = *std::min_element(fluctuation.constBegin(), fluctuation.constEnd());;
-	}
-	else
-	{
-		xData.resize(resata.count());
-		for (int i = 0; i < resata.count(); ++i) {
-			xData[i] = double(i) / frequency;
-		}
-	}
-
 	// 创建时域图
 	auto tschart = new ScalableCustomPlot();
 	tschart->setTitle(QString("%1时域过程 测点%2").arg(_titleRootName, sensorName));
 	tschart->xAxis->setLabel("时间(s)");
 	tschart->yAxis->setLabel(QString("%1(%2)").arg(_titleRootName, _titleUnit));
-	tschart->xAxis->setRange(0, xData.last());
+	tschart->xAxis->setRange(0, duration);
 	tschart->yAxis->setRange(min, max);
 	tschart->yAxis->rescale(true);
 	//tschart->setOpenGl(true);
 	auto tsgraph = tschart->addGraph();
-	tsgraph->setData(xData, removemean? fluctuation :resata);
+	tsgraph->setData(xData, yData);
 	tsgraph->setPen(QPen(Qt::black));
 	tschart->setSelectableVisible(true);
 	tsgraph->setSelectable(QCP::stSingleData);
@@ -246,9 +298,6 @@ void ChartPainter::processSensorData(
 	timeSeriesMap[sensorName] = tschart;
 
 	// 创建频谱图
-	QVector<double> freqs;
-	QVector<double> pxx;
-	PSDA::calculatePowerSpectralDensity(fluctuation.data(), fluctuation.count(), frequency, freqs, pxx);
 	double maxY = *std::max_element(pxx.constBegin(), pxx.constEnd());
 	auto fschart = new ScalableCustomPlot();
 	fschart->setTitle(QString("频谱分析 测点%1").arg(sensorName));
@@ -10,24 +10,34 @@ public:
 	ChartPainter(const QString& name, const QString& unit) : _titleRootName(name), _titleUnit(unit) {}
 	virtual ~ChartPainter();
 
-	void setData(const ExtraData& exdata,bool removemean=false);
+	// 在调用线程中计算摘要后绘图；需要并行计算时用PsdEngine得到摘要后调用setSummary
+	void setData(const ExtraData& exdata,bool removemean=false, const PSDA::WelchConfig& config = PSDA::WelchConfig());
+	// 使用摘要(流式读取得到的降采样时域曲线与功率谱，或PsdEngine的计算结果)绘图，不需要原始数据
+	void setSummary(const ChartSummary& summary);
+	// 传感器的时频谱图(横轴时间、纵轴频率、颜色为功率谱密度dB)，之后通过getChart(sensorname, 3)获取
+	void setSpectrogram(const QString& sensorname, const PSDA::Spectrogram& spectrogram);
+	bool hasSpectrogram(const QString& sensorname) const { return _imgSpectrograms.contains(sensorname); }
 	void save(const QString& dirpath, int width, int height);
 	void saveSeg(const QString& dirpath, int width, int height);
 
+	// mode: 0-时域与频谱图 1-时域图 2-频谱图 3-时频谱图(须先setSpectrogram)
 	QWidget* getChart(const QString& sensorname, int mode);
 	QVector<QWidget*> getSegChart(const QString& sensorname, int mode);
 
 	QString getTiltleRootName() { return _titleRootName; }
 	QString getTiltleUnit() { return _titleUnit; }
 private:
-	void processSensorData(
+	void addSensorCharts(
 		const QString& sensorName,
-		double* sensorData,
-		int dataCount,
-		double frequency,
+		const QVector<double>& xData,
+		const QVector<double>& yData,
+		double duration,
+		double min,
+		double max,
+		const QVector<double>& freqs,
+		const QVector<double>& pxx,
 		QMap<QString, ScalableCustomPlot*>& timeSeriesMap,
-		QMap<QString, ScalableCustomPlot*>& frequencySpectrumMap,
-		bool removemean=false
+		QMap<QString, ScalableCustomPlot*>& frequencySpectrumMap
 	);
 
 private:
@@ -36,6 +46,7 @@ private:
 
 	QVector<QMap<QString, ScalableCustomPlot*>>_imgSegDataTimeSeries{};			//分段数据时域过程图
 	QVector<QMap<QString, ScalableCustomPlot*>>_imgSegDataFrequencySpectrum{};	//分段数据频谱分析图
+	QMap<QString, ScalableCustomPlot* >_imgSpectrograms{};		//时频谱图
 
 	QVector<QWidget*>_mixWidgets;//在返回时域和频谱图二合一的时候临时包装器
 
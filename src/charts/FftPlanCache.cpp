@@ -0,0 +1,202 @@
+#include "FftPlanCache.h"
+
+#include <mutex>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStandardPaths>
+
+namespace
+{
+	// 所有FFTW planner调用共用的锁
+	std::mutex& plannerMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	// 按(howmany, nfft)缓存的计划，进程结束时销毁
+	struct PlanRegistry
+	{
+		QHash<qint64, fftw_plan> plans{};
+		QHash<qint64, fftwf_plan> floatPlans{};
+
+		~PlanRegistry()
+		{
+			for (fftw_plan plan : plans) {
+				fftw_destroy_plan(plan);
+			}
+			for (fftwf_plan plan : floatPlans) {
+				fftwf_destroy_plan(plan);
+			}
+		}
+	};
+
+	PlanRegistry& registry()
+	{
+		static PlanRegistry instance;
+		return instance;
+	}
+
+	// 线程局部的缓冲，只增不减；fftw_malloc与fftwf_malloc的对齐方式相同，两种精度共用
+	template<typename Real, typename Complex>
+	struct ScratchBuffers
+	{
+		qint64 inCapacity{ 0 };
+		qint64 outCapacity{ 0 };
+		Real* in{ nullptr };
+		Complex* out{ nullptr };
+
+		~ScratchBuffers()
+		{
+			fftw_free(out);
+			fftw_free(in);
+		}
+
+		void reserve(qint64 inCount, qint64 outCount)
+		{
+			if (inCount > inCapacity) {
+				fftw_free(in);
+				in = static_cast<Real*>(fftw_malloc(sizeof(Real) * inCount));
+				inCapacity = inCount;
+			}
+			if (outCount > outCapacity) {
+				fftw_free(out);
+				out = static_cast<Complex*>(fftw_malloc(sizeof(Complex) * outCount));
+				outCapacity = outCount;
+			}
+		}
+	};
+
+	bool isPowerOfTwo(int value)
+	{
+		return value > 0 && (value & (value - 1)) == 0;
+	}
+
+	// 单精度wisdom的路径：与双精度wisdom同目录，文件名按库名加f
+	QString floatWisdomPath(const QString& path)
+	{
+		const QFileInfo info(path);
+		return info.path() + QString("/%1f.%2").arg(info.completeBaseName(), info.suffix());
+	}
+}
+
+fftw_plan PSDA::FftPlanCache::realForward(int nfft, int howmany)
+{
+	if (nfft <= 0 || howmany <= 0) {
+		return nullptr;
+	}
+	const qint64 key = (qint64(howmany) << 32) | quint32(nfft);
+	std::lock_guard<std::mutex> lock(plannerMutex());
+	PlanRegistry& cache = registry();
+	const auto it = cache.plans.constFind(key);
+	if (it != cache.plans.constEnd()) {
+		return it.value();
+	}
+
+	// FFTW_MEASURE会改写数组内容，用单独的缓冲创建计划；fftw_malloc保证与线程缓冲的对齐方式一致
+	const int outputSize = nfft / 2 + 1;
+	double* in = static_cast<double*>(fftw_malloc(sizeof(double) * nfft * howmany));
+	fftw_complex* out = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * outputSize * howmany));
+	const unsigned flags = isPowerOfTwo(nfft) ? FFTW_MEASURE : FFTW_ESTIMATE;
+	fftw_plan plan = howmany == 1
+		? fftw_plan_dft_r2c_1d(nfft, in, out, flags)
+		: fftw_plan_many_dft_r2c(1, &nfft, howmany, in, nullptr, 1, nfft, out, nullptr, 1, outputSize, flags);
+	fftw_free(out);
+	fftw_free(in);
+	if (!plan) {
+		qWarning() << "Failed to create FFT plan, nfft:" << nfft << "howmany:" << howmany;
+		return nullptr;
+	}
+	cache.plans.insert(key, plan);
+	return plan;
+}
+
+PSDA::FftPlanCache::Scratch PSDA::FftPlanCache::scratch(int nfft, int howmany)
+{
+	thread_local ScratchBuffers<double, fftw_complex> buffers;
+	buffers.reserve(qint64(nfft) * howmany, qint64(nfft / 2 + 1) * howmany);
+	return { buffers.in, buffers.out };
+}
+
+fftwf_plan PSDA::FftPlanCache::realForwardFloat(int nfft, int howmany)
+{
+	if (nfft <= 0 || howmany <= 0) {
+		return nullptr;
+	}
+	const qint64 key = (qint64(howmany) << 32) | quint32(nfft);
+	std::lock_guard<std::mutex> lock(plannerMutex());
+	PlanRegistry& cache = registry();
+	const auto it = cache.floatPlans.constFind(key);
+	if (it != cache.floatPlans.constEnd()) {
+		return it.value();
+	}
+
+	// 同realForward，用单独的缓冲创建计划
+	const int outputSize = nfft / 2 + 1;
+	float* in = static_cast<float*>(fftwf_malloc(sizeof(float) * nfft * howmany));
+	fftwf_complex* out = static_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * outputSize * howmany));
+	const unsigned flags = isPowerOfTwo(nfft) ? FFTW_MEASURE : FFTW_ESTIMATE;
+	fftwf_plan plan = howmany == 1
+		? fftwf_plan_dft_r2c_1d(nfft, in, out, flags)
+		: fftwf_plan_many_dft_r2c(1, &nfft, howmany, in, nullptr, 1, nfft, out, nullptr, 1, outputSize, flags);
+	fftwf_free(out);
+	fftwf_free(in);
+	if (!plan) {
+		qWarning() << "Failed to create float FFT plan, nfft:" << nfft << "howmany:" << howmany;
+		return nullptr;
+	}
+	cache.floatPlans.insert(key, plan);
+	return plan;
+}
+
+PSDA::FftPlanCache::ScratchF PSDA::FftPlanCache::scratchFloat(int nfft, int howmany)
+{
+	thread_local ScratchBuffers<float, fftwf_complex> buffers;
+	buffers.reserve(qint64(nfft) * howmany, qint64(nfft / 2 + 1) * howmany);
+	return { buffers.in, buffers.out };
+}
+
+QString PSDA::FftPlanCache::defaultWisdomPath()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QString("/fftw.wisdom");
+}
+
+bool PSDA::FftPlanCache::loadWisdom(const QString& path)
+{
+	if (!QFileInfo::exists(path)) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(plannerMutex());
+	if (!fftw_import_wisdom_from_filename(QFile::encodeName(path).constData())) {
+		qWarning() << "Failed to import FFTW wisdom:" << path;
+		return false;
+	}
+	const QString floatPath = floatWisdomPath(path);
+	if (QFileInfo::exists(floatPath) && !fftwf_import_wisdom_from_filename(QFile::encodeName(floatPath).constData())) {
+		qWarning() << "Failed to import FFTW float wisdom:" << floatPath;
+	}
+	return true;
+}
+
+bool PSDA::FftPlanCache::saveWisdom(const QString& path)
+{
+	if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+		qWarning() << "Failed to create FFTW wisdom directory:" << path;
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(plannerMutex());
+	if (!fftw_export_wisdom_to_filename(QFile::encodeName(path).constData())) {
+		qWarning() << "Failed to export FFTW wisdom:" << path;
+		return false;
+	}
+	const QString floatPath = floatWisdomPath(path);
+	if (!fftwf_export_wisdom_to_filename(QFile::encodeName(floatPath).constData())) {
+		qWarning() << "Failed to export FFTW float wisdom:" << floatPath;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QString>
+
+#include <fftw3.h>
+
+namespace PSDA
+{
+	/**
+	 * @brief FFTW计划缓存与线程局部的FFT缓冲
+	 *
+	 * FFTW的计划创建与wisdom读写不是线程安全的，统一在这里加锁完成；计划按nfft缓存到进程结束，
+	 * 使用时通过fftw_execute_dft_r2c作用在当前线程的缓冲上(执行是线程安全的)，
+	 * 因此逐段、逐传感器计算频谱时不再创建计划或分配内存。
+	 * 2的幂次长度(Welch分段的常用长度)使用FFTW_MEASURE，其余长度使用FFTW_ESTIMATE；
+	 * 测量结果通过wisdom文件跨进程复用，启动时读取、退出时保存。
+	 * 单精度(fftwf)的计划、缓冲与wisdom与双精度分开管理，用于只需显示精度的频谱(见PSDA::Precision)。
+	 */
+	namespace FftPlanCache
+	{
+		// 当前线程的FFT缓冲(fftw_malloc对齐)，in至少howmany*nfft个点，out至少howmany*(nfft/2+1)个点，线程结束时释放
+		struct Scratch
+		{
+			double* in{ nullptr };
+			fftw_complex* out{ nullptr };
+		};
+
+		// 单精度的线程缓冲，含义同Scratch
+		struct ScratchF
+		{
+			float* in{ nullptr };
+			fftwf_complex* out{ nullptr };
+		};
+
+		// nfft点实数到复数的正向FFT计划(非原位)，第一次请求时创建，由缓存持有，调用方不得销毁；
+		// howmany大于1时为批量计划，一次执行howmany个首尾相接的变换(输入间隔nfft，输出间隔nfft/2+1)
+		fftw_plan realForward(int nfft, int howmany = 1);
+		// 当前线程能容纳howmany个nfft点变换的缓冲，后续调用可能重新分配，不要跨调用保存指针
+		Scratch scratch(int nfft, int howmany = 1);
+		// 单精度的计划与缓冲，用法同realForward/scratch
+		fftwf_plan realForwardFloat(int nfft, int howmany = 1);
+		ScratchF scratchFloat(int nfft, int howmany = 1);
+
+		// 默认的wisdom文件路径(应用本地数据目录)
+		QString defaultWisdomPath();
+		// 读取wisdom(单精度的wisdom在同目录的fftwf.wisdom中，不存在时忽略)，文件不存在或格式不符时返回false
+		bool loadWisdom(const QString& path);
+		// 保存当前的双精度与单精度wisdom，目录不存在时创建
+		bool saveWisdom(const QString& path);
+	};
+}
@@ -0,0 +1,525 @@
+#include "FilterBank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <QDebug>
+
+#include "app/StatsKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FILTER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define FILTER_TARGET_SSE2
+#define FILTER_TARGET_AVX2
+#else
+#define FILTER_TARGET_SSE2 __attribute__((target("sse2")))
+#define FILTER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	using PSDA::Biquad;
+	typedef std::complex<double> Complex;
+	constexpr int LANES = PSDA::FilterBank::LANES;
+	constexpr double PI = 3.14159265358979323846;
+
+	// 零极点增益形式
+	struct Zpk
+	{
+		std::vector<Complex> zeros{};
+		std::vector<Complex> poles{};
+		double gain{ 1.0 };
+	};
+
+	// 巴特沃斯原型：单位圆左半平面上均匀分布的极点
+	Zpk butterworthPrototype(int order)
+	{
+		Zpk zpk;
+		for (int m = -order + 1; m < order; m += 2) {
+			zpk.poles.push_back(-std::exp(Complex(0.0, PI * m / (2.0 * order))));
+		}
+		return zpk;
+	}
+
+	// 切比雪夫I型原型，偶数阶时直流增益为通带波纹的下限
+	Zpk chebyshev1Prototype(int order, double rippleDb)
+	{
+		Zpk zpk;
+		const double eps = std::sqrt(std::pow(10.0, 0.1 * rippleDb) - 1.0);
+		const double mu = std::asinh(1.0 / eps) / order;
+		Complex product(1.0, 0.0);
+		for (int m = -order + 1; m < order; m += 2) {
+			const Complex pole = -std::sinh(Complex(mu, PI * m / (2.0 * order)));
+			zpk.poles.push_back(pole);
+			product *= -pole;
+		}
+		zpk.gain = product.real();
+		if (order % 2 == 0) {
+			zpk.gain /= std::sqrt(1.0 + eps * eps);
+		}
+		return zpk;
+	}
+
+	// 贝塞尔原型(相位归一化)：反向贝塞尔多项式的根缩放到渐近线与巴特沃斯相同
+	Zpk besselPrototype(int order)
+	{
+		// 1. 多项式系数 a_k = (2N-k)! / (2^(N-k)·k!·(N-k)!)，a_N = 1；变量按a_0^(1/N)缩放后 c_k = a_k / a_0^((N-k)/N)，
+		//    首尾系数均为1(在对数域计算，避免阶乘溢出)
+		auto logCoefficient = [order](int k) {
+			return std::lgamma(2.0 * order - k + 1) - (order - k) * std::log(2.0) - std::lgamma(k + 1.0) - std::lgamma(order - k + 1.0);
+		};
+		const double logA0 = logCoefficient(0);
+		std::vector<double> c(order + 1);
+		for (int k = 0; k <= order; ++k) {
+			c[k] = std::exp(logCoefficient(k) - logA0 * (order - k) / order);
+		}
+
+		// 2. Durand-Kerner迭代求全部根
+		std::vector<Complex> roots(order);
+		for (int k = 0; k < order; ++k) {
+			roots[k] = std::pow(Complex(0.4, 0.9), k);
+		}
+		for (int iteration = 0; iteration < 500; ++iteration) {
+			double change = 0.0;
+			for (int k = 0; k < order; ++k) {
+				Complex value(c[order], 0.0);
+				for (int i = order - 1; i >= 0; --i) {
+					value = value * roots[k] + c[i];
+				}
+				Complex denominator(1.0, 0.0);
+				for (int j = 0; j < order; ++j) {
+					if (j != k) {
+						denominator *= roots[k] - roots[j];
+					}
+				}
+				const Complex delta = value / denominator;
+				roots[k] -= delta;
+				change = std::max(change, std::abs(delta));
+			}
+			if (change < 1e-15) {
+				break;
+			}
+		}
+		Zpk zpk;
+		for (const Complex& root : roots) {
+			zpk.poles.push_back(std::abs(root.imag()) < 1e-12 ? Complex(root.real(), 0.0) : root);
+		}
+		return zpk;
+	}
+
+	// 模拟低通原型(截止频率1 rad/s)变换为截止频率wo的低通、高通，或[w1, w2]的带通
+	Zpk transformPrototype(const Zpk& prototype, PSDA::FilterBand band, double w1, double w2)
+	{
+		Zpk zpk;
+		const int degree = int(prototype.poles.size() - prototype.zeros.size());
+		switch (band) {
+		case PSDA::FilterBand::LowPass:
+			for (const Complex& z : prototype.zeros) {
+				zpk.zeros.push_back(z * w1);
+			}
+			for (const Complex& p : prototype.poles) {
+				zpk.poles.push_back(p * w1);
+			}
+			zpk.gain = prototype.gain * std::pow(w1, degree);
+			break;
+		case PSDA::FilterBand::HighPass: {
+			Complex numerator(1.0, 0.0), denominator(1.0, 0.0);
+			for (const Complex& z : prototype.zeros) {
+				zpk.zeros.push_back(w1 / z);
+				numerator *= -z;
+			}
+			for (const Complex& p : prototype.poles) {
+				zpk.poles.push_back(w1 / p);
+				denominator *= -p;
+			}
+			zpk.zeros.insert(zpk.zeros.end(), degree, Complex(0.0, 0.0));
+			zpk.gain = prototype.gain * (numerator / denominator).real();
+			break;
+		}
+		case PSDA::FilterBand::BandPass: {
+			const double bandwidth = w2 - w1;
+			const double center = std::sqrt(w1 * w2);
+			auto split = [&](const std::vector<Complex>& roots, std::vector<Complex>& out) {
+				for (const Complex& root : roots) {
+					const Complex scaled = root * (bandwidth / 2.0);
+					const Complex offset = std::sqrt(scaled * scaled - center * center);
+					out.push_back(scaled + offset);
+					out.push_back(scaled - offset);
+				}
+			};
+			split(prototype.zeros, zpk.zeros);
+			split(prototype.poles, zpk.poles);
+			zpk.zeros.insert(zpk.zeros.end(), degree, Complex(0.0, 0.0));
+			zpk.gain = prototype.gain * std::pow(bandwidth, degree);
+			break;
+		}
+		}
+		return zpk;
+	}
+
+	// 双线性变换，无穷远处的零点映射到z = -1
+	Zpk bilinear(const Zpk& analog, double sampleRate)
+	{
+		const double fs2 = 2.0 * sampleRate;
+		Zpk digital;
+		Complex numerator(1.0, 0.0), denominator(1.0, 0.0);
+		for (const Complex& z : analog.zeros) {
+			digital.zeros.push_back((fs2 + z) / (fs2 - z));
+			numerator *= fs2 - z;
+		}
+		for (const Complex& p : analog.poles) {
+			digital.poles.push_back((fs2 + p) / (fs2 - p));
+			denominator *= fs2 - p;
+		}
+		digital.zeros.insert(digital.zeros.end(), analog.poles.size() - analog.zeros.size(), Complex(-1.0, 0.0));
+		digital.gain = analog.gain * (numerator / denominator).real();
+		return digital;
+	}
+
+	// 零极点分组为二阶节：共轭极点对或两个实极点为一节，零点(均为实数)按节的极点数分配，
+	// 同时有+1与-1两种零点时(带通)每节各取一个
+	bool zpkToSections(const Zpk& zpk, QVector<Biquad>& sections)
+	{
+		struct PoleGroup
+		{
+			double a1{ 0.0 };
+			double a2{ 0.0 };
+			int count{ 0 };
+			double radius{ 0.0 };
+		};
+		std::vector<PoleGroup> groups;
+		std::vector<double> realPoles;
+		for (const Complex& p : zpk.poles) {
+			if (std::abs(p) >= 1.0) {
+				return false;
+			}
+			if (std::abs(p.imag()) < 1e-12) {
+				realPoles.push_back(p.real());
+			}
+			else if (p.imag() > 0.0) {
+				groups.push_back({ -2.0 * p.real(), std::norm(p), 2, std::abs(p) });
+			}
+		}
+		std::sort(realPoles.begin(), realPoles.end(), [](double l, double r) { return std::abs(l) < std::abs(r); });
+		for (size_t i = 0; i < realPoles.size(); i += 2) {
+			if (i + 1 < realPoles.size()) {
+				groups.push_back({ -(realPoles[i] + realPoles[i + 1]), realPoles[i] * realPoles[i + 1], 2, std::abs(realPoles[i + 1]) });
+			}
+			else {
+				groups.push_back({ -realPoles[i], 0.0, 1, std::abs(realPoles[i]) });
+			}
+		}
+		std::stable_sort(groups.begin(), groups.end(), [](const PoleGroup& l, const PoleGroup& r) { return l.radius < r.radius; });
+
+		int positive = 0, negative = 0;
+		for (const Complex& z : zpk.zeros) {
+			(z.real() > 0.0 ? positive : negative)++;
+		}
+		sections.clear();
+		for (const PoleGroup& group : groups) {
+			// 一阶节：(1 - z·z^-1)；二阶节：(1 - (z1 + z2)·z^-1 + z1·z2·z^-2)
+			double zeros[2] = { 0.0, 0.0 };
+			for (int i = 0; i < group.count; ++i) {
+				if (positive >= negative && positive > 0) {
+					zeros[i] = 1.0;
+					--positive;
+				}
+				else if (negative > 0) {
+					zeros[i] = -1.0;
+					--negative;
+				}
+			}
+			Biquad section;
+			section.b0 = 1.0;
+			section.b1 = group.count == 2 ? -(zeros[0] + zeros[1]) : -zeros[0];
+			section.b2 = group.count == 2 ? zeros[0] * zeros[1] : 0.0;
+			section.a1 = group.a1;
+			section.a2 = group.a2;
+			sections.append(section);
+		}
+		if (sections.isEmpty()) {
+			return false;
+		}
+		sections[0].b0 *= zpk.gain;
+		sections[0].b1 *= zpk.gain;
+		sections[0].b2 *= zpk.gain;
+		return true;
+	}
+
+	/**
+	 * @brief 逐点实现：width路交错数据依次通过各二阶节，原位写回
+	 *
+	 * data指向第一个采样点，每个采样点width个值(width不超过LANES)，stride为相邻采样点的间隔(反向滤波时为负)；
+	 * state为各节的z1、z2，[节][z1/z2][路]
+	 */
+	void scalarSections(double* data, qint64 count, qint64 stride, int width, const Biquad* sections, int sectionCount, double* state)
+	{
+		for (qint64 i = 0; i < count; ++i, data += stride) {
+			for (int s = 0; s < sectionCount; ++s) {
+				const Biquad& q = sections[s];
+				double* z1 = state + s * 2 * width;
+				double* z2 = z1 + width;
+				for (int l = 0; l < width; ++l) {
+					const double x = data[l];
+					const double y = q.b0 * x + z1[l];
+					z1[l] = q.b1 * x - q.a1 * y + z2[l];
+					z2[l] = q.b2 * x - q.a2 * y;
+					data[l] = y;
+				}
+			}
+		}
+	}
+
+#ifdef FILTER_X86
+	// 每个采样点的width路为width/2个128位向量，计算顺序与逐点实现相同(不使用FMA)，结果逐点一致
+	FILTER_TARGET_SSE2 void sse2Sections(double* data, qint64 count, qint64 stride, int width, const Biquad* sections, int sectionCount, double* state)
+	{
+		const int vectors = width / 2;
+		for (qint64 i = 0; i < count; ++i, data += stride) {
+			__m128d x[LANES / 2];
+			for (int v = 0; v < vectors; ++v) {
+				x[v] = _mm_loadu_pd(data + 2 * v);
+			}
+			for (int s = 0; s < sectionCount; ++s) {
+				const Biquad& q = sections[s];
+				const __m128d b0 = _mm_set1_pd(q.b0), b1 = _mm_set1_pd(q.b1), b2 = _mm_set1_pd(q.b2);
+				const __m128d a1 = _mm_set1_pd(q.a1), a2 = _mm_set1_pd(q.a2);
+				double* z1 = state + s * 2 * width;
+				double* z2 = z1 + width;
+				for (int v = 0; v < vectors; ++v) {
+					const __m128d y = _mm_add_pd(_mm_mul_pd(b0, x[v]), _mm_loadu_pd(z1 + 2 * v));
+					_mm_storeu_pd(z1 + 2 * v, _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, x[v]), _mm_mul_pd(a1, y)), _mm_loadu_pd(z2 + 2 * v)));
+					_mm_storeu_pd(z2 + 2 * v, _mm_sub_pd(_mm_mul_pd(b2, x[v]), _mm_mul_pd(a2, y)));
+					x[v] = y;
+				}
+			}
+			for (int v = 0; v < vectors; ++v) {
+				_mm_storeu_pd(data + 2 * v, x[v]);
+			}
+		}
+	}
+
+	// 每个采样点的width路为width/4个256位向量，各向量互不依赖，可以交替发射
+	FILTER_TARGET_AVX2 void avx2Sections(double* data, qint64 count, qint64 stride, int width, const Biquad* sections, int sectionCount, double* state)
+	{
+		const int vectors = width / 4;
+		for (qint64 i = 0; i < count; ++i, data += stride) {
+			__m256d x[LANES / 4];
+			for (int v = 0; v < vectors; ++v) {
+				x[v] = _mm256_loadu_pd(data + 4 * v);
+			}
+			for (int s = 0; s < sectionCount; ++s) {
+				const Biquad& q = sections[s];
+				const __m256d b0 = _mm256_set1_pd(q.b0), b1 = _mm256_set1_pd(q.b1), b2 = _mm256_set1_pd(q.b2);
+				const __m256d a1 = _mm256_set1_pd(q.a1), a2 = _mm256_set1_pd(q.a2);
+				double* z1 = state + s * 2 * width;
+				double* z2 = z1 + width;
+				for (int v = 0; v < vectors; ++v) {
+					const __m256d y = _mm256_add_pd(_mm256_mul_pd(b0, x[v]), _mm256_loadu_pd(z1 + 4 * v));
+					_mm256_storeu_pd(z1 + 4 * v, _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(b1, x[v]), _mm256_mul_pd(a1, y)), _mm256_loadu_pd(z2 + 4 * v)));
+					_mm256_storeu_pd(z2 + 4 * v, _mm256_sub_pd(_mm256_mul_pd(b2, x[v]), _mm256_mul_pd(a2, y)));
+					x[v] = y;
+				}
+			}
+			for (int v = 0; v < vectors; ++v) {
+				_mm256_storeu_pd(data + 4 * v, x[v]);
+			}
+		}
+	}
+#endif
+
+	typedef void(*SectionFunction)(double*, qint64, qint64, int, const Biquad*, int, double*);
+
+	// 实现及其每个向量的路数，一组的路数须为其整数倍
+	struct SectionKernel
+	{
+		SectionFunction function{ nullptr };
+		int granularity{ 1 };
+	};
+
+	SectionKernel selectKernel()
+	{
+		switch (STATS::activeIsa()) {
+#ifdef FILTER_X86
+		case STATS::Isa::AVX2:
+			return { &avx2Sections, 4 };
+		case STATS::Isa::SSE2:
+			return { &sse2Sections, 2 };
+#endif
+		default:
+			return { &scalarSections, 1 };
+		}
+	}
+
+	// 一组lanes个通道交错存放的路数：单通道用逐点实现不补空路，其余按向量宽度向上取整
+	int groupWidth(int lanes, const SectionKernel& kernel)
+	{
+		if (lanes <= 1) {
+			return 1;
+		}
+		return (lanes + kernel.granularity - 1) / kernel.granularity * kernel.granularity;
+	}
+
+	// 各节初始状态 = 单位阶跃稳态 × 端点值
+	void initialState(const QVector<double>& steadyState, const double* first, int width, double* state)
+	{
+		for (int s = 0; s < steadyState.count() / 2; ++s) {
+			for (int l = 0; l < width; ++l) {
+				state[s * 2 * width + l] = steadyState[2 * s] * first[l];
+				state[s * 2 * width + width + l] = steadyState[2 * s + 1] * first[l];
+			}
+		}
+	}
+}
+
+bool PSDA::designFilter(const FilterDesign& design, double sampleRate, QVector<Biquad>& sections)
+{
+	// 1. 参数校验
+	const double nyquist = 0.5 * sampleRate;
+	const bool bandPass = design.band == FilterBand::BandPass;
+	if (sampleRate <= 0 || design.order < 1 || design.order > 20
+		|| design.low <= 0 || design.low >= nyquist
+		|| (bandPass && (design.high <= design.low || design.high >= nyquist))
+		|| (design.family == FilterFamily::Chebyshev1 && design.rippleDb <= 0)) {
+		qWarning() << "Invalid parameters in designFilter:"
+			<< "Order:" << design.order
+			<< "| Fs:" << sampleRate
+			<< "| Low:" << design.low
+			<< "| High:" << design.high;
+		return false;
+	}
+
+	// 2. 模拟原型
+	Zpk prototype;
+	switch (design.family) {
+	case FilterFamily::Butterworth:
+		prototype = butterworthPrototype(design.order);
+		break;
+	case FilterFamily::Chebyshev1:
+		prototype = chebyshev1Prototype(design.order, design.rippleDb);
+		break;
+	case FilterFamily::Bessel:
+		prototype = besselPrototype(design.order);
+		break;
+	}
+
+	// 3. 预畸变后做频率变换与双线性变换
+	const double w1 = 2.0 * sampleRate * std::tan(PI * design.low / sampleRate);
+	const double w2 = bandPass ? 2.0 * sampleRate * std::tan(PI * design.high / sampleRate) : 0.0;
+	const Zpk digital = bilinear(transformPrototype(prototype, design.band, w1, w2), sampleRate);
+	QVector<Biquad> result;
+	if (!zpkToSections(digital, result)) {
+		qWarning() << "Unstable filter design, order:" << design.order << "low:" << design.low << "high:" << design.high;
+		return false;
+	}
+	sections = result;
+	return true;
+}
+
+PSDA::FilterBank::FilterBank(const QVector<Biquad>& sections)
+	: _sections(sections)
+{
+	// 单位阶跃输入下转置直接II型的稳态：y = Σb/Σa，z1 = y - b0，z2 = b2 - a2·y；
+	// 后一节的输入为前面各节的直流增益
+	double scale = 1.0;
+	for (const Biquad& q : _sections) {
+		const double gain = (q.b0 + q.b1 + q.b2) / (1.0 + q.a1 + q.a2);
+		_steadyState.append(scale * (gain - q.b0));
+		_steadyState.append(scale * (q.b2 - q.a2 * gain));
+		scale *= gain;
+	}
+}
+
+bool PSDA::FilterBank::design(const FilterDesign& design, double sampleRate)
+{
+	QVector<Biquad> sections;
+	if (!designFilter(design, sampleRate, sections)) {
+		return false;
+	}
+	*this = FilterBank(sections);
+	return true;
+}
+
+int PSDA::FilterBank::padLength() const
+{
+	// 与sosfiltfilt相同：3倍的等效抽头数，一阶节少计一个
+	int firstOrder = 0;
+	for (const Biquad& q : _sections) {
+		if (q.b2 == 0.0 && q.a2 == 0.0) {
+			++firstOrder;
+		}
+	}
+	return 3 * (2 * _sections.count() + 1 - firstOrder);
+}
+
+void PSDA::FilterBank::filter(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count) const
+{
+	run(inputs, outputs, count, false);
+}
+
+void PSDA::FilterBank::filtfilt(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count) const
+{
+	run(inputs, outputs, count, true);
+}
+
+void PSDA::FilterBank::run(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count, bool zeroPhase) const
+{
+	if (_sections.isEmpty() || count <= 0 || inputs.count() != outputs.count()) {
+		return;
+	}
+	const int pad = zeroPhase ? qMin(padLength(), count - 1) : 0;
+	const qint64 total = qint64(count) + 2 * pad;
+	const int sectionCount = _sections.count();
+	const SectionKernel kernel = selectKernel();
+
+	// 交错缓冲按第一组(最宽的一组)分配，本次调用的各组共用，返回时释放
+	std::vector<double> buffer(size_t(total) * size_t(groupWidth(qMin(LANES, inputs.count()), kernel)));
+	std::vector<double> state;
+
+	for (int first = 0; first < inputs.count(); first += LANES) {
+		const int lanes = qMin(LANES, inputs.count() - first);
+		const int width = groupWidth(lanes, kernel);
+		const SectionFunction filterSections = width == 1 ? &scalarSections : kernel.function;
+		state.assign(size_t(sectionCount) * 2 * width, 0.0);
+
+		// 1. 一组通道交错写入缓冲，两端奇延拓：x[-i] = 2·x[0] - x[i]，x[n-1+i] = 2·x[n-1] - x[n-1-i]；空余的路置零
+		for (int l = 0; l < width; ++l) {
+			const double* src = l < lanes ? inputs[first + l] : nullptr;
+			double* dst = buffer.data() + l;
+			for (int i = 0; i < pad; ++i) {
+				dst[qint64(i) * width] = src ? 2.0 * src[0] - src[pad - i] : 0.0;
+			}
+			for (int i = 0; i < count; ++i) {
+				dst[qint64(pad + i) * width] = src ? src[i] : 0.0;
+			}
+			for (int i = 0; i < pad; ++i) {
+				dst[qint64(pad + count + i) * width] = src ? 2.0 * src[count - 1] - src[count - 2 - i] : 0.0;
+			}
+		}
+
+		// 2. 前向滤波；零相位时再从末端反向滤波一次
+		if (zeroPhase) {
+			initialState(_steadyState, buffer.data(), width, state.data());
+		}
+		filterSections(buffer.data(), total, width, width, _sections.constData(), sectionCount, state.data());
+		if (zeroPhase) {
+			double* last = buffer.data() + (total - 1) * width;
+			initialState(_steadyState, last, width, state.data());
+			filterSections(last, total, -width, width, _sections.constData(), sectionCount, state.data());
+		}
+
+		// 3. 去掉补点后写回各通道
+		for (int l = 0; l < lanes; ++l) {
+			const double* src = buffer.data() + qint64(pad) * width + l;
+			double* dst = outputs[first + l];
+			for (int i = 0; i < count; ++i) {
+				dst[i] = src[qint64(i) * width];
+			}
+		}
+	}
+}
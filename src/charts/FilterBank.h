@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QVector>
+
+namespace PSDA
+{
+	// 模拟原型
+	enum class FilterFamily { Butterworth, Chebyshev1, Bessel };
+	// 通带类型
+	enum class FilterBand { LowPass, HighPass, BandPass };
+
+	/**
+	 * @brief IIR滤波器设计参数
+	 *
+	 * 模拟原型经频率变换后按双线性变换(预畸变)得到数字滤波器，与scipy.signal的butter/cheby1/bessel(norm='phase')一致。
+	 * 低通、高通的截止频率为low，带通为[low, high]，带通的阶数为原型阶数(实际为2*order阶)。
+	 */
+	struct FilterDesign
+	{
+		FilterFamily family{ FilterFamily::Butterworth };
+		FilterBand band{ FilterBand::HighPass };
+		int order{ 2 };				//原型阶数[1, 20]
+		double low{ 0.0 };			//截止频率(Hz)
+		double high{ 0.0 };			//带通的上截止频率(Hz)
+		double rippleDb{ 1.0 };		//切比雪夫I型的通带波纹(dB)
+	};
+
+	// 二阶节 H(z) = (b0 + b1·z^-1 + b2·z^-2) / (1 + a1·z^-1 + a2·z^-2)
+	struct Biquad
+	{
+		double b0{ 1.0 };
+		double b1{ 0.0 };
+		double b2{ 0.0 };
+		double a1{ 0.0 };
+		double a2{ 0.0 };
+	};
+
+	/**
+	 * @brief 设计数字滤波器，输出级联的二阶节
+	 *
+	 * 共轭极点对为一节，实极点两两为一节(奇数阶时最后一节为一阶)，靠近单位圆的节排在后面，总增益在第一节。
+	 *
+	 * @return bool 参数无效或结果不稳定时返回false
+	 */
+	bool designFilter(const FilterDesign& design, double sampleRate, QVector<Biquad>& sections);
+
+	/**
+	 * @brief 多通道二阶节滤波器组
+	 *
+	 * 各通道使用同一组二阶节(转置直接II型)。通道按最多LANES路一组交错存放，每个采样点的一组通道用SIMD同时计算，
+	 * 多个通道一次调用即可按组各扫描一遍，而不是逐个通道分别滤波。不足LANES路的一组按向量宽度向上取整，
+	 * 单通道不交错、不补空路。运行时按CPU支持的指令集选择AVX2/SSE2/标量实现(见STATS::activeIsa)，
+	 * 各实现、各分组方式的逐点结果相同。交错缓冲为(count+2·padLength)×每组路数，在调用期间分配。
+	 * filtfilt为零相位滤波：两端按奇延拓补padLength个点，前向、反向各滤波一次，初始状态取稳态值乘以端点值，
+	 * 与scipy.signal.sosfiltfilt一致。
+	 */
+	class FilterBank
+	{
+	public:
+		// 每组最多同时计算的通道数
+		static constexpr int LANES = 8;
+
+		FilterBank() = default;
+		explicit FilterBank(const QVector<Biquad>& sections);
+
+		// 按design重新设计，失败时保持原有的节
+		bool design(const FilterDesign& design, double sampleRate);
+		const QVector<Biquad>& sections() const { return _sections; }
+		bool isValid() const { return !_sections.isEmpty(); }
+		// filtfilt在两端各补的点数(数据不足时为count-1)
+		int padLength() const;
+
+		// 因果滤波，初始状态为0；outputs[i]可以与inputs[i]相同，各通道count个点
+		void filter(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count) const;
+		// 零相位滤波；outputs[i]可以与inputs[i]相同，各通道count个点
+		void filtfilt(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count) const;
+
+	private:
+		void run(const QVector<const double*>& inputs, const QVector<double*>& outputs, int count, bool zeroPhase) const;
+
+		QVector<Biquad> _sections{};
+		QVector<double> _steadyState{};	//单位阶跃输入下各节的稳态z1、z2(已乘以前面各节的直流增益)
+	};
+};
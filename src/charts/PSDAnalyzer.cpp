@@ -1,10 +1,379 @@
 #include "PSDAnalyzer.h"
 
 #include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include <QDebug>
 #include <QtMath>
 
+#include "FftPlanCache.h"
+#include "FilterBank.h"
+
+namespace
+{
+	// preprocessData的实现，T为存储精度(double或float)，累加与输出均为double
+	template<typename T>
+	bool preprocessSamples(
+		const T* data,
+		int datacount,
+		QVector<double>& resData,
+		QVector<double>& romData,
+		QVector<double>& fluctuation,
+		double& resmin,
+		double& resmax,
+		int order,
+		double sigmaThreshold
+	)
+	{
+		// 参数校验
+		if (!data || datacount <= 0 || order <= 0) {
+			qWarning() << "Invalid input parameters";
+			return false;
+		}
+		// 计算完整段数,向下取整，多的直接不要了（不过在完整处理逻辑上，前面读取原始数据的时候就已经按order采样频率取整了）
+		const int numSegments = datacount / order;
+		if (numSegments == 0) {
+			qDebug() << "Data size too small for segmentation";
+			return false;
+		}
+
+		resData.resize(numSegments * order);
+		romData.resize(numSegments);
+		fluctuation.resize(numSegments * order);
+
+		// 预分配内存
+		//QVector<double> romData(numSegments);
+		QVector<double> segmentStdDevs(numSegments);
+		// 一次性计算均值和标准差
+		for (int seg = 0; seg < numSegments; ++seg) {
+			const int startIdx = seg * order;
+			double sum = 0.0;
+			double sumSq = 0.0;
+
+			// 计算段内和与平方和
+			for (int i = 0; i < order; ++i) {
+				const double val = data[startIdx + i];
+				resData[startIdx + i] = val; // 直接赋值到resData
+				if (0 == seg)
+				{
+					resmin = resmax = val;
+				}
+				else
+				{
+					resmin = qMin(resmin, val);
+					resmax = qMax(resmax, val);
+				}
+				sum += val;
+				sumSq += val * val;
+			}
+
+			const double mean = sum / order;
+			romData[seg] = mean;
+			segmentStdDevs[seg] = sqrt((sumSq - sum * sum / order) / order);
+		}
+
+		// 筛选有效波动数据
+		for (int i = 0; i < fluctuation.count(); ++i) {
+			const int seg = i / order;
+			double residual = data[i] - romData[seg];
+			const double dev = segmentStdDevs[seg];
+			if (dev < 0 || std::abs(residual) > sigmaThreshold * dev) {
+				residual = romData[seg];
+			}
+			fluctuation[i] = residual;
+		}
+		return true;
+	}
+
+	// 批量计算频谱时每次执行的FFT数量，4096点时输入输出缓冲约1MB
+	constexpr int PSD_BATCH = 16;
+
+	// 零阶第一类修正贝塞尔函数(Kaiser窗)，级数求和至收敛
+	double besselI0(double x)
+	{
+		const double quarter = x * x / 4.0;
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 1000; ++k) {
+			term *= quarter / (double(k) * k);
+			sum += term;
+			if (term < sum * 1e-17) {
+				break;
+			}
+		}
+		return sum;
+	}
+
+	// 余弦和窗 Σ(-1)^k * a[k] * cos(2πki/(N-1))
+	void cosineSumWindow(std::initializer_list<double> coefficients, std::vector<double>& window)
+	{
+		const int length = static_cast<int>(window.size());
+		for (int i = 0; i < length; ++i) {
+			double value = 0.0;
+			double sign = 1.0;
+			int k = 0;
+			for (double a : coefficients) {
+				value += sign * a * cos(2 * M_PI * k * i / (length - 1));
+				sign = -sign;
+				++k;
+			}
+			window[i] = value;
+		}
+	}
+
+	std::vector<double> makeWindow(PSDA::WindowType type, int length, double kaiserBeta)
+	{
+		std::vector<double> window(length, 1.0);
+		if (length < 2) {
+			return window;
+		}
+		switch (type) {
+		case PSDA::WindowType::Hann:
+			for (int i = 0; i < length; ++i) {
+				window[i] = 0.5 * (1 - cos(2 * M_PI * i / (length - 1)));
+			}
+			break;
+		case PSDA::WindowType::Hamming:
+			cosineSumWindow({ 0.54, 0.46 }, window);
+			break;
+		case PSDA::WindowType::BlackmanHarris:
+			cosineSumWindow({ 0.35875, 0.48829, 0.14128, 0.01168 }, window);
+			break;
+		case PSDA::WindowType::FlatTop:
+			cosineSumWindow({ 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 }, window);
+			break;
+		case PSDA::WindowType::Kaiser:
+		{
+			const double denominator = besselI0(kaiserBeta);
+			for (int i = 0; i < length; ++i) {
+				const double ratio = 2.0 * i / (length - 1) - 1.0;
+				window[i] = besselI0(kaiserBeta * sqrt(qMax(0.0, 1.0 - ratio * ratio))) / denominator;
+			}
+			break;
+		}
+		}
+		return window;
+	}
+
+	// Welch方法的分段参数与窗函数，WelchAccumulator与批量计算共用
+	struct WelchSetup
+	{
+		int nfft{ 0 };
+		int overlap{ 0 };
+		int maxSegments{ 0 };			//总点数能完整切出的段数
+		double scaleFactor{ 0.0 };
+		std::shared_ptr<const std::vector<double>> window{};
+	};
+
+	WelchSetup welchSetup(int datacount, double sampleFrequency, const PSDA::WelchConfig& config)
+	{
+		WelchSetup setup;
+		// 1. 确定FFT点数(未指定时按数据点数取2的幂次，平衡性能与分辨率)
+		int nfft = config.nfft;
+		if (nfft <= 0) {
+			nfft = qNextPowerOfTwo(qMax(datacount, 1));
+			nfft = qBound(config.minNfft, qMin(nfft, datacount), config.maxNfft);
+		}
+		nfft = qMax(nfft, 2);
+		setup.nfft = nfft;
+		setup.overlap = qBound(0, static_cast<int>(nfft * config.overlap), nfft - 1);
+		setup.maxSegments = qMax(1, (datacount - setup.overlap) / (nfft - setup.overlap)); // 确保至少1段
+
+		// 2. 窗函数(缓存)与归一化系数
+		setup.window = PSDA::windowCoefficients(config.window, nfft, config.kaiserBeta);
+		double windowEnergySum = 0.0; // 用于归一化的窗函数能量总和
+		for (double w : *setup.window) {
+			windowEnergySum += w * w;
+		}
+		setup.scaleFactor = 1.0 / (sampleFrequency * windowEnergySum * nfft);
+		return setup;
+	}
+
+	// 一段数据去趋势、加窗后写入dst，Real为FFT输入的精度(去趋势与加窗按double计算)
+	template<typename Real>
+	void prepareSegment(const double* src, const double* window, int nfft, PSDA::DetrendMode detrend, Real* dst)
+	{
+		double offset = 0.0;
+		double slope = 0.0;
+		if (detrend == PSDA::DetrendMode::Mean) {
+			double sum = 0.0;
+			for (int i = 0; i < nfft; ++i) {
+				sum += src[i];
+			}
+			offset = sum / nfft;
+		}
+		else if (detrend == PSDA::DetrendMode::Linear) {
+			// 最小二乘拟合 offset + slope * i
+			double sum = 0.0, weighted = 0.0;
+			for (int i = 0; i < nfft; ++i) {
+				sum += src[i];
+				weighted += i * src[i];
+			}
+			const double n = nfft;
+			const double sumI = n * (n - 1) / 2;
+			const double sumII = (n - 1) * n * (2 * n - 1) / 6;
+			slope = (n * weighted - sumI * sum) / (n * sumII - sumI * sumI);
+			offset = (sum - slope * sumI) / n;
+		}
+		for (int i = 0; i < nfft; ++i) {
+			dst[i] = static_cast<Real>((src[i] - offset - slope * i) * window[i]);
+		}
+	}
+
+	// 批量FFT计划与当前线程的缓冲，按精度选择fftw/fftwf接口
+	template<typename Real>
+	struct BatchFft;
+
+	template<>
+	struct BatchFft<double>
+	{
+		fftw_plan plan{ nullptr };
+		double* in{ nullptr };
+		fftw_complex* out{ nullptr };
+
+		explicit BatchFft(int nfft)
+			: plan(PSDA::FftPlanCache::realForward(nfft, PSD_BATCH))
+		{
+			const PSDA::FftPlanCache::Scratch scratch = PSDA::FftPlanCache::scratch(nfft, PSD_BATCH);
+			in = scratch.in;
+			out = scratch.out;
+		}
+		void execute() { fftw_execute_dft_r2c(plan, in, out); }
+	};
+
+	template<>
+	struct BatchFft<float>
+	{
+		fftwf_plan plan{ nullptr };
+		float* in{ nullptr };
+		fftwf_complex* out{ nullptr };
+
+		explicit BatchFft(int nfft)
+			: plan(PSDA::FftPlanCache::realForwardFloat(nfft, PSD_BATCH))
+		{
+			const PSDA::FftPlanCache::ScratchF scratch = PSDA::FftPlanCache::scratchFloat(nfft, PSD_BATCH);
+			in = scratch.in;
+			out = scratch.out;
+		}
+		void execute() { fftwf_execute_dft_r2c(plan, in, out); }
+	};
+
+	/**
+	 * 依次计算count个nfft点变换的功率谱(未归一化的|X|²)，每批PSD_BATCH个执行一次批量计划，最后不足一批时其余输入置零
+	 * (批内各变换的起点不一定满足计划的对齐要求，所以不逐个执行)。
+	 * prepare(k, in)写入第k个变换的输入，consume(k, power)按顺序接收第k个变换的功率谱；计划创建失败时返回false
+	 */
+	template<typename Real, typename Prepare, typename Consume>
+	bool runPowerBatches(int nfft, qint64 count, Prepare&& prepare, Consume&& consume)
+	{
+		BatchFft<Real> fft(nfft);
+		if (!fft.plan) {
+			return false;
+		}
+		const int outputSize = nfft / 2 + 1;
+		std::vector<double> power(outputSize);
+		for (qint64 first = 0; first < count; first += PSD_BATCH) {
+			const int batch = int(qMin<qint64>(PSD_BATCH, count - first));
+			for (int b = 0; b < batch; ++b) {
+				prepare(first + b, fft.in + qint64(b) * nfft);
+			}
+			std::fill(fft.in + qint64(batch) * nfft, fft.in + qint64(PSD_BATCH) * nfft, Real(0));
+			fft.execute();
+			for (int b = 0; b < batch; ++b) {
+				const auto* out = fft.out + qint64(b) * outputSize;
+				for (int i = 0; i < outputSize; ++i) {
+					const double real = out[i][0], imag = out[i][1];
+					power[i] = real * real + imag * imag;
+				}
+				consume(first + b, power.data());
+			}
+		}
+		return true;
+	}
+
+	// 按config.precision选择FFT精度
+	template<typename Prepare, typename Consume>
+	bool runPowerBatches(PSDA::Precision precision, int nfft, qint64 count, Prepare&& prepare, Consume&& consume)
+	{
+		if (precision == PSDA::Precision::Float) {
+			return runPowerBatches<float>(nfft, count, prepare, consume);
+		}
+		return runPowerBatches<double>(nfft, count, prepare, consume);
+	}
+
+	// 中位数平均的偏差修正系数(与scipy.signal.welch一致)
+	double medianBias(int segments)
+	{
+		double bias = 1.0;
+		for (int k = 1; k <= (segments - 1) / 2; ++k) {
+			bias += 1.0 / (2 * k + 1) - 1.0 / (2 * k);
+		}
+		return bias;
+	}
+
+	// segments段功率谱(每段outputSize个频点，依次存放)逐频点的中位数
+	void medianSpectrum(const double* spectra, int segments, int outputSize, double* out)
+	{
+		if (segments <= 0) {
+			std::fill(out, out + outputSize, 0.0);
+			return;
+		}
+		const double bias = medianBias(segments);
+		std::vector<double> values(segments);
+		const int middle = segments / 2;
+		for (int i = 0; i < outputSize; ++i) {
+			for (int k = 0; k < segments; ++k) {
+				values[k] = spectra[qint64(k) * outputSize + i];
+			}
+			std::nth_element(values.begin(), values.begin() + middle, values.end());
+			double median = values[middle];
+			if (segments % 2 == 0) {
+				median = 0.5 * (median + *std::max_element(values.begin(), values.begin() + middle));
+			}
+			out[i] = median / bias;
+		}
+	}
+
+	// 由平均后的功率谱得到输出：频率轴、单边谱加倍、去除直流分量并限制输出频率范围
+	void finishSpectrum(const double* averaged, int outputSize, int nfft, double sampleFrequency,
+		const PSDA::WelchConfig& config, QVector<double>& freqs, QVector<double>& pxx)
+	{
+		// 1. 初始化输出向量与频率轴
+		freqs.resize(outputSize);
+		pxx.resize(outputSize);
+		const double freqStep = sampleFrequency / nfft;
+		for (int i = 0; i < outputSize; ++i) {
+			freqs[i] = i * freqStep;
+			pxx[i] = averaged[i];
+		}
+
+		// 2. 单边谱：除直流与奈奎斯特(nfft为偶数时的最后一个频点)外乘2
+		if (config.oneSided) {
+			const int last = nfft % 2 == 0 ? outputSize - 1 : outputSize;
+			for (int i = 1; i < last; ++i) {
+				pxx[i] *= 2.0;
+			}
+		}
+
+		// 3. 去除直流分量
+		for (int i = 0; i < qMin(config.zeroBins, outputSize); i++)
+		{
+			pxx[i] = 0.0;
+		}
+
+		// 4. 限制输出频率范围
+		const int maxFreqIndex = qMin(static_cast<int>(config.maxFreqRatio * outputSize), outputSize - 1);
+		freqs.resize(maxFreqIndex + 1);
+		pxx.resize(maxFreqIndex + 1);
+	}
+
+	bool validConfig(const PSDA::WelchConfig& config)
+	{
+		return config.maxFreqRatio > 0 && config.maxFreqRatio <= 1.0 && config.overlap >= 0.0 && config.overlap < 1.0;
+	}
+}
 
 bool PSDA::preprocessData(
 	const double* data,
@@ -18,64 +387,37 @@ bool PSDA::preprocessData(
 	double sigmaThreshold /*= 2.0*/
 )
 {
-	// 参数校验
-	if (!data || datacount <= 0 || order <= 0) {
-		qWarning() << "Invalid input parameters";
-		return false;
-	}
-	// 计算完整段数,向下取整，多的直接不要了（不过在完整处理逻辑上，前面读取原始数据的时候就已经按order采样频率取整了）
-	const int numSegments = datacount / order;
-	if (numSegments == 0) {
-		qDebug() << "Data size too small for segmentation";
-		return false;
-	}
-
-	resData.resize(numSegments * order);
-	romData.resize(numSegments);
-	fluctuation.resize(numSegments * order);
-
-	// 预分配内存
-	//QVector<double> romData(numSegments);
-	QVector<double> segmentStdDevs(numSegments);
-	// 一次性计算均值和标准差
-	for (int seg = 0; seg < numSegments; ++seg) {
-		const int startIdx = seg * order;
-		double sum = 0.0;
-		double sumSq = 0.0;
-
-		// 计算段内和与平方和
-		for (int i = 0; i < order; ++i) {
-			const double val = data[startIdx + i];
-			resData[startIdx + i] = val; // 直接赋值到resData
-			if (0 == seg)
-			{
-				resmin = resmax = val;
-			}
-			else
-			{
-				resmin = qMin(resmin, val);
-				resmax = qMax(resmax, val);
-			}
-			sum += val;
-			sumSq += val * val;
-		}
+	return preprocessSamples(data, datacount, resData, romData, fluctuation, resmin, resmax, order, sigmaThreshold);
+}
 
-		const double mean = sum / order;
-		romData[seg] = mean;
-		segmentStdDevs[seg] = sqrt((sumSq - sum * sum / order) / order);
-	}
+bool PSDA::preprocessData(
+	const float* data,
+	int datacount,
+	QVector<double>& resData,
+	QVector<double>& romData,
+	QVector<double>& fluctuation,
+	double& resmin,
+	double& resmax,
+	int order,
+	double sigmaThreshold /*= 2.0*/
+)
+{
+	return preprocessSamples(data, datacount, resData, romData, fluctuation, resmin, resmax, order, sigmaThreshold);
+}
 
-	// 筛选有效波动数据
-	for (int i = 0; i < fluctuation.count(); ++i) {
-		const int seg = i / order;
-		double residual = data[i] - romData[seg];
-		const double dev = segmentStdDevs[seg];
-		if (dev < 0 || std::abs(residual) > sigmaThreshold * dev) {
-			residual = romData[seg];
-		}
-		fluctuation[i] = residual;
+std::shared_ptr<const std::vector<double>> PSDA::windowCoefficients(WindowType type, int length, double kaiserBeta)
+{
+	// 按(类型, 长度, beta)缓存，不同配置、不同线程共用
+	typedef std::tuple<int, int, double> WindowKey;
+	static std::mutex mutex;
+	static std::map<WindowKey, std::shared_ptr<const std::vector<double>>> windows;
+	const WindowKey key(static_cast<int>(type), length, type == WindowType::Kaiser ? kaiserBeta : 0.0);
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& window = windows[key];
+	if (!window) {
+		window = std::make_shared<const std::vector<double>>(makeWindow(type, length, kaiserBeta));
 	}
-	return true;
+	return window;
 }
 
 /**
@@ -99,136 +441,498 @@ void PSDA::calculatePowerSpectralDensity(
 	QVector<double>& pxx,
 	double maxFreqRatio /*= 0.4*/,
 	double outlierThreshold /*= 3.0*/)
+{
+	Q_UNUSED(outlierThreshold);
+	WelchConfig config;
+	config.maxFreqRatio = maxFreqRatio;
+	calculatePowerSpectralDensity(data, datacount, sampleFrequency, config, freqs, pxx);
+}
+
+void PSDA::calculatePowerSpectralDensity(
+	const double* data,
+	int datacount,
+	double sampleFrequency,
+	const WelchConfig& config,
+	QVector<double>& freqs,
+	QVector<double>& pxx)
 {
 	// 1. 参数校验
-	if (!data || datacount <= 0 || sampleFrequency <= 0 || maxFreqRatio <= 0 || maxFreqRatio > 1.0) {
+	if (!data || datacount <= 0 || sampleFrequency <= 0 || !validConfig(config)) {
 		qWarning() << "Invalid parameters in calculatePowerSpectralDensity:"
 			<< "Data:" << datacount
 			<< "| Fs:" << sampleFrequency
-			<< "| Ratio:" << maxFreqRatio;
+			<< "| Ratio:" << config.maxFreqRatio
+			<< "| Overlap:" << config.overlap;
 		return;
 	}
 
-	// 2. 确定FFT点数(优化性能与分辨率平衡)
-	int nfft = qNextPowerOfTwo(datacount);
-	nfft = qBound(256, qMin(nfft, datacount), 4096); // 更合理的范围限制
-	const int overlap = nfft / 2; // 50%重叠
-	const int numSegments = qMax(1, (datacount - overlap) / (nfft - overlap)); // 确保至少1段
+	// 2. 分段加窗FFT并累加(见WelchAccumulator)
+	WelchAccumulator accumulator(datacount, sampleFrequency, config);
+	accumulator.append(data, datacount);
+
+	// 3. 平均、去除直流分量并限制输出频率范围
+	accumulator.result(freqs, pxx);
+}
 
-	if (numSegments <= 0) {
-		qCritical() << "Invalid segment calculation - datacount:" << datacount
-			<< "nfft:" << nfft << "overlap:" << overlap;
+void PSDA::calculatePowerSpectralDensities(
+	const QVector<const double*>& datas,
+	int datacount,
+	double sampleFrequency,
+	QVector<double>& freqs,
+	QVector<QVector<double>>& pxxs,
+	const WelchConfig& config /*= WelchConfig()*/)
+{
+	// 1. 参数校验
+	const int signalCount = datas.count();
+	if (signalCount == 0 || std::count(datas.begin(), datas.end(), nullptr) > 0
+		|| datacount <= 0 || sampleFrequency <= 0 || !validConfig(config)) {
+		qWarning() << "Invalid parameters in calculatePowerSpectralDensities:"
+			<< "Signals:" << signalCount
+			<< "| Data:" << datacount
+			<< "| Fs:" << sampleFrequency
+			<< "| Ratio:" << config.maxFreqRatio
+			<< "| Overlap:" << config.overlap;
 		return;
 	}
 
-	// 3. 初始化输出向量
+	// 2. 所有信号共用分段参数，各信号的每一段依次编号为一个变换
+	const WelchSetup setup = welchSetup(datacount, sampleFrequency, config);
+	const int nfft = setup.nfft;
+	const int step = nfft - setup.overlap;
 	const int outputSize = nfft / 2 + 1;
-	freqs.resize(outputSize);
-	pxx.resize(outputSize);
-	std::fill(pxx.begin(), pxx.end(), 0.0);
+	const int segments = datacount < nfft ? 0 : qMin(setup.maxSegments, (datacount - nfft) / step + 1);
+	const qint64 transformCount = qint64(signalCount) * segments;
+	const bool median = config.averaging == Averaging::Median;
+	// 按段平均时为各信号的累加值，中位数平均时为各信号的结果；中位数平均只保存当前信号的各段功率谱
+	std::vector<double> accumulated(size_t(signalCount) * outputSize, 0.0);
+	std::vector<double> signalSpectra(median ? size_t(segments) * outputSize : 0);
+
+	// 3. 批量FFT(精度由config.precision决定)：去趋势、加窗写入批量输入
+	const double* window = setup.window->data();
+	auto prepare = [&](qint64 transform, auto* in) {
+		const double* src = datas[int(transform / segments)] + qint64(transform % segments) * step;
+		prepareSegment(src, window, nfft, config.detrend, in);
+	};
+	// 功率谱直接累加到对应信号，中位数平均时在信号的最后一段完成后求中位数
+	auto consume = [&](qint64 transform, const double* power) {
+		const int signal = int(transform / segments);
+		const int segment = int(transform % segments);
+		double* dst = median ? signalSpectra.data() + size_t(segment) * outputSize : accumulated.data() + size_t(signal) * outputSize;
+		for (int i = 0; i < outputSize; ++i) {
+			dst[i] += power[i] * setup.scaleFactor;
+		}
+		if (median && segment == segments - 1) {
+			medianSpectrum(signalSpectra.data(), segments, outputSize, accumulated.data() + size_t(signal) * outputSize);
+			std::fill(signalSpectra.begin(), signalSpectra.end(), 0.0);
+		}
+	};
+	if (!runPowerBatches(config.precision, nfft, transformCount, prepare, consume)) {
+		return;
+	}
+
+	// 4. 平均、去除直流分量并限制输出频率范围，各信号的频率轴相同
+	if (!median) {
+		// 与整段计算一致，按可切出的段数平均
+		const double avgScale = 1.0 / setup.maxSegments;
+		for (double& value : accumulated) {
+			value *= avgScale;
+		}
+	}
+	pxxs.resize(signalCount);
+	for (int s = 0; s < signalCount; ++s) {
+		finishSpectrum(accumulated.data() + size_t(s) * outputSize, outputSize, nfft, sampleFrequency, config, freqs, pxxs[s]);
+	}
+}
+
+PSDA::WelchAccumulator::WelchAccumulator(int datacount, double sampleFrequency, const WelchConfig& config)
+	: _sampleFrequency(sampleFrequency)
+	, _config(config)
+{
+	// 1. 分段参数与窗函数
+	const WelchSetup setup = welchSetup(datacount, sampleFrequency, config);
+	_nfft = setup.nfft;
+	_overlap = setup.overlap;
+	_maxSegments = setup.maxSegments;
+	_scaleFactor = setup.scaleFactor;
+	_window = setup.window;
+
+	// 2. FFT计划来自缓存，各段、各传感器复用
+	_buffer.resize(_nfft);
+	_pxx.assign(_nfft / 2 + 1, 0.0);
+	_plan = FftPlanCache::realForward(_nfft);
+}
+
+void PSDA::WelchAccumulator::reset()
+{
+	_filled = 0;
+	_segments = 0;
+	std::fill(_pxx.begin(), _pxx.end(), 0.0);
+	_segmentSpectra.clear();
+}
+
+void PSDA::WelchAccumulator::append(const double* data, int count)
+{
+	while (count > 0 && _segments < _maxSegments) {
+		const int take = qMin(count, _nfft - _filled);
+		std::copy(data, data + take, _buffer.begin() + _filled);
+		_filled += take;
+		data += take;
+		count -= take;
+		if (_filled == _nfft) {
+			processSegment();
+			// 末尾重叠部分作为下一段的开头
+			std::copy(_buffer.begin() + (_nfft - _overlap), _buffer.end(), _buffer.begin());
+			_filled = _overlap;
+		}
+	}
+}
 
-	// 4. 预计算频率轴
-	const double freqStep = sampleFrequency / nfft;
+void PSDA::WelchAccumulator::processSegment()
+{
+	if (!_plan) {
+		return;
+	}
+	// 1. 准备FFT输入数据(去趋势、应用窗函数)，写入当前线程的缓冲
+	const FftPlanCache::Scratch scratch = FftPlanCache::scratch(_nfft);
+	prepareSegment(_buffer.data(), _window->data(), _nfft, _config.detrend, scratch.in);
+
+	// 2. 执行FFT
+	fftw_execute_dft_r2c(_plan, scratch.in, scratch.out);
+
+	// 3. 计算并累加功率谱，中位数平均时保存各段结果
+	const int outputSize = static_cast<int>(_pxx.size());
+	double* dst = _pxx.data();
+	if (_config.averaging == Averaging::Median) {
+		_segmentSpectra.resize(_segmentSpectra.size() + outputSize, 0.0);
+		dst = _segmentSpectra.data() + _segmentSpectra.size() - outputSize;
+	}
 	for (int i = 0; i < outputSize; ++i) {
-		freqs[i] = i * freqStep;
+		const double real = scratch.out[i][0], imag = scratch.out[i][1];
+		dst[i] += (real * real + imag * imag) * _scaleFactor;
 	}
+	++_segments;
+}
 
-	// 5. 分段处理
-	double windowEnergySum = 0.0; // 用于归一化的窗函数能量总和
-	std::vector<double> window(nfft); // 预计算窗函数
-	for (int i = 0; i < nfft; ++i) {
-		window[i] = 0.5 * (1 - cos(2 * M_PI * i / (nfft - 1))); // 汉宁窗
-		windowEnergySum += window[i] * window[i];
+void PSDA::WelchAccumulator::result(QVector<double>& freqs, QVector<double>& pxx) const
+{
+	const int outputSize = static_cast<int>(_pxx.size());
+	std::vector<double> averaged(outputSize);
+	if (_config.averaging == Averaging::Median) {
+		medianSpectrum(_segmentSpectra.data(), _segments, outputSize, averaged.data());
+	}
+	else {
+		// 与整段计算一致，按可切出的段数平均
+		const double avgScale = 1.0 / _maxSegments;
+		for (int i = 0; i < outputSize; ++i) {
+			averaged[i] = _pxx[i] * avgScale;
+		}
+	}
+	finishSpectrum(averaged.data(), outputSize, _nfft, _sampleFrequency, _config, freqs, pxx);
+}
+
+bool PSDA::prepareSpectrogram(int datacount, double sampleFrequency, const WelchConfig& config, int maxColumns, Spectrogram& result)
+{
+	result = Spectrogram();
+	if (datacount <= 0 || sampleFrequency <= 0 || maxColumns <= 0 || !validConfig(config)) {
+		qWarning() << "Invalid parameters in prepareSpectrogram:"
+			<< "Data:" << datacount
+			<< "| Fs:" << sampleFrequency
+			<< "| Columns:" << maxColumns;
+		return false;
 	}
-	const double scaleFactor = 1.0 / (sampleFrequency * windowEnergySum * nfft);
 
-	// 6. 主处理循环
-	for (int seg = 0; seg < numSegments; ++seg) {
-		const int start = seg * (nfft - overlap);
-		const int end = start + nfft;
+	// 1. 帧长度与间隔同Welch分段
+	const WelchSetup setup = welchSetup(datacount, sampleFrequency, config);
+	if (datacount < setup.nfft) {
+		qDebug() << "Data size too small for spectrogram";
+		return false;
+	}
+	result.nfft = setup.nfft;
+	result.step = setup.nfft - setup.overlap;
+	result.frameCount = (datacount - setup.nfft) / result.step + 1;
+
+	// 2. 帧数超过maxColumns时相邻帧合并为一列
+	result.framesPerColumn = (result.frameCount + maxColumns - 1) / maxColumns;
+	const int columnCount = (result.frameCount + result.framesPerColumn - 1) / result.framesPerColumn;
+
+	// 3. 频率轴与平均功率谱一致，时间轴为各列所含数据的中心
+	const int outputSize = setup.nfft / 2 + 1;
+	const std::vector<double> empty(outputSize, 0.0);
+	QVector<double> pxx;
+	finishSpectrum(empty.data(), outputSize, setup.nfft, sampleFrequency, config, result.freqs, pxx);
+	const double columnSpan = double(result.framesPerColumn) * result.step;
+	result.times.resize(columnCount);
+	for (int c = 0; c < columnCount; ++c) {
+		result.times[c] = (c * columnSpan + (columnSpan - result.step + result.nfft) / 2.0) / sampleFrequency;
+	}
+	result.power.fill(0.0, columnCount * result.freqs.count());
+	return true;
+}
 
-		if (end > datacount) break;
+void PSDA::computeSpectrogramColumns(const double* data, double sampleFrequency, const WelchConfig& config,
+	const Spectrogram& layout, int firstColumn, int lastColumn, double* power)
+{
+	if (!data || !power || layout.nfft <= 0 || firstColumn >= lastColumn) {
+		return;
+	}
 
-		// 6.1 准备FFT输入数据(应用窗函数)
-		std::vector<double> segment(nfft);
-		for (int i = 0; i < nfft; ++i) {
-			segment[i] = data[start + i] * window[i];
+	// 1. 与prepareSpectrogram相同的帧参数(nfft已确定)
+	WelchConfig frameConfig = config;
+	frameConfig.nfft = layout.nfft;
+	const WelchSetup setup = welchSetup(layout.nfft, sampleFrequency, frameConfig);
+	const int nfft = setup.nfft;
+	const int outputSize = nfft / 2 + 1;
+	const int freqCount = layout.freqs.count();
+	const int firstFrame = firstColumn * layout.framesPerColumn;
+	const int lastFrame = qMin(lastColumn * layout.framesPerColumn, layout.frameCount);
+
+	// 2. 批量FFT(精度由config.precision决定)，功率谱累加到当前列，列的最后一帧完成后平均并输出
+	const double* window = setup.window->data();
+	std::vector<double> accumulated(outputSize, 0.0);
+	QVector<double> freqs, pxx;
+	auto prepare = [&](qint64 k, auto* in) {
+		prepareSegment(data + (firstFrame + k) * layout.step, window, nfft, config.detrend, in);
+	};
+	auto consume = [&](qint64 k, const double* framePower) {
+		for (int i = 0; i < outputSize; ++i) {
+			accumulated[i] += framePower[i] * setup.scaleFactor;
 		}
+		const int frame = firstFrame + int(k);
+		if ((frame + 1) % layout.framesPerColumn != 0 && frame + 1 != layout.frameCount) {
+			return;
+		}
+		const int column = frame / layout.framesPerColumn;
+		const double avgScale = 1.0 / (frame + 1 - column * layout.framesPerColumn);
+		for (double& value : accumulated) {
+			value *= avgScale;
+		}
+		finishSpectrum(accumulated.data(), outputSize, nfft, sampleFrequency, config, freqs, pxx);
+		std::copy(pxx.constBegin(), pxx.constBegin() + qMin(freqCount, pxx.count()), power + qint64(column) * freqCount);
+		std::fill(accumulated.begin(), accumulated.end(), 0.0);
+	};
+	runPowerBatches(config.precision, nfft, qMax(lastFrame - firstFrame, 0), prepare, consume);
+}
 
-		// 6.2 执行FFT
-		fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * outputSize);
-		fftw_plan plan = fftw_plan_dft_r2c_1d(nfft, segment.data(), out, FFTW_ESTIMATE);
-		fftw_execute(plan);
+bool PSDA::calculateSpectrogram(const double* data, int datacount, double sampleFrequency, const WelchConfig& config,
+	int maxColumns, Spectrogram& result)
+{
+	if (!data || !prepareSpectrogram(datacount, sampleFrequency, config, maxColumns, result)) {
+		return false;
+	}
+	computeSpectrogramColumns(data, sampleFrequency, config, result, 0, result.columnCount(), result.power.data());
+	return true;
+}
 
-		// 6.3 计算并累加功率谱
-		for (int i = 0; i < outputSize; ++i) {
-			const double real = out[i][0], imag = out[i][1];
-			pxx[i] += (real * real + imag * imag) * scaleFactor;
+int PSDA::CrossSpectra::pairIndex(int a, int b, int signalCount)
+{
+	// 按行存放上三角(含对角线)：第a行之前有a*signalCount - a*(a-1)/2个信号对
+	return a * signalCount - a * (a - 1) / 2 + (b - a);
+}
+
+std::complex<double> PSDA::CrossSpectra::cross(int a, int b, int i) const
+{
+	if (a > b) {
+		return std::conj(spectra[pairIndex(b, a, signalCount)][i]);
+	}
+	return spectra[pairIndex(a, b, signalCount)][i];
+}
+
+void PSDA::CrossSpectra::coherence(int a, int b, QVector<double>& out) const
+{
+	const int count = freqs.count();
+	out.resize(count);
+	for (int i = 0; i < count; ++i) {
+		const double denominator = cross(a, a, i).real() * cross(b, b, i).real();
+		out[i] = denominator > 0.0 ? std::norm(cross(a, b, i)) / denominator : 0.0;
+	}
+}
+
+void PSDA::CrossSpectra::transferFunction(int a, int b, QVector<double>& magnitude, QVector<double>& phase) const
+{
+	const int count = freqs.count();
+	magnitude.resize(count);
+	phase.resize(count);
+	for (int i = 0; i < count; ++i) {
+		const double input = cross(a, a, i).real();
+		const std::complex<double> h = input > 0.0 ? cross(a, b, i) / input : std::complex<double>();
+		magnitude[i] = std::abs(h);
+		phase[i] = std::arg(h);
+	}
+}
+
+double PSDA::CrossSpectra::meanCoherence(int a, int b, double minFreq, double maxFreq) const
+{
+	QVector<double> values;
+	coherence(a, b, values);
+	double sum = 0.0;
+	int count = 0;
+	for (int i = 0; i < values.count(); ++i) {
+		// 自谱为0的频点(如zeroBins置零的低频)相干函数没有定义，不计入平均
+		if (freqs[i] >= minFreq && freqs[i] <= maxFreq && cross(a, a, i).real() * cross(b, b, i).real() > 0.0) {
+			sum += values[i];
+			++count;
 		}
+	}
+	return count > 0 ? sum / count : 0.0;
+}
 
-		// 6.4 清理FFTW资源
-		fftw_destroy_plan(plan);
-		fftw_free(out);
+PSDA::CrossSpectralAccumulator::CrossSpectralAccumulator(int signalCount, int datacount, double sampleFrequency, const WelchConfig& config)
+	: _sampleFrequency(sampleFrequency)
+	, _config(config)
+	, _signalCount(qMax(signalCount, 0))
+{
+	// 1. 分段参数与窗函数，同calculatePowerSpectralDensities
+	const WelchSetup setup = welchSetup(datacount, sampleFrequency, config);
+	_nfft = setup.nfft;
+	_step = setup.nfft - setup.overlap;
+	_outputSize = _nfft / 2 + 1;
+	_maxSegments = setup.maxSegments;
+	_segments = datacount < _nfft ? 0 : qMin(setup.maxSegments, (datacount - _nfft) / _step + 1);
+	_scaleFactor = setup.scaleFactor;
+	_window = setup.window;
+
+	// 2. 信号对(a<=b)按pairIndex的顺序排列
+	for (int a = 0; a < _signalCount; ++a) {
+		for (int b = a; b < _signalCount; ++b) {
+			_pairs.append(qMakePair(a, b));
+		}
 	}
+	_sums.assign(_pairs.count(), std::vector<double>(size_t(_outputSize) * 2, 0.0));
 
-	// 7. 后处理
-	// 7.1 平均各段结果
-	const double avgScale = 1.0 / numSegments;
-	for (int i = 0; i < outputSize; ++i) {
-		pxx[i] *= avgScale;
+	// 3. 一块的帧缓冲约32MB
+	const qint64 frameBytes = qint64(qMax(_signalCount, 1)) * _outputSize * 2 * sizeof(double);
+	_blockSegments = int(qBound<qint64>(1, (qint64(32) << 20) / frameBytes, 64));
+}
+
+void PSDA::CrossSpectralAccumulator::beginBlock(int firstSegment, int lastSegment)
+{
+	_firstSegment = qBound(0, firstSegment, _segments);
+	_lastSegment = qBound(_firstSegment, lastSegment, qMin(_segments, _firstSegment + _blockSegments));
+	_frames.resize(size_t(_lastSegment - _firstSegment) * _signalCount * _outputSize * 2);
+}
+
+void PSDA::CrossSpectralAccumulator::transform(const QVector<const double*>& datas, int firstSignal, int lastSignal)
+{
+	// 当前块中各信号的各段依次编号为一个变换，每批PSD_BATCH个执行一次批量计划
+	const int blockCount = _lastSegment - _firstSegment;
+	const int signalSpan = qMin(lastSignal, _signalCount) - firstSignal;
+	const int transformCount = blockCount * signalSpan;
+	if (transformCount <= 0) {
+		return;
+	}
+	const fftw_plan plan = FftPlanCache::realForward(_nfft, PSD_BATCH);
+	const FftPlanCache::Scratch scratch = FftPlanCache::scratch(_nfft, PSD_BATCH);
+	if (!plan) {
+		return;
 	}
+	const double* window = _window->data();
+	for (int first = 0; first < transformCount; first += PSD_BATCH) {
+		const int batch = qMin(PSD_BATCH, transformCount - first);
+		for (int b = 0; b < batch; ++b) {
+			const int signal = firstSignal + (first + b) / blockCount;
+			const int segment = _firstSegment + (first + b) % blockCount;
+			prepareSegment(datas[signal] + qint64(segment) * _step, window, _nfft, _config.detrend, scratch.in + qint64(b) * _nfft);
+		}
+		std::fill(scratch.in + qint64(batch) * _nfft, scratch.in + qint64(PSD_BATCH) * _nfft, 0.0);
+		fftw_execute_dft_r2c(plan, scratch.in, scratch.out);
+		// 帧按[段][信号][频点]保存(批量缓冲的对齐不满足直接输出到帧缓冲的要求)
+		for (int b = 0; b < batch; ++b) {
+			const int signal = firstSignal + (first + b) / blockCount;
+			const int segment = (first + b) % blockCount;
+			const double* out = &scratch.out[qint64(b) * _outputSize][0];
+			std::copy(out, out + _outputSize * 2, _frames.data() + (size_t(segment) * _signalCount + signal) * _outputSize * 2);
+		}
+	}
+}
 
-	// 7.2 去除直流分量
-	for (size_t i = 0; i < 3; i++)
-	{
-		pxx[i] = 0.0;
+void PSDA::CrossSpectralAccumulator::accumulate(int firstPair, int lastPair)
+{
+	const int blockCount = _lastSegment - _firstSegment;
+	const size_t frameSize = size_t(_outputSize) * 2;
+	for (int p = firstPair; p < qMin(lastPair, _pairs.count()); ++p) {
+		const int a = _pairs[p].first;
+		const int b = _pairs[p].second;
+		double* sum = _sums[p].data();
+		for (int segment = 0; segment < blockCount; ++segment) {
+			const double* xa = _frames.data() + (size_t(segment) * _signalCount + a) * frameSize;
+			const double* xb = _frames.data() + (size_t(segment) * _signalCount + b) * frameSize;
+			// conj(Xa)·Xb，展开写避免std::complex乘法的NaN检查
+			for (int i = 0; i < _outputSize; ++i) {
+				const double ar = xa[2 * i], ai = xa[2 * i + 1];
+				const double br = xb[2 * i], bi = xb[2 * i + 1];
+				sum[2 * i] += ar * br + ai * bi;
+				sum[2 * i + 1] += ar * bi - ai * br;
+			}
+		}
 	}
+}
 
-	// 7.3 应用经验缩放因子(只是为了放大Y值，让画面更好看点)
-	//const double empiricalScale = 10000.0; 
-	//for (int i = 0; i < outputSize; ++i) {
-	//    pxx[i] *= empiricalScale;
-	//}
+void PSDA::CrossSpectralAccumulator::result(CrossSpectra& out) const
+{
+	out = CrossSpectra();
+	out.signalCount = _signalCount;
+	out.spectra.resize(_pairs.count());
+
+	// 1. 频率轴与功率谱一致
+	const std::vector<double> empty(_outputSize, 0.0);
+	QVector<double> pxx;
+	finishSpectrum(empty.data(), _outputSize, _nfft, _sampleFrequency, _config, out.freqs, pxx);
+	const int count = out.freqs.count();
+
+	// 2. 按可切出的段数平均、单边谱加倍并去除直流分量，归一化同功率谱
+	const double avgScale = 1.0 / _maxSegments;
+	const int last = _nfft % 2 == 0 ? _outputSize - 1 : _outputSize;
+	for (int p = 0; p < _pairs.count(); ++p) {
+		const double* sum = _sums[p].data();
+		QVector<std::complex<double>>& spectrum = out.spectra[p];
+		spectrum.resize(count);
+		for (int i = 0; i < count; ++i) {
+			double scale = _scaleFactor * avgScale;
+			if (_config.oneSided && i > 0 && i < last) {
+				scale *= 2.0;
+			}
+			spectrum[i] = i < _config.zeroBins ? std::complex<double>() : std::complex<double>(sum[2 * i] * scale, sum[2 * i + 1] * scale);
+		}
+	}
+}
 
-	// 7.4 限制输出频率范围
-	const int maxFreqIndex = qMin(static_cast<int>(maxFreqRatio * outputSize), outputSize - 1);
-	freqs.resize(maxFreqIndex + 1);
-	pxx.resize(maxFreqIndex + 1);
+bool PSDA::calculateCrossSpectra(const QVector<const double*>& datas, int datacount, double sampleFrequency,
+	const WelchConfig& config, CrossSpectra& result)
+{
+	if (datas.isEmpty() || std::count(datas.begin(), datas.end(), nullptr) > 0
+		|| datacount <= 0 || sampleFrequency <= 0 || !validConfig(config)) {
+		qWarning() << "Invalid parameters in calculateCrossSpectra:"
+			<< "Signals:" << datas.count()
+			<< "| Data:" << datacount
+			<< "| Fs:" << sampleFrequency;
+		return false;
+	}
+	CrossSpectralAccumulator accumulator(datas.count(), datacount, sampleFrequency, config);
+	for (int first = 0; first < accumulator.segmentCount(); first += accumulator.blockSegments()) {
+		accumulator.beginBlock(first, first + accumulator.blockSegments());
+		accumulator.transform(datas, 0, datas.count());
+		accumulator.accumulate(0, accumulator.pairCount());
+	}
+	accumulator.result(result);
+	return true;
 }
 
 void PSDA::butterworthHighPass(const double* input, double* output, int count, double sampleRate, double cutoffFreq)
 {
-	const double nyquist = 0.5 * sampleRate;
-	const double normalCutoff = cutoffFreq / nyquist;
-	const double sqrt2 = 1.4142135623730951;
-
-	// 滤波器系数
-	double b0 = 1.0 / (1.0 + sqrt2 * normalCutoff + normalCutoff * normalCutoff);
-	double b1 = -2.0 * b0;
-	double b2 = b0;
-	double a1 = 2.0 * (normalCutoff * normalCutoff - 1.0) * b0;
-	double a2 = (1.0 - sqrt2 * normalCutoff + normalCutoff * normalCutoff) * b0;
-
-	// 前向滤波
-	std::vector<double> forward(count);
-	double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
-	for (int i = 0; i < count; ++i) {
-		forward[i] = b0 * input[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-		x2 = x1;
-		x1 = input[i];
-		y2 = y1;
-		y1 = forward[i];
-	}
-
-	// 反向滤波（零相位）
-	x1 = x2 = y1 = y2 = 0.0;
-	for (int i = count - 1; i >= 0; --i) {
-		output[i] = b0 * forward[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-		x2 = x1;
-		x1 = forward[i];
-		y2 = y1;
-		y1 = output[i];
+	FilterDesign design;
+	design.family = FilterFamily::Butterworth;
+	design.band = FilterBand::HighPass;
+	design.order = 2;
+	design.low = cutoffFreq;
+	FilterBank bank;
+	if (!bank.design(design, sampleRate)) {
+		// 截止频率无效时不滤波
+		if (output != input) {
+			std::copy(input, input + count, output);
+		}
+		return;
 	}
+	bank.filtfilt({ input }, { output }, count);
 }
 
 void PSDA::detrendSignal(double* data, int count)
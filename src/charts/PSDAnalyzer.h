@@ -1,7 +1,60 @@
+#include <QPair>
 #include <QVector>
 
+#include <complex>
+#include <memory>
+#include <vector>
+
 #include <fftw3.h>
+
+#include "WelchConfig.h"
 namespace PSDA {
+	// 窗函数系数(对称窗，length点)，按(类型, 长度, beta)缓存，可在多线程中共用
+	std::shared_ptr<const std::vector<double>> windowCoefficients(WindowType type, int length, double kaiserBeta = 8.6);
+
+	/**
+	 * @brief Welch功率谱的分块累加器
+	 *
+	 * 与calculatePowerSpectralDensity使用完全相同的nfft、窗函数、重叠、去趋势、平均方式与归一化，
+	 * 但数据可以分多次append，内部只保留一个nfft长度的缓冲，用于流式读取时的恒定内存频谱计算。
+	 * FFT计划与输入输出缓冲来自FftPlanCache，构造与逐段计算都不创建计划。
+	 * nfft由构造时给定的总点数决定，所以总点数必须事先已知。
+	 */
+	class WelchAccumulator
+	{
+	public:
+		// datacount: 将要累加的总点数，sampleFrequency: 采样频率(Hz)，config: Welch参数
+		WelchAccumulator(int datacount, double sampleFrequency, const WelchConfig& config = WelchConfig());
+
+		// 清空累加状态，开始新的一路信号(nfft与FFT计划保持不变)
+		void reset();
+		// 追加一块数据，凑满nfft点即完成一段FFT
+		void append(const double* data, int count);
+		// 输出平均后的功率谱，输出频率范围由config.maxFreqRatio决定
+		void result(QVector<double>& freqs, QVector<double>& pxx) const;
+
+		int nfft() const { return _nfft; }
+		int segmentCount() const { return _segments; }
+
+	private:
+		void processSegment();
+
+	private:
+		double _sampleFrequency{ 0.0 };
+		WelchConfig _config{};
+		int _nfft{ 0 };
+		int _overlap{ 0 };
+		int _maxSegments{ 0 };			//总点数能完整切出的段数
+		double _scaleFactor{ 0.0 };
+		std::shared_ptr<const std::vector<double>> _window{};
+		std::vector<double> _buffer{};	//待处理数据(最多nfft点)
+		int _filled{ 0 };
+		int _segments{ 0 };				//已累加的段数
+		std::vector<double> _pxx{};		//未平均的功率谱累加值
+		std::vector<double> _segmentSpectra{};	//中位数平均时各段的功率谱
+		fftw_plan _plan{ nullptr };		//FftPlanCache持有，执行时作用在线程缓冲上
+	};
+
 	/*
 		 * @brief 计算运行阶次均值(ROM)和有效波动数据
 		 * @param data 输入数据数组
@@ -22,6 +75,18 @@ namespace PSDA {
 		int order,
 		double sigmaThreshold = 2.0
 	);
+	// 同上，float存储的数据，均值、标准差与输出仍为double
+	bool preprocessData(
+		const float* data,
+		int datacount,
+		QVector<double>& resData,
+		QVector<double>& romData,
+		QVector<double>& fluctuation,
+		double& resmin,
+		double& resmax,
+		int order,
+		double sigmaThreshold = 2.0
+	);
 	/**
 	 * @brief 计算功率谱密度(PSD) Welch方法
 	 * @param ydata 输入时域信号
@@ -42,10 +107,139 @@ namespace PSDA {
 		double maxFreqRatio = 0.5,
 		double outlierThreshold = 3.0
 	);
+	// 同上，使用config指定的窗函数、分段、去趋势与平均方式
+	void calculatePowerSpectralDensity(
+		const double* data,
+		int datacount,
+		double sampleFrequency,
+		const WelchConfig& config,
+		QVector<double>& freqs,
+		QVector<double>& pxx
+	);
+	/**
+	 * @brief 批量计算多路信号的功率谱密度(PSD) Welch方法
+	 *
+	 * 与逐路调用calculatePowerSpectralDensity结果一致，要求各路信号点数与采样频率相同(同一工况的传感器)。
+	 * 所有信号的所有分段按批加窗后用一个批量FFT计划执行，功率谱直接累加到对应信号。
+	 * @param datas 各路输入时域信号，每路datacount个点
+	 * @param freqs 输出频率向量(Hz)，各路相同
+	 * @param pxxs 输出各路功率谱密度，与datas一一对应
+	 * @param config Welch参数
+	 */
+	void calculatePowerSpectralDensities(
+		const QVector<const double*>& datas,
+		int datacount,
+		double sampleFrequency,
+		QVector<double>& freqs,
+		QVector<QVector<double>>& pxxs,
+		const WelchConfig& config = WelchConfig()
+	);
+	/**
+	 * @brief 时频谱(短时傅里叶变换)
+	 *
+	 * 每帧的窗函数、点数、重叠、去趋势与输出频率范围同Welch参数(averaging不使用)，每列为其中各帧功率谱的平均，
+	 * 单位与平均功率谱一致。帧数超过maxColumns时相邻帧合并为一列，长时间记录的列数与内存不随时长增加。
+	 */
+	struct Spectrogram
+	{
+		QVector<double> times{};	//各列的中心时刻(s)，等间隔
+		QVector<double> freqs{};	//频率(Hz)
+		QVector<double> power{};	//功率谱密度，按列存放：power[column * freqs.count() + i]
+		int nfft{ 0 };				//每帧点数
+		int step{ 0 };				//相邻两帧起点的间隔
+		int frameCount{ 0 };		//数据能完整切出的帧数
+		int framesPerColumn{ 1 };	//每列合并的帧数
+
+		int columnCount() const { return times.count(); }
+	};
+	// 按数据点数确定帧与列的布局，初始化result的时间、频率轴并分配power；参数无效或数据不足一帧时返回false
+	bool prepareSpectrogram(int datacount, double sampleFrequency, const WelchConfig& config, int maxColumns, Spectrogram& result);
+	// 计算[firstColumn, lastColumn)列写入power(按layout的列存放方式)，layout须已由prepareSpectrogram初始化；
+	// 帧的FFT按批执行，计划与缓冲来自FftPlanCache，不同列区间可在多个线程中同时计算
+	void computeSpectrogramColumns(const double* data, double sampleFrequency, const WelchConfig& config,
+		const Spectrogram& layout, int firstColumn, int lastColumn, double* power);
+	// 在调用线程中计算完整的时频谱，并行计算见PsdEngine::spectrogram
+	bool calculateSpectrogram(const double* data, int datacount, double sampleFrequency, const WelchConfig& config,
+		int maxColumns, Spectrogram& result);
+
+	/**
+	 * @brief 多路信号两两之间的互谱密度(CSD)及由其得到的相干函数与传递函数
+	 *
+	 * 互谱Gab = conj(Xa)·Xb按段平均，分段、窗函数、去趋势、归一化、单边谱与输出频率范围同calculatePowerSpectralDensities，
+	 * 自谱(a==b)与其功率谱结果一致。各段按平均方式Mean计算(复数互谱没有中位数平均)。
+	 */
+	struct CrossSpectra
+	{
+		QVector<double> freqs{};							//频率(Hz)
+		int signalCount{ 0 };
+		QVector<QVector<std::complex<double>>> spectra{};	//信号对(a<=b)的互谱，按pairIndex存放，a==b为自谱
+
+		static int pairIndex(int a, int b, int signalCount);
+		// 第i个频点的互谱Gab，a>b时为conj(Gba)
+		std::complex<double> cross(int a, int b, int i) const;
+		// 相干函数|Gab|²/(Gaa·Gbb)，范围[0, 1]，自谱为0的频点为0
+		void coherence(int a, int b, QVector<double>& out) const;
+		// 以a为输入、b为输出的传递函数H1 = Gab/Gaa，幅值与相位(rad)
+		void transferFunction(int a, int b, QVector<double>& magnitude, QVector<double>& phase) const;
+		// [minFreq, maxFreq]频带内相干函数的平均值(不含自谱为0的频点)，用于报告中的相干矩阵
+		double meanCoherence(int a, int b, double minFreq, double maxFreq) const;
+	};
+
+	/**
+	 * @brief 互谱的分块累加器
+	 *
+	 * 每次处理一块连续的段：transform对每个信号的每段只做一次FFT(批量计划)并保存帧，
+	 * accumulate把帧两两相乘累加到信号对上，N路信号每段只需N次FFT而不是N²次。
+	 * transform按信号区间、accumulate按信号对区间划分时互不重叠，可在多个线程中同时调用(见PsdEngine::crossSpectra)。
+	 */
+	class CrossSpectralAccumulator
+	{
+	public:
+		// signalCount路信号，每路datacount个点
+		CrossSpectralAccumulator(int signalCount, int datacount, double sampleFrequency, const WelchConfig& config = WelchConfig());
+
+		int signalCount() const { return _signalCount; }
+		int pairCount() const { return _pairs.count(); }
+		int segmentCount() const { return _segments; }
+		// 一块最多包含的段数(帧缓冲约32MB)
+		int blockSegments() const { return _blockSegments; }
+
+		// 开始处理[firstSegment, lastSegment)段，段数不超过blockSegments
+		void beginBlock(int firstSegment, int lastSegment);
+		// 计算当前块中[firstSignal, lastSignal)信号各段的FFT帧
+		void transform(const QVector<const double*>& datas, int firstSignal, int lastSignal);
+		// 当前块的帧累加到[firstPair, lastPair)信号对
+		void accumulate(int firstPair, int lastPair);
+		// 平均并输出全部信号对的互谱
+		void result(CrossSpectra& out) const;
+
+	private:
+		double _sampleFrequency{ 0.0 };
+		WelchConfig _config{};
+		int _signalCount{ 0 };
+		int _nfft{ 0 };
+		int _step{ 0 };
+		int _outputSize{ 0 };
+		int _maxSegments{ 0 };			//平均时的段数(同calculatePowerSpectralDensity)
+		int _segments{ 0 };				//实际能切出的段数
+		int _blockSegments{ 1 };
+		double _scaleFactor{ 0.0 };
+		std::shared_ptr<const std::vector<double>> _window{};
+		QVector<QPair<int, int>> _pairs{};
+		int _firstSegment{ 0 };
+		int _lastSegment{ 0 };
+		std::vector<double> _frames{};	//当前块的FFT帧(实部、虚部交替)，[段][信号][频点]
+		std::vector<std::vector<double>> _sums{};	//各信号对的互谱累加值(实部、虚部交替)
+	};
+	// 在调用线程中计算全部信号对的互谱，要求各路信号点数与采样频率相同
+	bool calculateCrossSpectra(const QVector<const double*>& datas, int datacount, double sampleFrequency,
+		const WelchConfig& config, CrossSpectra& result);
 	/**
-	* @brief 巴特沃斯高通滤波（二阶）
+	* @brief 巴特沃斯高通滤波（二阶，零相位）
+	*
+	* 单通道的FilterBank::filtfilt，多个通道应直接使用FilterBank一次处理
 	* @param input 输入信号
-	* @param output 输出信号
+	* @param output 输出信号(可以与input相同)
 	* @param count 数据点数
 	* @param sampleRate 采样率(Hz)
 	* @param cutoffFreq 截止频率(Hz)
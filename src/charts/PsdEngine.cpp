@@ -0,0 +1,382 @@
+#include "PsdEngine.h"
+
+#include <algorithm>
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent>
+
+#include "PSDAnalyzer.h"
+#include "SpectralPeaks.h"
+
+PsdEngine::PsdEngine(int threadCount)
+{
+	_pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+}
+
+PsdEngine::~PsdEngine()
+{
+	cancel();
+	_pool.waitForDone();
+}
+
+bool PsdEngine::run(const QVector<Job>& jobs, QMap<ResType, QMap<QString, ChartSummary>>& results, const ProgressCallback& progress,
+	CancelToken token)
+{
+	if (!token)
+	{
+		token = createCancelToken();
+	}
+	const std::atomic<bool>* canceled = token.get();
+
+	// 1. 拆分任务：每个工况的全过程与各分段各为一个任务(segment为-1表示全过程)
+	struct Task
+	{
+		int job;
+		int segment;
+	};
+	QVector<Task> tasks;
+	QVector<int> firstTask(jobs.count(), 0);
+	QVector<ChartSummary> summaries(jobs.count());
+	for (int j = 0; j < jobs.count(); ++j)
+	{
+		firstTask[j] = tasks.count();
+		const ExtraDataHandle& data = jobs[j].data;
+		if (!data)
+		{
+			continue;
+		}
+		tasks.append({ j, -1 });
+		if (data->hasSegData)
+		{
+			summaries[j].segData.resize(data->segments.count());
+			for (int i = 0; i < data->segments.count(); ++i)
+			{
+				tasks.append({ j, i });
+			}
+		}
+	}
+
+	// 2. 空闲线程依次取下一个任务执行；各任务只写自己的结果位置，不需要加锁
+	const int total = tasks.count();
+	ChartSummary* out = summaries.data();
+	QVector<char> done(total, 0);
+	char* doneFlags = done.data();
+	std::atomic<int> finished{ 0 };
+	QVector<QFuture<void>> futures;
+	futures.reserve(total);
+	for (int t = 0; t < total; ++t)
+	{
+		const Task task = tasks[t];
+		futures.append(QtConcurrent::run(&_pool, [&jobs, &finished, &progress, canceled, out, doneFlags, task, t, total]() {
+			if (*canceled)
+			{
+				return;
+			}
+			const Job& job = jobs[task.job];
+			const ExtraData& exdata = *job.data;
+			ChartSummary& summary = out[task.job];
+			if (task.segment < 0)
+			{
+				summary.data = summarizeRange(exdata.data, 0, exdata.dataCount, exdata.frequency, job.removemean, job.welch, canceled);
+			}
+			else
+			{
+				const SegmentSpan& span = exdata.segments[task.segment];
+				summary.segData.data()[task.segment] = summarizeRange(exdata.data, span.offset, span.count, exdata.frequency, job.removemean, job.welch, canceled);
+			}
+			if (*canceled)
+			{
+				return;
+			}
+			doneFlags[t] = 1;
+			const int count = ++finished;
+			if (progress)
+			{
+				progress(count, total);
+			}
+			}));
+	}
+	for (auto& future : futures)
+	{
+		future.waitForFinished();
+	}
+
+	// 3. 只输出全部任务都已完成的工况
+	for (int j = 0; j < jobs.count(); ++j)
+	{
+		const int last = j + 1 < jobs.count() ? firstTask[j + 1] : total;
+		if (last > firstTask[j] && std::all_of(done.constBegin() + firstTask[j], done.constBegin() + last, [](char flag) { return flag != 0; }))
+		{
+			results[jobs[j].type][jobs[j].wcName] = std::move(summaries[j]);
+		}
+	}
+	return !*canceled;
+}
+
+PsdEngine::CancelToken PsdEngine::createCancelToken()
+{
+	CancelToken token = std::make_shared<std::atomic<bool>>(false);
+	QMutexLocker locker(&_tokensMutex);
+	// 顺便移除已结束的计算的标记
+	_tokens.erase(std::remove_if(_tokens.begin(), _tokens.end(), [](const std::weak_ptr<std::atomic<bool>>& weak) {
+		return weak.expired();
+		}), _tokens.end());
+	_tokens.append(token);
+	return token;
+}
+
+void PsdEngine::cancel()
+{
+	QMutexLocker locker(&_tokensMutex);
+	for (const auto& weak : _tokens)
+	{
+		if (const CancelToken token = weak.lock())
+		{
+			*token = true;
+		}
+	}
+	_tokens.clear();
+}
+
+bool PsdEngine::spectrogram(const SampleColumn& column, int dataCount, double frequency, const PSDA::WelchConfig& config,
+	int maxColumns, PSDA::Spectrogram& result, CancelToken token)
+{
+	if (!token)
+	{
+		token = createCancelToken();
+	}
+	const std::atomic<bool>* canceled = token.get();
+	if (!column)
+	{
+		return false;
+	}
+
+	// 1. 与summarizeRange相同的预处理，时频谱使用波动数据
+	QVector<double> resData, romData, fluctuation;
+	double resmin = 0.0, resmax = 0.0;
+	const bool valid = column.visit([&](auto data) {
+		return PSDA::preprocessData(data, dataCount, resData, romData, fluctuation, resmin, resmax, frequency, 1.96);
+		});
+	if (!valid || !PSDA::prepareSpectrogram(fluctuation.count(), frequency, config, maxColumns, result))
+	{
+		return false;
+	}
+
+	// 2. 按列区间拆分任务(约为线程数的4倍以均衡负载)，各任务只写自己的列，不需要加锁
+	const int columnCount = result.columnCount();
+	const int taskCount = qMin(columnCount, _pool.maxThreadCount() * 4);
+	const double* input = fluctuation.constData();
+	double* power = result.power.data();
+	const PSDA::Spectrogram& layout = result;
+	QVector<QFuture<void>> futures;
+	futures.reserve(taskCount);
+	for (int t = 0; t < taskCount; ++t)
+	{
+		const int first = int(qint64(columnCount) * t / taskCount);
+		const int last = int(qint64(columnCount) * (t + 1) / taskCount);
+		futures.append(QtConcurrent::run(&_pool, [input, power, &layout, &config, canceled, frequency, first, last]() {
+			if (*canceled)
+			{
+				return;
+			}
+			PSDA::computeSpectrogramColumns(input, frequency, config, layout, first, last, power);
+			}));
+	}
+	for (auto& future : futures)
+	{
+		future.waitForFinished();
+	}
+	return !*canceled;
+}
+
+bool PsdEngine::crossSpectra(const QVector<SampleColumn>& columns, int dataCount, double frequency, const PSDA::WelchConfig& config,
+	PSDA::CrossSpectra& result, CancelToken token)
+{
+	if (!token)
+	{
+		token = createCancelToken();
+	}
+	const std::atomic<bool>* canceled = token.get();
+	const int signalCount = columns.count();
+	if (signalCount == 0 || std::any_of(columns.constBegin(), columns.constEnd(), [](const SampleColumn& column) { return !column; }))
+	{
+		return false;
+	}
+
+	// 1. 并行预处理各传感器，得到点数相同的波动数据
+	QVector<QVector<double>> fluctuations(signalCount);
+	QVector<char> valid(signalCount, 0);
+	QVector<double>* outputs = fluctuations.data();
+	char* validFlags = valid.data();
+	QVector<QFuture<void>> futures;
+	for (int s = 0; s < signalCount; ++s)
+	{
+		futures.append(QtConcurrent::run(&_pool, [&columns, outputs, validFlags, canceled, dataCount, frequency, s]() {
+			if (*canceled)
+			{
+				return;
+			}
+			QVector<double> resData, romData;
+			double resmin = 0.0, resmax = 0.0;
+			validFlags[s] = columns[s].visit([&](auto data) {
+				return PSDA::preprocessData(data, dataCount, resData, romData, outputs[s], resmin, resmax, frequency, 1.96);
+				});
+			}));
+	}
+	for (auto& future : futures)
+	{
+		future.waitForFinished();
+	}
+	if (*canceled || valid.contains(0))
+	{
+		return false;
+	}
+	QVector<const double*> inputs;
+	for (const auto& fluctuation : fluctuations)
+	{
+		inputs.append(fluctuation.constData());
+	}
+	const int fluctuationCount = fluctuations.first().count();
+	PSDA::CrossSpectralAccumulator accumulator(signalCount, fluctuationCount, frequency, config);
+	if (accumulator.segmentCount() == 0)
+	{
+		return false;
+	}
+
+	// 2. 逐块：按传感器区间并行做FFT，再按信号对区间并行累加；各任务只写自己的帧与信号对，不需要加锁
+	const int transformTasks = qMin(signalCount, _pool.maxThreadCount());
+	const int accumulateTasks = qMin(accumulator.pairCount(), _pool.maxThreadCount() * 4);
+	auto runTasks = [this, canceled](int taskCount, int itemCount, const std::function<void(int, int)>& work) {
+		QVector<QFuture<void>> futures;
+		futures.reserve(taskCount);
+		for (int t = 0; t < taskCount; ++t)
+		{
+			const int first = int(qint64(itemCount) * t / taskCount);
+			const int last = int(qint64(itemCount) * (t + 1) / taskCount);
+			futures.append(QtConcurrent::run(&_pool, [&work, canceled, first, last]() {
+				if (!*canceled)
+				{
+					work(first, last);
+				}
+				}));
+		}
+		for (auto& future : futures)
+		{
+			future.waitForFinished();
+		}
+	};
+	for (int first = 0; first < accumulator.segmentCount() && !*canceled; first += accumulator.blockSegments())
+	{
+		accumulator.beginBlock(first, first + accumulator.blockSegments());
+		runTasks(transformTasks, signalCount, [&](int firstSignal, int lastSignal) {
+			accumulator.transform(inputs, firstSignal, lastSignal);
+			});
+		runTasks(accumulateTasks, accumulator.pairCount(), [&](int firstPair, int lastPair) {
+			accumulator.accumulate(firstPair, lastPair);
+			});
+	}
+	if (*canceled)
+	{
+		return false;
+	}
+	accumulator.result(result);
+	return true;
+}
+
+ChartSummary PsdEngine::summarize(const ExtraData& exdata, bool removemean, const PSDA::WelchConfig& config)
+{
+	ChartSummary summary;
+	summary.data = summarizeRange(exdata.data, 0, exdata.dataCount, exdata.frequency, removemean, config);
+	if (!exdata.hasSegData)
+	{
+		return summary;
+	}
+	// 分段数据(全过程数据中的区间)
+	for (const auto& span : exdata.segments)
+	{
+		summary.segData.append(summarizeRange(exdata.data, span.offset, span.count, exdata.frequency, removemean, config));
+	}
+	return summary;
+}
+
+QMap<QString, SignalSummary> PsdEngine::summarizeRange(
+	const SampleTable& table,
+	qint64 offset,
+	int dataCount,
+	double frequency,
+	bool removemean,
+	const PSDA::WelchConfig& config,
+	const std::atomic<bool>* canceled
+)
+{
+	// 1. 预处理各传感器：时域数据与去运行均值后的波动数据
+	const int sensorCount = table.count();
+	QVector<QVector<double>> fluctuations(sensorCount);
+	QVector<SignalSummary> signalSummaries(sensorCount);
+	QVector<bool> valid(sensorCount, false);
+	QVector<const double*> psdInputs;
+	int fluctuationCount = -1;
+	for (int s = 0; s < sensorCount; ++s)
+	{
+		if (canceled && *canceled)
+		{
+			return QMap<QString, SignalSummary>();
+		}
+		SignalSummary& signal = signalSummaries[s];
+		QVector<double> romData;
+		valid[s] = table.column(s).mid(offset).visit([&](auto data) {
+			return PSDA::preprocessData(data, dataCount, signal.values, romData, fluctuations[s], signal.min, signal.max, frequency, 1.96);
+			});
+		if (!valid[s])
+		{
+			continue;
+		}
+		if (removemean)
+		{
+			signal.values = fluctuations[s];
+			signal.max = *std::max_element(fluctuations[s].constBegin(), fluctuations[s].constEnd());
+			signal.min = *std::min_element(fluctuations[s].constBegin(), fluctuations[s].constEnd());
+		}
+		// 同一区间内各传感器的波动数据点数相同
+		fluctuationCount = fluctuations[s].count();
+		psdInputs.append(fluctuations[s].constData());
+	}
+	if (psdInputs.isEmpty())
+	{
+		return QMap<QString, SignalSummary>();
+	}
+
+	// 2. 时间轴(resData与fluctuation点数相同，各传感器共享同一份)
+	QVector<double> times(fluctuationCount);
+	for (int i = 0; i < fluctuationCount; ++i) {
+		times[i] = double(i) / frequency;
+	}
+
+	// 3. 批量计算功率谱
+	QVector<double> freqs;
+	QVector<QVector<double>> pxxs;
+	PSDA::calculatePowerSpectralDensities(psdInputs, fluctuationCount, frequency, freqs, pxxs, config);
+	if (pxxs.count() != psdInputs.count())
+	{
+		return QMap<QString, SignalSummary>();
+	}
+
+	QMap<QString, SignalSummary> result;
+	for (int s = 0, p = 0; s < sensorCount; ++s)
+	{
+		if (!valid[s])
+		{
+			continue;
+		}
+		SignalSummary& signal = signalSummaries[s];
+		signal.times = times;
+		signal.duration = times.last();
+		signal.freqs = freqs;
+		signal.pxx = pxxs[p++];
+		// 分析时一次求出峰值，报告表格直接使用
+		PSDA::findPeaks(signal.freqs, signal.pxx, PSDA::PeakCriteria(), signal.peaks);
+		result.insert(table.name(s), signal);
+	}
+	return result;
+}
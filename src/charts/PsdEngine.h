@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include <QMap>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+
+#include "app/ProjectData.h"
+#include "WelchConfig.h"
+
+namespace PSDA { struct Spectrogram; struct CrossSpectra; }
+
+/**
+ * @brief 功率谱作业引擎
+ *
+ * 一个作业为一个工况的只读数据快照，按(工况, 全过程/第i段)拆分为任务在线程池上并行执行：
+ * 每个任务预处理区间内的所有传感器并批量计算功率谱，得到与ChartPainter绘图一致的摘要，
+ * 结果按<维度，<工况，摘要>>保存，摘要内再按传感器与分段区分。
+ * 绘图(ChartPainter::setSummary)仍在界面线程完成，引擎只做计算。
+ * 每次计算使用自己的取消标记，多个计算可以在不同线程中同时进行，开始新的计算不会撤销对其他计算的取消。
+ */
+class PsdEngine
+{
+public:
+	struct Job
+	{
+		ResType type{ ResType::FP };
+		QString wcName{};
+		ExtraDataHandle data{};		//持有期间数据列不会被释放
+		bool removemean{ false };	//时域曲线是否使用去运行均值后的波动数据
+		PSDA::WelchConfig welch{};	//功率谱参数
+	};
+	// finished: 已完成的任务数，total: 总任务数；在工作线程中调用，需自行保证线程安全
+	typedef std::function<void(int finished, int total)> ProgressCallback;
+	// 一次计算的取消标记，置位后该计算尽快结束
+	typedef std::shared_ptr<std::atomic<bool>> CancelToken;
+
+	// threadCount<=0时取CPU逻辑核数
+	explicit PsdEngine(int threadCount = 0);
+	~PsdEngine();
+
+	PsdEngine(const PsdEngine&) = delete;
+	PsdEngine& operator=(const PsdEngine&) = delete;
+
+	/**
+	 * @brief 计算所有作业(阻塞直到完成或取消)
+	 *
+	 * @param results 输出<维度，<工况，摘要>>，只写入全部任务都已完成的工况
+	 * @param token 取消标记，为空时自动创建
+	 * @return bool 被取消时返回false
+	 */
+	bool run(const QVector<Job>& jobs, QMap<ResType, QMap<QString, ChartSummary>>& results,
+		const ProgressCallback& progress = ProgressCallback(), CancelToken token = nullptr);
+	// 创建取消标记，标记存在期间会被cancel置位；需要在多次计算之间检查取消时由调用方创建并传入
+	CancelToken createCancelToken();
+	// 取消所有正在进行的计算(已创建且未释放的取消标记)，可在任意线程调用；
+	// 正在执行的任务在处理完当前传感器后结束，未开始的任务不再执行，之后开始的计算不受影响
+	void cancel();
+
+	/**
+	 * @brief 单个传感器全过程的时频谱(阻塞直到完成或取消)
+	 *
+	 * 与功率谱相同的预处理(去运行均值后的波动数据)，时间轴按列区间拆分为任务在线程池上并行计算，
+	 * 列数不超过maxColumns。可用cancel取消，被取消或数据不足一帧时返回false。
+	 */
+	bool spectrogram(const SampleColumn& column, int dataCount, double frequency, const PSDA::WelchConfig& config,
+		int maxColumns, PSDA::Spectrogram& result, CancelToken token = nullptr);
+
+	/**
+	 * @brief 多个传感器全过程两两之间的互谱(阻塞直到完成或取消)
+	 *
+	 * 与功率谱相同的预处理(去运行均值后的波动数据)，按块处理：先按传感器区间并行计算各段的FFT帧，
+	 * 再按信号对区间并行累加互谱。可用cancel取消，被取消或数据不足一段时返回false。
+	 */
+	bool crossSpectra(const QVector<SampleColumn>& columns, int dataCount, double frequency, const PSDA::WelchConfig& config,
+		PSDA::CrossSpectra& result, CancelToken token = nullptr);
+
+	// 单个工况的摘要(在调用线程中串行计算)
+	static ChartSummary summarize(const ExtraData& exdata, bool removemean, const PSDA::WelchConfig& config = PSDA::WelchConfig());
+	// table中各传感器从offset起dataCount个点的摘要：预处理后按config批量计算功率谱；canceled非空且被置位时提前返回
+	static QMap<QString, SignalSummary> summarizeRange(const SampleTable& table, qint64 offset, int dataCount,
+		double frequency, bool removemean, const PSDA::WelchConfig& config, const std::atomic<bool>* canceled = nullptr);
+
+private:
+	QThreadPool _pool{};
+	QMutex _tokensMutex{};
+	QVector<std::weak_ptr<std::atomic<bool>>> _tokens{};	//进行中的计算的取消标记
+};
@@ -0,0 +1,120 @@
+#include "SpectralPeaks.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// 半突出度处的峰宽(以频点为单位)，两侧在[leftBase, rightBase]内线性插值
+	double peakWidth(const double* pxx, int peak, int leftBase, int rightBase, double height)
+	{
+		int left = peak;
+		while (left > leftBase && pxx[left] > height) {
+			--left;
+		}
+		double leftPos = left;
+		if (pxx[left] < height) {
+			leftPos += (height - pxx[left]) / (pxx[left + 1] - pxx[left]);
+		}
+		int right = peak;
+		while (right < rightBase && pxx[right] > height) {
+			++right;
+		}
+		double rightPos = right;
+		if (pxx[right] < height) {
+			rightPos -= (height - pxx[right]) / (pxx[right - 1] - pxx[right]);
+		}
+		return rightPos - leftPos;
+	}
+}
+
+int PSDA::findPeaks(const QVector<double>& freqs, const QVector<double>& pxx, const PeakCriteria& criteria,
+	QVector<SpectralPeak>& peaks)
+{
+	peaks.clear();
+	const int count = qMin(freqs.count(), pxx.count());
+	if (count < 3) {
+		return 0;
+	}
+	const double* y = pxx.constData();
+	const double df = freqs[1] - freqs[0];
+	const double maxValue = *std::max_element(y, y + count);
+	if (maxValue <= 0.0) {
+		return 0;
+	}
+	const double minProminence = criteria.minProminence * maxValue;
+
+	// 1. 相邻频点的升降符号(无分支，可被编译器向量化)
+	std::vector<signed char> slope(count - 1);
+	for (int i = 0; i < count - 1; ++i) {
+		slope[i] = static_cast<signed char>((y[i + 1] > y[i]) - (y[i + 1] < y[i]));
+	}
+
+	// 2. 局部极大值：上升后经过若干平坦点再下降，平台取中点
+	std::vector<int> candidates;
+	for (int i = 1; i < count - 1; ++i) {
+		if (slope[i - 1] <= 0) {
+			continue;
+		}
+		int last = i;
+		while (last < count - 1 && slope[last] == 0) {
+			++last;
+		}
+		if (last < count - 1 && slope[last] < 0) {
+			candidates.push_back((i + last) / 2);
+		}
+		i = last;
+	}
+
+	// 3. 突出度与峰宽：向两侧找到更高的点或谱线端点为止，取两侧最低点中较高者为基线
+	for (const int peak : candidates) {
+		if (freqs[peak] < criteria.minFrequency) {
+			continue;
+		}
+		int leftBase = peak, rightBase = peak;
+		double leftMin = y[peak], rightMin = y[peak];
+		for (int i = peak - 1; i >= 0 && y[i] <= y[peak]; --i) {
+			if (y[i] < leftMin) {
+				leftMin = y[i];
+				leftBase = i;
+			}
+		}
+		for (int i = peak + 1; i < count && y[i] <= y[peak]; ++i) {
+			if (y[i] < rightMin) {
+				rightMin = y[i];
+				rightBase = i;
+			}
+		}
+		const double prominence = y[peak] - qMax(leftMin, rightMin);
+		if (prominence <= 0.0 || prominence < minProminence) {
+			continue;
+		}
+		const double width = peakWidth(y, peak, leftBase, rightBase, y[peak] - 0.5 * prominence) * df;
+		if (width < criteria.minWidth) {
+			continue;
+		}
+
+		// 抛物线插值：偏移限制在半个频点内
+		SpectralPeak result;
+		result.index = peak;
+		result.frequency = freqs[peak];
+		result.power = y[peak];
+		const double a = y[peak - 1], b = y[peak], c = y[peak + 1];
+		const double denominator = a - 2.0 * b + c;
+		if (denominator < 0.0) {
+			const double delta = qBound(-0.5, 0.5 * (a - c) / denominator, 0.5);
+			result.frequency += delta * df;
+			result.power = b - 0.25 * (a - c) * delta;
+		}
+		result.prominence = prominence;
+		result.width = width;
+		peaks.append(result);
+	}
+
+	// 4. 按功率从大到小排列并截取
+	std::sort(peaks.begin(), peaks.end(), [](const SpectralPeak& l, const SpectralPeak& r) { return l.power > r.power; });
+	if (criteria.maxPeaks > 0 && peaks.count() > criteria.maxPeaks) {
+		peaks.resize(criteria.maxPeaks);
+	}
+	return peaks.count();
+}
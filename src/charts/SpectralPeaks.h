@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QVector>
+
+namespace PSDA
+{
+	// 功率谱中的一个峰值
+	struct SpectralPeak
+	{
+		int index{ -1 };			//峰值所在频点
+		double frequency{ 0.0 };	//抛物线插值后的峰值频率(Hz)
+		double power{ 0.0 };		//抛物线插值后的峰值功率谱密度
+		double prominence{ 0.0 };	//突出度：峰值高出两侧最低点中较高者的量
+		double width{ 0.0 };		//半突出度处的峰宽(Hz)
+	};
+
+	/**
+	 * @brief 峰值筛选条件
+	 *
+	 * 突出度按整条谱线的最大值取相对值，不同量纲、不同传感器可以使用同一组条件。
+	 */
+	struct PeakCriteria
+	{
+		double minProminence{ 0.05 };	//最小突出度，相对谱线最大值的比例
+		double minWidth{ 0.0 };			//最小峰宽(Hz)
+		double minFrequency{ 0.0 };		//只在不低于该频率的频点中查找
+		int maxPeaks{ 5 };				//最多输出的峰值个数，<=0时不限制
+	};
+
+	/**
+	 * @brief 查找功率谱中的峰值
+	 *
+	 * 先一次性计算相邻频点的升降符号找出局部极大值(平台取中点)，再按突出度与半突出度峰宽筛选，
+	 * 峰值频率与功率由相邻三个频点的抛物线插值得到(亚频点精度)。freqs须为等间隔的频率轴。
+	 *
+	 * @param peaks 输出满足条件的峰值，按功率从大到小排列，第一个即为主频
+	 * @return int 峰值个数
+	 */
+	int findPeaks(const QVector<double>& freqs, const QVector<double>& pxx, const PeakCriteria& criteria,
+		QVector<SpectralPeak>& peaks);
+};
@@ -0,0 +1,133 @@
+#include "WelchConfig.h"
+
+#include <QDebug>
+#include <QStringList>
+
+namespace
+{
+	bool parseWindow(const QString& value, PSDA::WindowType& window)
+	{
+		if (value == "hann") {
+			window = PSDA::WindowType::Hann;
+		}
+		else if (value == "hamming") {
+			window = PSDA::WindowType::Hamming;
+		}
+		else if (value == "blackmanharris") {
+			window = PSDA::WindowType::BlackmanHarris;
+		}
+		else if (value == "flattop") {
+			window = PSDA::WindowType::FlatTop;
+		}
+		else if (value == "kaiser") {
+			window = PSDA::WindowType::Kaiser;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	bool parseDetrend(const QString& value, PSDA::DetrendMode& detrend)
+	{
+		if (value == "none") {
+			detrend = PSDA::DetrendMode::None;
+		}
+		else if (value == "mean") {
+			detrend = PSDA::DetrendMode::Mean;
+		}
+		else if (value == "linear") {
+			detrend = PSDA::DetrendMode::Linear;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	bool parseAveraging(const QString& value, PSDA::Averaging& averaging)
+	{
+		if (value == "mean") {
+			averaging = PSDA::Averaging::Mean;
+		}
+		else if (value == "median") {
+			averaging = PSDA::Averaging::Median;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+}
+
+bool PSDA::parseWelchConfig(const QString& text, WelchConfig& config)
+{
+	WelchConfig parsed = config;
+	const QStringList items = text.split(",");
+	for (const QString& item : items) {
+		if (item.trimmed().isEmpty()) {
+			continue;
+		}
+		const QStringList pair = item.split("=");
+		if (pair.count() != 2) {
+			qWarning() << "Invalid Welch config item:" << item;
+			return false;
+		}
+		const QString key = pair[0].trimmed().toLower();
+		const QString value = pair[1].trimmed().toLower();
+		bool ok = true;
+		if (key == "window") {
+			ok = parseWindow(value, parsed.window);
+		}
+		else if (key == "beta") {
+			parsed.kaiserBeta = value.toDouble(&ok);
+			ok = ok && parsed.kaiserBeta >= 0.0;
+		}
+		else if (key == "overlap") {
+			parsed.overlap = value.toDouble(&ok);
+			ok = ok && parsed.overlap >= 0.0 && parsed.overlap < 1.0;
+		}
+		else if (key == "nfft") {
+			parsed.nfft = value.toInt(&ok);
+			ok = ok && (parsed.nfft == 0 || parsed.nfft > 1);
+		}
+		else if (key == "minnfft") {
+			parsed.minNfft = value.toInt(&ok);
+			ok = ok && parsed.minNfft > 1;
+		}
+		else if (key == "maxnfft") {
+			parsed.maxNfft = value.toInt(&ok);
+			ok = ok && parsed.maxNfft > 1;
+		}
+		else if (key == "detrend") {
+			ok = parseDetrend(value, parsed.detrend);
+		}
+		else if (key == "averaging") {
+			ok = parseAveraging(value, parsed.averaging);
+		}
+		else if (key == "onesided") {
+			parsed.oneSided = value.toInt(&ok) != 0;
+		}
+		else if (key == "zerobins") {
+			parsed.zeroBins = value.toInt(&ok);
+			ok = ok && parsed.zeroBins >= 0;
+		}
+		else if (key == "maxfreq") {
+			parsed.maxFreqRatio = value.toDouble(&ok);
+			ok = ok && parsed.maxFreqRatio > 0.0 && parsed.maxFreqRatio <= 1.0;
+		}
+		else {
+			ok = false;
+		}
+		if (!ok) {
+			qWarning() << "Invalid Welch config item:" << item;
+			return false;
+		}
+	}
+	if (parsed.minNfft > parsed.maxNfft) {
+		qWarning() << "Invalid Welch config nfft range:" << parsed.minNfft << parsed.maxNfft;
+		return false;
+	}
+	config = parsed;
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QString>
+
+namespace PSDA
+{
+	// 窗函数类型
+	enum class WindowType { Hann, Hamming, BlackmanHarris, FlatTop, Kaiser };
+	// 每段FFT前的去趋势方式
+	enum class DetrendMode { None, Mean, Linear };
+	// 各段功率谱的平均方式
+	enum class Averaging { Mean, Median };
+	// FFT的计算精度：界面显示的频谱使用单精度(fftwf)，报告中的数值保持双精度；累加与输出均为double
+	enum class Precision { Double, Float };
+
+	/**
+	 * @brief Welch功率谱参数
+	 *
+	 * 默认值与原先固定的参数一致：汉宁窗、50%重叠、nfft按数据点数取2的幂次并限制在[256, 4096]、不去趋势、
+	 * 按段平均、不做单边谱加倍、输出时置零前3个频点。不同维度可以在settings中分别配置(见parseWelchConfig)。
+	 */
+	struct WelchConfig
+	{
+		WindowType window{ WindowType::Hann };
+		double kaiserBeta{ 8.6 };			//Kaiser窗的beta
+		double overlap{ 0.5 };				//相邻两段重叠的比例[0, 1)
+		int nfft{ 0 };						//每段点数，<=0时按数据点数自动选择
+		int minNfft{ 256 };					//自动选择时的下限
+		int maxNfft{ 4096 };				//自动选择时的上限
+		DetrendMode detrend{ DetrendMode::None };
+		Averaging averaging{ Averaging::Mean };
+		bool oneSided{ false };				//单边谱：直流与奈奎斯特以外的频点乘2
+		int zeroBins{ 3 };					//输出时置零的低频点数(去除直流分量)
+		double maxFreqRatio{ 0.5 };			//输出的最大频率占全部频点的比例(0-1]
+		Precision precision{ Precision::Double };	//批量功率谱与时频谱的FFT精度，不由settings配置(见ProjectData::setDisplayPrecision)
+	};
+
+	/**
+	 * @brief 由settings中的一行文本解析Welch参数
+	 *
+	 * 格式为逗号分隔的key=value，key不区分大小写，未出现的key保持config中的原值，例如：
+	 * window=kaiser,beta=6,overlap=0.75,nfft=2048,detrend=linear,averaging=median,onesided=1,zerobins=1,maxfreq=0.4
+	 * window可选hann/hamming/blackmanharris/flattop/kaiser，detrend可选none/mean/linear，averaging可选mean/median，
+	 * nfft=0表示按数据点数自动选择，nfft、minnfft、maxnfft指定点数时须大于1。
+	 *
+	 * @return bool 存在无法识别的key或取值时返回false，此时config不变
+	 */
+	bool parseWelchConfig(const QString& text, WelchConfig& config);
+};
@@ -0,0 +1,366 @@
+#include "DataCache.h"
+
+#include <cstring>
+#include <memory>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace
+{
+	constexpr char CACHE_MAGIC[8] = { 'S', 'V', 'C', 'A', 'C', 'H', 'E', '\0' };
+	constexpr quint32 CACHE_VERSION = 4;
+	// 每列起点的对齐字节数(缓存行/SIMD友好)
+	constexpr qint64 CACHE_ALIGNMENT = 64;
+	// 内容哈希只取文件首尾各1MB
+	constexpr qint64 HASH_SAMPLE_BYTES = 1024 * 1024;
+	const char* CACHE_DIR_NAME = ".svcache";
+	const char* CACHE_SUFFIX = ".svc";
+
+	inline qint64 alignUp(qint64 value)
+	{
+		return (value + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+	}
+
+	// 源文件标识
+	struct SourceKey
+	{
+		qint64 size{ 0 };
+		qint64 mtime{ 0 };
+		QByteArray contentHash{};
+	};
+
+	bool readSourceKey(const QString& sourcePath, SourceKey& key)
+	{
+		QFileInfo info(sourcePath);
+		QFile file(sourcePath);
+		if (!info.exists() || !file.open(QIODevice::ReadOnly)) {
+			return false;
+		}
+		key.size = info.size();
+		key.mtime = info.lastModified().toMSecsSinceEpoch();
+
+		QCryptographicHash hash(QCryptographicHash::Sha1);
+		hash.addData(file.read(HASH_SAMPLE_BYTES));
+		if (key.size > HASH_SAMPLE_BYTES) {
+			file.seek(qMax(HASH_SAMPLE_BYTES, key.size - HASH_SAMPLE_BYTES));
+			hash.addData(file.read(HASH_SAMPLE_BYTES));
+		}
+		key.contentHash = hash.result();
+		return true;
+	}
+
+	// 统一的流格式，保证不同平台、Qt版本下头部一致
+	void setupStream(QDataStream& stream)
+	{
+		stream.setVersion(QDataStream::Qt_5_6);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+	}
+
+	QDataStream& operator<<(QDataStream& out, const Statistics& stats)
+	{
+		return out << stats.max << stats.min << stats.rms << stats.mean << stats.variance << stats.skewness << stats.kurtosis;
+	}
+
+	QDataStream& operator>>(QDataStream& in, Statistics& stats)
+	{
+		return in >> stats.max >> stats.min >> stats.rms >> stats.mean >> stats.variance >> stats.skewness >> stats.kurtosis;
+	}
+
+	// 缓存中一列数据的视图
+	SampleColumn columnView(const uchar* column, SampleType sampleType)
+	{
+		if (sampleType == SampleType::Float32) {
+			return SampleColumn(reinterpret_cast<const float*>(column));
+		}
+		return SampleColumn(reinterpret_cast<const double*>(column));
+	}
+
+	// 数据区之后各列区间统计索引的间隔
+	inline quint64 indexStride(qint32 dataCount)
+	{
+		return quint64(alignUp(StatsIndex::serializedBytes(dataCount)));
+	}
+
+	// 固定头与统计信息，dataOffset之后为各列数据，再之后为各列区间统计索引
+	QByteArray buildHeader(
+		const ExtraData& exdata,
+		const SourceKey& source,
+		const QByteArray& settingsKey,
+		quint64 dataOffset,
+		quint64 columnStride,
+		SampleType sampleType
+	)
+	{
+		QByteArray header;
+		QDataStream out(&header, QIODevice::WriteOnly);
+		setupStream(out);
+		out.writeRawData(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		out << CACHE_VERSION << dataOffset << columnStride << quint8(sampleType);
+		out << source.size << source.mtime << source.contentHash << settingsKey;
+		out << qint32(exdata.frequency) << qint32(exdata.dataCount) << qint32(exdata.dataCountEach)
+			<< quint8(exdata.hasSegData ? 1 : 0) << qint32(exdata.data.count()) << qint32(exdata.segStatistics.count());
+		for (const QString& name : exdata.data.names()) {
+			out << name << exdata.statistics.value(name);
+			for (const auto& segStatistics : exdata.segStatistics) {
+				out << segStatistics.value(name);
+			}
+		}
+		return header;
+	}
+}
+
+QString RWMAT::DataCache::cacheFilePath(const QString& sourcePath)
+{
+	const QFileInfo info(sourcePath);
+	return info.absolutePath() + "/" + CACHE_DIR_NAME + "/" + info.completeBaseName() + CACHE_SUFFIX;
+}
+
+QByteArray RWMAT::DataCache::settingsKey(
+	const QStringList& sensorNames,
+	const QStringList& sensorValid,
+	double minValue,
+	double maxValue,
+	bool hasSegData,
+	SampleType storage
+)
+{
+	QByteArray key;
+	QDataStream out(&key, QIODevice::WriteOnly);
+	setupStream(out);
+	out << sensorNames << sensorValid << minValue << maxValue << hasSegData << qint32(SEGMENT_COUNT) << quint8(storage);
+	return QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+}
+
+bool RWMAT::DataCache::CacheFile::open(const QString& sourcePath, const QByteArray& settingsKey)
+{
+	if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN) {
+		return false;
+	}
+	const QString cachePath = cacheFilePath(sourcePath);
+	if (!QFileInfo::exists(cachePath)) {
+		return false;
+	}
+	SourceKey source;
+	if (!readSourceKey(sourcePath, source)) {
+		return false;
+	}
+
+	// 1. 校验头部与键
+	std::shared_ptr<QFile> file = std::make_shared<QFile>(cachePath);
+	if (!file->open(QIODevice::ReadOnly)) {
+		qDebug() << "Failed to open data cache:" << cachePath;
+		return false;
+	}
+	QDataStream in(file.get());
+	setupStream(in);
+	char magic[sizeof(CACHE_MAGIC)] = {};
+	quint32 version = 0;
+	quint64 dataOffset = 0, columnStride = 0;
+	quint8 sampleType = 0;
+	SourceKey cached;
+	QByteArray cachedSettings;
+	in.readRawData(magic, sizeof(magic));
+	in >> version >> dataOffset >> columnStride >> sampleType;
+	if (in.status() != QDataStream::Ok || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || version != CACHE_VERSION
+		|| sampleType > quint8(SampleType::Float32)) {
+		qDebug() << "Data cache format mismatch, rebuild:" << cachePath;
+		return false;
+	}
+	in >> cached.size >> cached.mtime >> cached.contentHash >> cachedSettings;
+	if (in.status() != QDataStream::Ok
+		|| cached.size != source.size || cached.mtime != source.mtime || cached.contentHash != source.contentHash
+		|| cachedSettings != settingsKey) {
+		qDebug() << "Data cache is stale, rebuild:" << cachePath;
+		return false;
+	}
+
+	// 2. 统计信息
+	qint32 frequency = 0, dataCount = 0, dataCountEach = 0, sensorCount = 0, segCount = 0;
+	quint8 hasSegData = 0;
+	in >> frequency >> dataCount >> dataCountEach >> hasSegData >> sensorCount >> segCount;
+	if (in.status() != QDataStream::Ok || dataCount <= 0 || sensorCount <= 0 || segCount < 0 || segCount >= SEGMENT_COUNT
+		|| columnStride < quint64(dataCount) * sampleSize(SampleType(sampleType)) || dataOffset % CACHE_ALIGNMENT != 0
+		|| columnStride % CACHE_ALIGNMENT != 0
+		|| (segCount > 0 && (dataCountEach <= 0 || qint64(segCount) * dataCountEach + dataCountEach / 2 > dataCount))) {
+		qWarning() << "Corrupted data cache:" << cachePath;
+		return false;
+	}
+	QStringList names;
+	ExtraData meta;
+	meta.segStatistics.resize(segCount);
+	for (int s = 0; s < sensorCount; ++s) {
+		QString name;
+		Statistics stats;
+		in >> name >> stats;
+		names.append(name);
+		meta.statistics[name] = stats;
+		for (int i = 0; i < segCount; ++i) {
+			in >> stats;
+			meta.segStatistics[i][name] = stats;
+		}
+	}
+	const quint64 indexOffset = dataOffset + quint64(sensorCount) * columnStride;
+	if (in.status() != QDataStream::Ok || quint64(in.device()->pos()) > dataOffset
+		|| quint64(file->size()) < indexOffset + quint64(sensorCount) * indexStride(dataCount)) {
+		qWarning() << "Corrupted data cache:" << cachePath;
+		return false;
+	}
+	meta.frequency = frequency;
+	meta.dataCount = dataCount;
+	meta.dataCountEach = dataCountEach;
+	meta.senseCount = sensorCount;
+	meta.hasSegData = hasSegData != 0;
+
+	_file = file;
+	_dataOffset = dataOffset;
+	_columnStride = columnStride;
+	_indexOffset = indexOffset;
+	_indexStride = indexStride(dataCount);
+	_sampleType = SampleType(sampleType);
+	_meta = meta;
+	_names = names;
+	return true;
+}
+
+void RWMAT::DataCache::CacheFile::fillMetadata(ExtraData& exdata) const
+{
+	exdata.frequency = _meta.frequency;
+	exdata.dataCount = _meta.dataCount;
+	exdata.dataCountEach = _meta.dataCountEach;
+	exdata.senseCount = _meta.senseCount;
+	exdata.startTime = QDateTime::currentDateTime();
+	exdata.statistics = _meta.statistics;
+	exdata.hasSegData = _meta.hasSegData;
+	exdata.segStatistics = _meta.segStatistics;
+	exdata.segments = segmentSpans(_meta.dataCountEach, _meta.segStatistics.count());
+}
+
+std::shared_ptr<void> RWMAT::DataCache::CacheFile::mapColumn(const QString& sensorName, SampleColumn& data) const
+{
+	const int index = _names.indexOf(sensorName);
+	if (!_file || index < 0) {
+		return nullptr;
+	}
+	// 列起点按64字节对齐，映射后的地址同样对齐
+	uchar* column = _file->map(qint64(_dataOffset + quint64(index) * _columnStride), qint64(_meta.dataCount) * sampleSize(_sampleType));
+	if (!column) {
+		qWarning() << "Failed to map data cache column:" << _file->fileName() << sensorName;
+		return nullptr;
+	}
+	data = columnView(column, _sampleType);
+	std::shared_ptr<QFile> file = _file;
+	return std::shared_ptr<void>(column, [file](void* ptr) {
+		file->unmap(static_cast<uchar*>(ptr));
+		});
+}
+
+std::shared_ptr<const StatsIndex> RWMAT::DataCache::CacheFile::statsIndex(const QString& sensorName) const
+{
+	const int index = _names.indexOf(sensorName);
+	if (!_file || index < 0) {
+		return nullptr;
+	}
+	// 索引只有数据的百分之几，读入内存后即解除映射
+	const qint64 bytes = StatsIndex::serializedBytes(_meta.dataCount);
+	uchar* record = _file->map(qint64(_indexOffset + quint64(index) * _indexStride), bytes);
+	if (!record) {
+		qWarning() << "Failed to map data cache stats index:" << _file->fileName() << sensorName;
+		return nullptr;
+	}
+	auto statsIndex = StatsIndex::fromBytes(record, _meta.dataCount);
+	_file->unmap(record);
+	return statsIndex;
+}
+
+bool RWMAT::DataCache::load(ExtraData& exdata, const QString& sourcePath, const QByteArray& settingsKey)
+{
+	CacheFile cache;
+	if (!cache.open(sourcePath, settingsKey)) {
+		return false;
+	}
+
+	// 每列单独映射，data直接指向映射区；区间统计索引从缓存读取
+	ExtraData loaded;
+	cache.fillMetadata(loaded);
+	for (const QString& name : cache.sensorNames()) {
+		SampleColumn column;
+		auto mapping = cache.mapColumn(name, column);
+		auto statsIndex = cache.statsIndex(name);
+		if (!mapping || !statsIndex) {
+			return false;
+		}
+		loaded.data.insert(name, column, mapping, statsIndex);
+	}
+	loaded.wcname = exdata.wcname;
+	exdata = loaded;
+	return true;
+}
+
+bool RWMAT::DataCache::save(const ExtraData& exdata, const QString& sourcePath, const QByteArray& settingsKey)
+{
+	// 缓存约定为小端序，数据区按原样写入
+	if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN || exdata.data.isEmpty() || exdata.dataCount <= 0) {
+		return false;
+	}
+	SourceKey source;
+	if (!readSourceKey(sourcePath, source)) {
+		return false;
+	}
+	const QString cachePath = cacheFilePath(sourcePath);
+	if (!QDir().mkpath(QFileInfo(cachePath).absolutePath())) {
+		qDebug() << "Failed to create data cache folder for:" << cachePath;
+		return false;
+	}
+
+	// 1. 头部长度与dataOffset无关(定长字段)，先按0生成一次求出对齐后的数据区起点
+	const SampleType sampleType = exdata.data.column(0).type;
+	for (int s = 1; s < exdata.data.count(); ++s) {
+		if (exdata.data.column(s).type != sampleType) {
+			qWarning() << "Mixed sample precision, data cache skipped:" << cachePath;
+			return false;
+		}
+	}
+	const quint64 columnBytes = quint64(exdata.dataCount) * sampleSize(sampleType);
+	const quint64 columnStride = quint64(alignUp(qint64(columnBytes)));
+	const quint64 dataOffset = quint64(alignUp(buildHeader(exdata, source, settingsKey, 0, columnStride, sampleType).size()));
+	QByteArray header = buildHeader(exdata, source, settingsKey, dataOffset, columnStride, sampleType);
+	header.append(QByteArray(int(dataOffset) - header.size(), '\0'));
+
+	// 2. 按与头部相同的传感器顺序写入各列
+	QSaveFile file(cachePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Failed to write data cache:" << cachePath;
+		return false;
+	}
+	bool ok = file.write(header) == header.size();
+	const QByteArray padding(int(columnStride - columnBytes), '\0');
+	for (int s = 0; ok && s < exdata.data.count(); ++s) {
+		ok = file.write(static_cast<const char*>(exdata.data.column(s).data), qint64(columnBytes)) == qint64(columnBytes)
+			&& file.write(padding) == padding.size();
+	}
+
+	// 3. 各列区间统计索引，没有索引或数据点数量不一致的列在这里建立
+	const quint64 recordBytes = quint64(StatsIndex::serializedBytes(exdata.dataCount));
+	const QByteArray recordPadding(int(indexStride(exdata.dataCount) - recordBytes), '\0');
+	for (int s = 0; ok && s < exdata.data.count(); ++s) {
+		std::shared_ptr<const StatsIndex> statsIndex = exdata.data.statsIndex(s);
+		if (!statsIndex || statsIndex->count() != exdata.dataCount) {
+			statsIndex = std::make_shared<const StatsIndex>(exdata.data.column(s), exdata.dataCount);
+		}
+		const QByteArray record = statsIndex->toBytes();
+		ok = quint64(record.size()) == recordBytes && file.write(record) == record.size()
+			&& file.write(recordPadding) == recordPadding.size();
+	}
+	if (!ok || !file.commit()) {
+		qWarning() << "Failed to write data cache:" << cachePath;
+		return false;
+	}
+	return true;
+}
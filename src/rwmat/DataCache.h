@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include "app/ProjectData.h"
+#include "app/StatsIndex.h"
+
+class QFile;
+
+namespace RWMAT
+{
+	/**
+	 * @brief 处理后数据包的二进制列式缓存
+	 *
+	 * 每个工况MAT文件对应一个缓存文件：<维度文件夹>/.svcache/<工况名>.svc。
+	 * 文件内容为小端序，固定头 + 统计信息 + 按传感器分列存放的裁剪、置零后的数据(精度与写入时的存储精度一致)，每列起点按64字节对齐，
+	 * 加载时每列单独内存映射，data直接指向映射区并各自持有该列的映射，不做任何解析与拷贝，淘汰一列即解除该列的映射。
+	 * 数据区之后按同样顺序存放各列的区间统计索引(见StatsIndex::toBytes，每条记录按64字节对齐)，加载时不需要扫描数据重建索引。
+	 *
+	 * 缓存以源文件大小、修改时间、内容哈希(文件头及首尾各1MB，避免为校验而通读整个文件)
+	 * 以及影响处理结果的settings(settingsKey)为键，任意一项不一致即视为失效。
+	 */
+	namespace DataCache
+	{
+		// 缓存文件路径
+		QString cacheFilePath(const QString& sourcePath);
+
+		// 由影响处理结果的配置生成settingsKey
+		QByteArray settingsKey(
+			const QStringList& sensorNames,
+			const QStringList& sensorValid,
+			double minValue,
+			double maxValue,
+			bool hasSegData,
+			SampleType storage
+		);
+
+		/**
+		 * @brief 已校验的缓存文件
+		 *
+		 * open只解析头部与统计信息，数据列按需单独映射，用于按传感器懒加载。
+		 */
+		class CacheFile
+		{
+		public:
+			// 不存在、失效或损坏时返回false
+			bool open(const QString& sourcePath, const QByteArray& settingsKey);
+
+			// 填充data以外的字段(统计信息、数据量、分段区间等)
+			void fillMetadata(ExtraData& exdata) const;
+
+			const QStringList& sensorNames() const { return _names; }
+
+			// 映射单个传感器的数据列，返回的所有者释放时解除映射；传感器不存在或映射失败时返回空
+			std::shared_ptr<void> mapColumn(const QString& sensorName, SampleColumn& data) const;
+			// 读取单个传感器的区间统计索引，传感器不存在或读取失败时返回空
+			std::shared_ptr<const StatsIndex> statsIndex(const QString& sensorName) const;
+
+			quint64 dataOffset() const { return _dataOffset; }
+			quint64 columnStride() const { return _columnStride; }
+			SampleType sampleType() const { return _sampleType; }
+
+		private:
+			std::shared_ptr<QFile> _file{};
+			quint64 _dataOffset{ 0 };
+			quint64 _columnStride{ 0 };
+			quint64 _indexOffset{ 0 };
+			quint64 _indexStride{ 0 };
+			SampleType _sampleType{ SampleType::Float64 };
+			ExtraData _meta{};
+			QStringList _names{};
+		};
+
+		// 命中时填充exdata(映射方式，附带区间统计索引)并返回true；不存在、失效或损坏时返回false，exdata不变
+		bool load(ExtraData& exdata, const QString& sourcePath, const QByteArray& settingsKey);
+
+		// 保存处理完成的exdata，先写临时文件再替换，失败不影响已有缓存；各列存储精度须一致，缺少区间统计索引的列在写入时建立
+		bool save(const ExtraData& exdata, const QString& sourcePath, const QByteArray& settingsKey);
+	};
+};
@@ -0,0 +1,309 @@
+#include "MatBlockConsumers.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "charts/PSDAnalyzer.h"
+
+void RWMAT::StatsConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	_stats.fill(STATS::Moments(), info.sensorNames.size());
+	_statistics.clear();
+}
+
+void RWMAT::StatsConsumer::consume(int sensor, qint64, const double* values, int count)
+{
+	STATS::accumulate(values, count, _stats[sensor]);
+}
+
+void RWMAT::StatsConsumer::finish()
+{
+	for (int i = 0; i < _stats.size(); ++i) {
+		_statistics[_info.sensorNames[i]] = _stats[i].toStatistics();
+	}
+}
+
+void RWMAT::SegmentStatsConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	_segmentSize = info.dataCount < SEGMENT_COUNT ? 0 : info.dataCount / SEGMENT_COUNT;
+	_offset = _segmentSize / 2;
+	_stats.fill(QVector<STATS::Moments>(info.sensorNames.size()), _segmentSize > 0 ? SEGMENT_COUNT - 1 : 0);
+	_segStatistics.clear();
+}
+
+void RWMAT::SegmentStatsConsumer::consume(int sensor, qint64 row, const double* values, int count)
+{
+	// 每段位于[i * segmentSize + offset, (i + 1) * segmentSize + offset)，只处理与当前块有交集的段
+	for (int i = 0; i < _stats.size(); ++i) {
+		const qint64 segBegin = qint64(i) * _segmentSize + _offset;
+		const qint64 begin = std::max(segBegin, row);
+		const qint64 end = std::min(segBegin + _segmentSize, row + count);
+		if (begin >= end) {
+			continue;
+		}
+		STATS::accumulate(values + (begin - row), end - begin, _stats[i][sensor]);
+	}
+}
+
+void RWMAT::SegmentStatsConsumer::finish()
+{
+	for (int i = 0; i < _stats.size(); ++i) {
+		QMap<QString, Statistics> segStatistics;
+		for (int s = 0; s < _stats[i].size(); ++s) {
+			segStatistics[_info.sensorNames[s]] = _stats[i][s].toStatistics();
+		}
+		_segStatistics.append(segStatistics);
+	}
+}
+
+RWMAT::RowWindowConsumer::RowWindowConsumer(qint64 rowBegin, qint64 rowEnd, const QVector<BlockConsumer*>& downstream)
+	: _rowBegin(rowBegin), _rowEnd(rowEnd), _downstream(downstream)
+{
+}
+
+void RWMAT::RowWindowConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	StreamInfo window = info;
+	window.dataCount = int(qBound<qint64>(0, _rowEnd, info.dataCount) - qBound<qint64>(0, _rowBegin, info.dataCount));
+	for (auto consumer : _downstream) {
+		consumer->begin(window);
+	}
+}
+
+void RWMAT::RowWindowConsumer::consume(int sensor, qint64 row, const double* values, int count)
+{
+	const qint64 begin = std::max(_rowBegin, row);
+	const qint64 end = std::min(_rowEnd, row + count);
+	if (begin >= end) {
+		return;
+	}
+	for (auto consumer : _downstream) {
+		consumer->consume(sensor, begin - _rowBegin, values + (begin - row), int(end - begin));
+	}
+}
+
+void RWMAT::RowWindowConsumer::finish()
+{
+	for (auto consumer : _downstream) {
+		consumer->finish();
+	}
+}
+
+RWMAT::SegmentWindowConsumer::SegmentWindowConsumer(int index, const QVector<BlockConsumer*>& downstream)
+	: RowWindowConsumer(0, 0, downstream), _index(index)
+{
+}
+
+void RWMAT::SegmentWindowConsumer::begin(const StreamInfo& info)
+{
+	const int segmentSize = info.dataCount < SEGMENT_COUNT ? 0 : info.dataCount / SEGMENT_COUNT;
+	_rowBegin = qint64(_index) * segmentSize + segmentSize / 2;
+	_rowEnd = _rowBegin + segmentSize;
+	RowWindowConsumer::begin(info);
+}
+
+RWMAT::FluctuationConsumer::FluctuationConsumer(double sigmaThreshold, const QVector<BlockConsumer*>& downstream, int order)
+	: _fixedOrder(order), _sigmaThreshold(sigmaThreshold), _downstream(downstream)
+{
+}
+
+void RWMAT::FluctuationConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	_order = std::max(_fixedOrder > 0 ? _fixedOrder : info.frequency, 1);
+	// 与preprocessData一样，只保留完整的order段
+	StreamInfo fluctuation = info;
+	fluctuation.dataCount = info.dataCount / _order * _order;
+	for (auto consumer : _downstream) {
+		consumer->begin(fluctuation);
+	}
+	_pending.fill(Pending(), info.sensorNames.size());
+}
+
+void RWMAT::FluctuationConsumer::consume(int sensor, qint64 row, const double* values, int count)
+{
+	// 传感器从头开始下发时丢弃之前不足一个order的尾巴
+	Pending& pending = _pending[sensor];
+	if (row == 0) {
+		pending.values.clear();
+		pending.emitted = 0;
+	}
+
+	auto emitOrder = [&](const double* data) {
+		double resmin = 0, resmax = 0;
+		PSDA::preprocessData(data, _order, _resData, _romData, _fluctuation, resmin, resmax, _order, _sigmaThreshold);
+		for (auto consumer : _downstream) {
+			consumer->consume(sensor, pending.emitted, _fluctuation.constData(), _order);
+		}
+		pending.emitted += _order;
+	};
+
+	while (count > 0) {
+		// 缓冲为空时直接处理块内完整的order段，避免拷贝
+		if (pending.values.isEmpty() && count >= _order) {
+			emitOrder(values);
+			values += _order;
+			count -= _order;
+			continue;
+		}
+		const int take = std::min(count, _order - pending.values.size());
+		for (int k = 0; k < take; ++k) {
+			pending.values.append(values[k]);
+		}
+		values += take;
+		count -= take;
+		if (pending.values.size() == _order) {
+			emitOrder(pending.values.constData());
+			pending.values.clear();
+		}
+	}
+}
+
+void RWMAT::FluctuationConsumer::finish()
+{
+	for (auto consumer : _downstream) {
+		consumer->finish();
+	}
+}
+
+RWMAT::PsdConsumer::PsdConsumer(const PSDA::WelchConfig& config)
+	: _config(config)
+{
+}
+
+RWMAT::PsdConsumer::~PsdConsumer()
+{
+}
+
+void RWMAT::PsdConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	_accumulators.clear();
+	_accumulators.resize(size_t(info.sensorNames.size()));
+	_freqs.clear();
+	_pxx.clear();
+}
+
+void RWMAT::PsdConsumer::consume(int sensor, qint64 row, const double* values, int count)
+{
+	// 传感器的第一个数据块到达时才创建累加器，下发完毕即输出并释放
+	auto& accumulator = _accumulators[size_t(sensor)];
+	if (!accumulator) {
+		accumulator.reset(new PSDA::WelchAccumulator(_info.dataCount, _info.frequency, _config));
+	}
+	accumulator->append(values, count);
+	if (row + count >= _info.dataCount) {
+		flush(sensor);
+	}
+}
+
+void RWMAT::PsdConsumer::finish()
+{
+	for (int sensor = 0; sensor < int(_accumulators.size()); ++sensor) {
+		flush(sensor);
+	}
+}
+
+void RWMAT::PsdConsumer::flush(int sensor)
+{
+	auto& accumulator = _accumulators[size_t(sensor)];
+	if (!accumulator) {
+		return;
+	}
+	const QString& name = _info.sensorNames[sensor];
+	accumulator->result(_freqs[name], _pxx[name]);
+	accumulator.reset();
+}
+
+RWMAT::DownsampleConsumer::DownsampleConsumer(int maxPoints)
+	: _maxPoints(std::max(maxPoints, 2))
+{
+}
+
+void RWMAT::DownsampleConsumer::begin(const StreamInfo& info)
+{
+	BlockConsumer::begin(info);
+	// 每个区间输出最大、最小两个点
+	const qint64 buckets = _maxPoints / 2;
+	_bucketSize = info.dataCount <= _maxPoints ? 1 : (info.dataCount + buckets - 1) / buckets;
+	_channels.fill(Channel(), info.sensorNames.size());
+	_summaries.clear();
+}
+
+void RWMAT::DownsampleConsumer::consume(int sensor, qint64 row, const double* values, int count)
+{
+	Channel& channel = _channels[sensor];
+	if (!channel.active) {
+		channel.active = true;
+		channel.bucketFilled = 0;
+		channel.summary = SignalSummary();
+		channel.summary.duration = double(_info.dataCount - 1) / _info.frequency;
+		channel.summary.min = channel.summary.max = values[0];
+		channel.summary.times.reserve(int(std::min<qint64>(_info.dataCount, _maxPoints)));
+		channel.summary.values.reserve(int(std::min<qint64>(_info.dataCount, _maxPoints)));
+	}
+
+	for (int k = 0; k < count; ++k) {
+		const double value = values[k];
+		if (0 == channel.bucketFilled) {
+			channel.minRow = channel.maxRow = row + k;
+			channel.minValue = channel.maxValue = value;
+		}
+		else if (value < channel.minValue) {
+			channel.minValue = value;
+			channel.minRow = row + k;
+		}
+		else if (value > channel.maxValue) {
+			channel.maxValue = value;
+			channel.maxRow = row + k;
+		}
+		if (++channel.bucketFilled == _bucketSize) {
+			flushBucket(channel);
+		}
+	}
+	if (row + count >= _info.dataCount) {
+		flush(sensor);
+	}
+}
+
+void RWMAT::DownsampleConsumer::finish()
+{
+	for (int sensor = 0; sensor < _channels.size(); ++sensor) {
+		flush(sensor);
+	}
+}
+
+void RWMAT::DownsampleConsumer::flush(int sensor)
+{
+	Channel& channel = _channels[sensor];
+	if (!channel.active) {
+		return;
+	}
+	flushBucket(channel);
+	_summaries[_info.sensorNames[sensor]] = channel.summary;
+	channel = Channel();
+}
+
+void RWMAT::DownsampleConsumer::flushBucket(Channel& channel)
+{
+	if (0 == channel.bucketFilled) {
+		return;
+	}
+	// 按原先后顺序输出区间内的极值点
+	const double dt = 1.0 / _info.frequency;
+	const qint64 first = std::min(channel.minRow, channel.maxRow);
+	const qint64 second = std::max(channel.minRow, channel.maxRow);
+	SignalSummary& summary = channel.summary;
+	summary.times.append(first * dt);
+	summary.values.append(first == channel.minRow ? channel.minValue : channel.maxValue);
+	if (second != first) {
+		summary.times.append(second * dt);
+		summary.values.append(second == channel.minRow ? channel.minValue : channel.maxValue);
+	}
+	summary.min = std::min(summary.min, channel.minValue);
+	summary.max = std::max(summary.max, channel.maxValue);
+	channel.bucketFilled = 0;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "app/ProjectData.h"
+#include "app/StatsKernel.h"
+#include "charts/WelchConfig.h"
+
+namespace PSDA { class WelchAccumulator; }
+
+namespace RWMAT
+{
+	// 流式读取时下发给各消费者的数据描述
+	struct StreamInfo
+	{
+		QString wcname{ "" };			//从属于的工况名称
+		int frequency{ 100 };			//采集频率
+		int dataCount{ 0 };				//每个传感器将下发的数据点数量(裁剪后)
+		QStringList sensorNames{};		//将下发的传感器，consume中的sensor即为该列表的下标
+	};
+
+	/**
+	 * @brief 数据块消费者
+	 *
+	 * 每个传感器的数据块按行号递增下发；MAT v5按传感器(列)顺序逐个下发，v7.3同一分块列组内的传感器按窗口交替下发，
+	 * 因此消费者按传感器分别保存状态，一个传感器的数据下发到dataCount时即可输出其结果，内存占用与数据总量无关。
+	 */
+	class BlockConsumer
+	{
+	public:
+		virtual ~BlockConsumer() = default;
+
+		virtual void begin(const StreamInfo& info) { _info = info; }
+		// row为values[0]相对数据起点(裁剪后)的行号
+		virtual void consume(int sensor, qint64 row, const double* values, int count) = 0;
+		virtual void finish() {}
+
+		const StreamInfo& info() const { return _info; }
+
+	protected:
+		StreamInfo _info{};
+	};
+
+	// 全过程统计：max/min/rms，与readMatFile的statistics一致
+	class StatsConsumer : public BlockConsumer
+	{
+	public:
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+		const QMap<QString, Statistics>& statistics() const { return _statistics; }
+
+	private:
+		QVector<STATS::Moments> _stats{};
+		QMap<QString, Statistics> _statistics{};
+	};
+
+	// 分段统计：分段方式与ProjectData::processSegmentedData一致(SEGMENT_COUNT-1段，每段位于相邻两段的中间)
+	class SegmentStatsConsumer : public BlockConsumer
+	{
+	public:
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+		int dataCountEach() const { return _segmentSize; }
+		const QVector<QMap<QString, Statistics>>& segStatistics() const { return _segStatistics; }
+
+	private:
+		int _segmentSize{ 0 };
+		int _offset{ 0 };
+		QVector<QVector<STATS::Moments>> _stats{};	//[段][传感器]
+		QVector<QMap<QString, Statistics>> _segStatistics{};
+	};
+
+	// 只把[rowBegin, rowEnd)范围内的数据(行号从0重新计)转发给下游，用于分段分析
+	class RowWindowConsumer : public BlockConsumer
+	{
+	public:
+		RowWindowConsumer(qint64 rowBegin, qint64 rowEnd, const QVector<BlockConsumer*>& downstream);
+
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+	protected:
+		qint64 _rowBegin{ 0 };
+		qint64 _rowEnd{ 0 };
+		QVector<BlockConsumer*> _downstream{};
+	};
+
+	// 第index段的数据窗口，分段方式与SegmentStatsConsumer一致，范围在begin时按数据点数量确定
+	class SegmentWindowConsumer : public RowWindowConsumer
+	{
+	public:
+		SegmentWindowConsumer(int index, const QVector<BlockConsumer*>& downstream);
+
+		void begin(const StreamInfo& info) override;
+
+	private:
+		int _index{ 0 };
+	};
+
+	/**
+	 * @brief 按阶次(order)逐块执行PSDA::preprocessData，把原始数据转换为去运行均值后的波动数据转发给下游
+	 *
+	 * 只缓存一个order长度的数据，结果与对整列调用PSDA::preprocessData得到的fluctuation一致；
+	 * 末尾不足一个order的数据与preprocessData一样被丢弃。order<=0时取采样频率(与ChartPainter一致)。
+	 */
+	class FluctuationConsumer : public BlockConsumer
+	{
+	public:
+		FluctuationConsumer(double sigmaThreshold, const QVector<BlockConsumer*>& downstream, int order = 0);
+
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+	private:
+		int _fixedOrder{ 0 };
+		int _order{ 1 };
+		double _sigmaThreshold{ 2.0 };
+		QVector<BlockConsumer*> _downstream{};
+		// 各传感器尚不足一个order的数据及已转发的点数
+		struct Pending
+		{
+			QVector<double> values{};
+			qint64 emitted{ 0 };
+		};
+		QVector<Pending> _pending{};
+		QVector<double> _resData{};
+		QVector<double> _romData{};
+		QVector<double> _fluctuation{};
+	};
+
+	// Welch功率谱，与相同config下的PSDA::calculatePowerSpectralDensity一致
+	class PsdConsumer : public BlockConsumer
+	{
+	public:
+		explicit PsdConsumer(const PSDA::WelchConfig& config = PSDA::WelchConfig());
+		~PsdConsumer();
+
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+		const QMap<QString, QVector<double>>& freqs() const { return _freqs; }
+		const QMap<QString, QVector<double>>& pxx() const { return _pxx; }
+
+	private:
+		void flush(int sensor);
+
+	private:
+		PSDA::WelchConfig _config{};
+		std::vector<std::unique_ptr<PSDA::WelchAccumulator>> _accumulators{};	//正在累加的传感器
+		QMap<QString, QVector<double>> _freqs{};
+		QMap<QString, QVector<double>> _pxx{};
+	};
+
+	/**
+	 * @brief 时域曲线降采样(每个区间保留最大、最小值两个点，按原先后顺序)
+	 *
+	 * 数据点不超过maxPoints时原样保留；输出的横轴为时间(s)，峰谷不会因降采样丢失，
+	 * 用于在不保留原始数据的情况下绘制时域过程图。
+	 */
+	class DownsampleConsumer : public BlockConsumer
+	{
+	public:
+		explicit DownsampleConsumer(int maxPoints = 8192);
+
+		void begin(const StreamInfo& info) override;
+		void consume(int sensor, qint64 row, const double* values, int count) override;
+		void finish() override;
+
+		const QMap<QString, SignalSummary>& summaries() const { return _summaries; }
+
+	private:
+		// 一个传感器的降采样状态
+		struct Channel
+		{
+			bool active{ false };
+			SignalSummary summary{};
+			qint64 bucketFilled{ 0 };
+			qint64 minRow{ 0 };
+			qint64 maxRow{ 0 };
+			double minValue{ 0.0 };
+			double maxValue{ 0.0 };
+		};
+		void flushBucket(Channel& channel);
+		void flush(int sensor);
+
+	private:
+		int _maxPoints{ 8192 };
+		qint64 _bucketSize{ 1 };
+		QVector<Channel> _channels{};
+		QMap<QString, SignalSummary> _summaries{};
+	};
+};
@@ -0,0 +1,693 @@
+#include "MatV5Reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QtEndian>
+
+#include <zlib.h>
+
+namespace
+{
+	// MAT v5 文件头固定128字节，数据元素按8字节对齐
+	constexpr qint64 MAT_HEADER_SIZE = 128;
+	constexpr int INFLATE_BUFFER_SIZE = 256 * 1024;
+	constexpr qint64 MAX_TEXT_BYTES = 1024 * 1024;
+
+	struct MatTag
+	{
+		quint32 type{ 0 };
+		quint32 bytes{ 0 };
+		bool small{ false };		//小数据元素格式(数据<=4字节，直接打包在tag里)
+		char smallData[4]{};
+	};
+
+	inline qint64 padded8(qint64 n)
+	{
+		return (n + 7) & ~qint64(7);
+	}
+
+	inline quint32 load32(const char* raw, bool swap)
+	{
+		quint32 v;
+		std::memcpy(&v, raw, sizeof(v));
+		return swap ? qbswap(v) : v;
+	}
+
+	template<typename T>
+	inline T loadValue(const char* raw, bool swap)
+	{
+		char bytes[sizeof(T)];
+		std::memcpy(bytes, raw, sizeof(T));
+		if (swap) {
+			std::reverse(bytes, bytes + sizeof(T));
+		}
+		T v;
+		std::memcpy(&v, bytes, sizeof(T));
+		return v;
+	}
+
+	template<typename T>
+	void convertSamples(const char* src, double* dst, int count, bool swap)
+	{
+		for (int i = 0; i < count; ++i) {
+			dst[i] = static_cast<double>(loadValue<T>(src + i * sizeof(T), swap));
+		}
+	}
+
+	bool isNumericClass(int mxClass)
+	{
+		return mxClass >= RWMAT::mxDOUBLE_CLASS && mxClass <= RWMAT::mxUINT64_CLASS;
+	}
+}
+
+int RWMAT::matDataTypeSize(int dataType)
+{
+	switch (dataType)
+	{
+	case miINT8:
+	case miUINT8:
+	case miUTF8:
+		return 1;
+	case miINT16:
+	case miUINT16:
+	case miUTF16:
+		return 2;
+	case miINT32:
+	case miUINT32:
+	case miSINGLE:
+	case miUTF32:
+		return 4;
+	case miDOUBLE:
+	case miINT64:
+	case miUINT64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+// 顺序字节流：未压缩元素直接读文件，压缩元素边读边解压
+class RWMAT::MatV5Reader::ElementStream
+{
+public:
+	virtual ~ElementStream() = default;
+	virtual bool read(char* dst, qint64 n) = 0;
+	virtual bool skip(qint64 n) = 0;
+	// 流内的逻辑位置(未压缩时即文件偏移)
+	virtual qint64 position() const = 0;
+
+	bool readTag(bool swap, MatTag& tag)
+	{
+		char raw[8];
+		if (!read(raw, 8)) {
+			return false;
+		}
+		const quint32 w0 = load32(raw, swap);
+		if ((w0 >> 16) != 0) {
+			tag.small = true;
+			tag.type = w0 & 0xFFFF;
+			tag.bytes = w0 >> 16;
+			std::memcpy(tag.smallData, raw + 4, 4);
+		}
+		else {
+			tag.small = false;
+			tag.type = w0;
+			tag.bytes = load32(raw + 4, swap);
+		}
+		return true;
+	}
+
+	// 读取一个子元素的数据(含对齐填充)
+	bool readElementData(const MatTag& tag, QByteArray& bytes)
+	{
+		if (tag.small) {
+			bytes = QByteArray(tag.smallData, qMin<int>(tag.bytes, 4));
+			return true;
+		}
+		bytes.resize(int(tag.bytes));
+		if (!read(bytes.data(), tag.bytes)) {
+			return false;
+		}
+		return skip(padded8(tag.bytes) - tag.bytes);
+	}
+};
+
+class RWMAT::MatV5Reader::FileStream : public ElementStream
+{
+public:
+	explicit FileStream(QFile* file) : _file(file) {}
+
+	bool read(char* dst, qint64 n) override
+	{
+		return _file->read(dst, n) == n;
+	}
+	bool skip(qint64 n) override
+	{
+		return n == 0 || _file->seek(_file->pos() + n);
+	}
+	qint64 position() const override
+	{
+		return _file->pos();
+	}
+
+private:
+	QFile* _file;
+};
+
+class RWMAT::MatV5Reader::InflateStream : public ElementStream
+{
+public:
+	InflateStream(QFile* file, qint64 offset, qint64 size)
+		: _file(file)
+		, _remaining(size)
+		, _input(INFLATE_BUFFER_SIZE, Qt::Uninitialized)
+	{
+		std::memset(&_zs, 0, sizeof(_zs));
+		_valid = _file->seek(offset) && inflateInit(&_zs) == Z_OK;
+	}
+	~InflateStream() override
+	{
+		if (_valid) {
+			inflateEnd(&_zs);
+		}
+	}
+
+	bool read(char* dst, qint64 n) override
+	{
+		if (!_valid) {
+			return false;
+		}
+		while (n > 0) {
+			const uInt chunk = uInt(qMin<qint64>(n, 1 << 30));
+			_zs.next_out = reinterpret_cast<Bytef*>(dst);
+			_zs.avail_out = chunk;
+			while (_zs.avail_out > 0) {
+				if (_zs.avail_in == 0 && !fillInput()) {
+					return false;
+				}
+				const int ret = inflate(&_zs, Z_NO_FLUSH);
+				if (ret == Z_STREAM_END) {
+					if (_zs.avail_out > 0) {
+						qWarning() << "Compressed MAT element ended early";
+						return false;
+					}
+					break;
+				}
+				if (ret != Z_OK && !(ret == Z_BUF_ERROR && _zs.avail_in == 0)) {
+					qWarning() << "Inflate MAT element failed, zlib error:" << ret;
+					return false;
+				}
+			}
+			dst += chunk;
+			n -= chunk;
+		}
+		return true;
+	}
+	bool skip(qint64 n) override
+	{
+		if (n <= 0) {
+			return true;
+		}
+		if (_discard.isEmpty()) {
+			_discard.resize(INFLATE_BUFFER_SIZE);
+		}
+		while (n > 0) {
+			const qint64 chunk = qMin<qint64>(n, _discard.size());
+			if (!read(_discard.data(), chunk)) {
+				return false;
+			}
+			n -= chunk;
+		}
+		return true;
+	}
+	qint64 position() const override
+	{
+		return qint64(_zs.total_out);
+	}
+
+private:
+	bool fillInput()
+	{
+		if (_remaining <= 0) {
+			qWarning() << "Compressed MAT element is truncated";
+			return false;
+		}
+		const qint64 want = qMin<qint64>(_remaining, _input.size());
+		const qint64 got = _file->read(_input.data(), want);
+		if (got <= 0) {
+			return false;
+		}
+		_remaining -= got;
+		_zs.next_in = reinterpret_cast<Bytef*>(_input.data());
+		_zs.avail_in = uInt(got);
+		return true;
+	}
+
+private:
+	QFile* _file;
+	qint64 _remaining;
+	QByteArray _input;
+	QByteArray _discard;
+	z_stream _zs;
+	bool _valid{ false };
+};
+
+class RWMAT::MatV5Reader::MemoryStream : public ElementStream
+{
+public:
+	explicit MemoryStream(const QByteArray& bytes) : _bytes(bytes) {}
+
+	bool read(char* dst, qint64 n) override
+	{
+		if (_pos + n > _bytes.size()) {
+			return false;
+		}
+		std::memcpy(dst, _bytes.constData() + _pos, size_t(n));
+		_pos += n;
+		return true;
+	}
+	bool skip(qint64 n) override
+	{
+		if (_pos + n > _bytes.size()) {
+			return false;
+		}
+		_pos += n;
+		return true;
+	}
+	qint64 position() const override
+	{
+		return _pos;
+	}
+
+private:
+	QByteArray _bytes;
+	qint64 _pos{ 0 };
+};
+
+RWMAT::MatMapping::~MatMapping()
+{
+	if (_file && _base) {
+		_file->unmap(_base);
+	}
+}
+
+RWMAT::MatV5Reader::MatV5Reader(const QString& filepath)
+	: _filepath(filepath)
+{
+}
+
+RWMAT::MatV5Reader::~MatV5Reader()
+{
+	close();
+}
+
+bool RWMAT::MatV5Reader::open()
+{
+	close();
+	_file = new QFile(_filepath);
+	if (!_file->open(QIODevice::ReadOnly)) {
+		qWarning() << "Failed to open MAT file:" << _filepath;
+		close();
+		return false;
+	}
+
+	// 1. 文件头校验：116字节描述文本 + 8字节子系统偏移 + 2字节版本 + 2字节字节序标记
+	char header[MAT_HEADER_SIZE];
+	if (_file->read(header, MAT_HEADER_SIZE) != MAT_HEADER_SIZE) {
+		qWarning() << "MAT file too small:" << _filepath;
+		close();
+		return false;
+	}
+	const bool fileLittleEndian = (header[126] == 'I' && header[127] == 'M');
+	const bool fileBigEndian = (header[126] == 'M' && header[127] == 'I');
+	if (!fileLittleEndian && !fileBigEndian) {
+		qWarning() << "Not a MAT v5 file:" << _filepath;
+		close();
+		return false;
+	}
+	_swap = (fileLittleEndian != (Q_BYTE_ORDER == Q_LITTLE_ENDIAN));
+
+	quint16 version;
+	std::memcpy(&version, header + 124, sizeof(version));
+	if (_swap) {
+		version = qbswap(version);
+	}
+	if (version != 0x0100) {
+		qWarning() << "Unsupported MAT file version" << version << "in" << _filepath;
+		close();
+		return false;
+	}
+
+	// 2. 扫描顶层变量头
+	if (!scanVariables()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void RWMAT::MatV5Reader::close()
+{
+	if (_file) {
+		_file->close();
+		delete _file;
+		_file = nullptr;
+	}
+	// 已有的映射仍持有文件句柄
+	_mapFile.reset();
+	_variables.clear();
+}
+
+const RWMAT::MatVariable* RWMAT::MatV5Reader::variable(const QString& name) const
+{
+	for (const auto& var : _variables) {
+		if (var.name == name) {
+			return &var;
+		}
+	}
+	return nullptr;
+}
+
+bool RWMAT::MatV5Reader::scanVariables()
+{
+	_variables.clear();
+	const qint64 fileSize = _file->size();
+	qint64 pos = MAT_HEADER_SIZE;
+	while (pos + 8 <= fileSize) {
+		if (!_file->seek(pos)) {
+			return false;
+		}
+		FileStream fileStream(_file);
+		MatTag tag;
+		if (!fileStream.readTag(_swap, tag)) {
+			break;
+		}
+		if (tag.small) {
+			pos += 8;
+			continue;
+		}
+
+		MatVariable var;
+		var.elementOffset = pos;
+		bool parsed = false;
+		qint64 next = 0;
+		if (tag.type == miCOMPRESSED) {
+			// 压缩元素不做8字节对齐，紧接着就是下一个元素
+			next = pos + 8 + tag.bytes;
+			InflateStream inflater(_file, pos + 8, tag.bytes);
+			MatTag inner;
+			if (inflater.readTag(_swap, inner) && inner.type == miMATRIX) {
+				var.compressed = true;
+				parsed = parseMatrixHeader(inflater, var);
+				var.dataOffset = -1;
+			}
+		}
+		else {
+			next = pos + 8 + padded8(tag.bytes);
+			if (tag.type == miMATRIX) {
+				parsed = parseMatrixHeader(fileStream, var);
+			}
+		}
+		var.elementSize = next - pos;
+		if (parsed) {
+			_variables.append(var);
+		}
+		else {
+			qDebug() << "Skipping unsupported MAT element at offset" << pos << "in" << _filepath;
+		}
+		pos = next;
+	}
+	return true;
+}
+
+bool RWMAT::MatV5Reader::parseMatrixHeader(ElementStream& stream, MatVariable& var, QByteArray* smallData)
+{
+	// 1. 数组标志：低8位为类型，bit11为复数标志
+	MatTag tag;
+	QByteArray bytes;
+	if (!stream.readTag(_swap, tag) || tag.type != miUINT32 || !stream.readElementData(tag, bytes) || bytes.size() < 4) {
+		return false;
+	}
+	const quint32 flags = load32(bytes.constData(), _swap);
+	var.mxClass = int(flags & 0xFF);
+	var.complex = (flags & 0x0800) != 0;
+
+	// 2. 维度：第一维为行，其余维度折叠为列
+	if (!stream.readTag(_swap, tag) || tag.type != miINT32 || !stream.readElementData(tag, bytes) || bytes.size() < 8) {
+		return false;
+	}
+	var.rows = quint64(qint32(load32(bytes.constData(), _swap)));
+	var.cols = 1;
+	for (int i = 4; i + 4 <= bytes.size(); i += 4) {
+		var.cols *= quint64(qint32(load32(bytes.constData() + i, _swap)));
+	}
+
+	// 3. 变量名
+	if (!stream.readTag(_swap, tag) || tag.type != miINT8 || !stream.readElementData(tag, bytes)) {
+		return false;
+	}
+	var.name = QString::fromLatin1(bytes.constData(), int(qstrnlen(bytes.constData(), uint(bytes.size()))));
+
+	// 4. 实部数据tag，数据本身不读取
+	if (var.mxClass != mxCHAR_CLASS && !isNumericClass(var.mxClass)) {
+		var.dataType = 0;
+		return true;
+	}
+	if (!stream.readTag(_swap, tag) || matDataTypeSize(tag.type) == 0) {
+		return false;
+	}
+	var.dataType = int(tag.type);
+	var.dataBytes = tag.bytes;
+	var.dataOffset = stream.position() - (tag.small ? 4 : 0);
+	if (smallData) {
+		*smallData = tag.small ? QByteArray(tag.smallData, qMin<int>(tag.bytes, 4)) : QByteArray();
+	}
+	return true;
+}
+
+std::unique_ptr<RWMAT::MatV5Reader::ElementStream> RWMAT::MatV5Reader::openDataStream(const MatVariable& var)
+{
+	if (!_file || var.dataType == 0) {
+		return nullptr;
+	}
+	if (!var.compressed) {
+		if (var.dataOffset < 0 || !_file->seek(var.dataOffset)) {
+			return nullptr;
+		}
+		return std::unique_ptr<ElementStream>(new FileStream(_file));
+	}
+
+	// 压缩元素只能从头解压，重新解析一遍矩阵头以定位到实部数据
+	std::unique_ptr<InflateStream> inflater(new InflateStream(_file, var.elementOffset + 8, var.elementSize - 8));
+	MatTag tag;
+	MatVariable header;
+	QByteArray smallData;
+	if (!inflater->readTag(_swap, tag) || tag.type != miMATRIX || !parseMatrixHeader(*inflater, header, &smallData)) {
+		qWarning() << "Failed to re-parse compressed variable" << var.name;
+		return nullptr;
+	}
+	if (!smallData.isEmpty()) {
+		return std::unique_ptr<ElementStream>(new MemoryStream(smallData));
+	}
+	return inflater;
+}
+
+bool RWMAT::MatV5Reader::isMappable(const MatVariable& var) const
+{
+	return !var.compressed
+		&& !_swap
+		&& var.dataType == miDOUBLE
+		&& var.dataOffset >= 0
+		&& var.dataOffset % qint64(alignof(double)) == 0
+		&& var.rows * var.cols * sizeof(double) <= var.dataBytes;
+}
+
+std::shared_ptr<RWMAT::MatMapping> RWMAT::MatV5Reader::mapRealPart(const MatVariable& var, quint64 first, quint64 count)
+{
+	if (!isMappable(var) || count == 0 || first + count > var.rows * var.cols) {
+		return nullptr;
+	}
+	// 映射使用独立的文件句柄，映射的生命周期与读取器无关
+	if (!_mapFile) {
+		auto file = std::make_shared<QFile>(_filepath);
+		if (!file->open(QIODevice::ReadOnly)) {
+			qWarning() << "Failed to open MAT file for mapping:" << _filepath;
+			return nullptr;
+		}
+		_mapFile = file;
+	}
+	std::shared_ptr<MatMapping> mapping(new MatMapping());
+	mapping->_file = _mapFile;
+	mapping->_count = count;
+	mapping->_base = mapping->_file->map(var.dataOffset + qint64(first * sizeof(double)), qint64(count * sizeof(double)));
+	if (!mapping->_base) {
+		qWarning() << "Failed to map variable" << var.name << "in" << _filepath;
+		return nullptr;
+	}
+	mapping->_data = reinterpret_cast<const double*>(mapping->_base);
+	if (quintptr(mapping->_data) % alignof(double) != 0) {
+		return nullptr;
+	}
+	return mapping;
+}
+
+bool RWMAT::MatV5Reader::readRealPart(const MatVariable& var, QByteArray& bytes)
+{
+	if (qint64(var.dataBytes) > MAX_TEXT_BYTES) {
+		return false;
+	}
+	auto stream = openDataStream(var);
+	if (!stream) {
+		return false;
+	}
+	bytes.resize(int(var.dataBytes));
+	return stream->read(bytes.data(), bytes.size());
+}
+
+bool RWMAT::MatV5Reader::readText(const MatVariable& var, QString& text)
+{
+	QByteArray bytes;
+	if (var.mxClass != mxCHAR_CLASS || !readRealPart(var, bytes)) {
+		return false;
+	}
+	const int unit = matDataTypeSize(var.dataType);
+	const int count = bytes.size() / unit;
+	switch (unit)
+	{
+	case 1:
+		text = QString::fromUtf8(bytes.constData(), count);
+		return true;
+	case 2:
+	{
+		QVector<char16_t> chars(count);
+		for (int i = 0; i < count; ++i) {
+			chars[i] = loadValue<char16_t>(bytes.constData() + i * 2, _swap);
+		}
+		text = QString::fromUtf16(chars.constData(), count);
+		return true;
+	}
+	case 4:
+	{
+		QVector<char32_t> chars(count);
+		for (int i = 0; i < count; ++i) {
+			chars[i] = loadValue<char32_t>(bytes.constData() + i * 4, _swap);
+		}
+		text = QString::fromUcs4(chars.constData(), count);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool RWMAT::MatV5Reader::readScalar(const MatVariable& var, double& value)
+{
+	if (!isNumericClass(var.mxClass) || var.rows == 0 || var.cols == 0) {
+		return false;
+	}
+	bool got = false;
+	QVector<bool> firstColumn(int(qMin<quint64>(var.cols, 1)), true);
+	readColumns(var, 0, 1, firstColumn, 1, [&](int, qint64, const double* values, int count) {
+		if (count > 0) {
+			value = values[0];
+			got = true;
+		}
+		return false;
+		});
+	return got;
+}
+
+bool RWMAT::MatV5Reader::readColumns(
+	const MatVariable& var,
+	qint64 rowBegin,
+	qint64 rowEnd,
+	const QVector<bool>& columnFilter,
+	int blockRows,
+	const BlockHandler& handler
+)
+{
+	// 1. 参数与数据完整性校验
+	const int elemSize = matDataTypeSize(var.dataType);
+	if (elemSize == 0 || blockRows <= 0) {
+		qWarning() << "Variable" << var.name << "can not be decoded as numeric array";
+		return false;
+	}
+	const qint64 rows = qint64(var.rows);
+	const qint64 cols = qint64(var.cols);
+	if (quint64(rows * cols * elemSize) > var.dataBytes) {
+		qWarning() << "Variable" << var.name << "is truncated, expected" << rows * cols * elemSize << "bytes, actual" << var.dataBytes;
+		return false;
+	}
+	rowBegin = qBound<qint64>(0, rowBegin, rows);
+	rowEnd = qBound<qint64>(rowBegin, rowEnd, rows);
+
+	qint64 lastCol = -1;
+	for (qint64 col = cols - 1; col >= 0; --col) {
+		if (columnFilter.isEmpty() || (col < qint64(columnFilter.size()) && columnFilter[int(col)])) {
+			lastCol = col;
+			break;
+		}
+	}
+	if (lastCol < 0 || rowBegin == rowEnd) {
+		return true;
+	}
+
+	// 2. 按列顺序解码，不需要的区间整体跳过
+	auto stream = openDataStream(var);
+	if (!stream) {
+		return false;
+	}
+	const bool directCopy = (var.dataType == miDOUBLE && !_swap);
+	QVector<double> values(blockRows);
+	QByteArray raw(directCopy ? 0 : blockRows * elemSize, Qt::Uninitialized);
+	qint64 consumed = 0; // 已经越过的元素个数
+	for (qint64 col = 0; col <= lastCol; ++col) {
+		if (!columnFilter.isEmpty() && !(col < qint64(columnFilter.size()) && columnFilter[int(col)])) {
+			continue;
+		}
+		const qint64 target = col * rows + rowBegin;
+		if (!stream->skip((target - consumed) * elemSize)) {
+			qWarning() << "Failed to seek variable" << var.name << "column" << col;
+			return false;
+		}
+		consumed = target;
+
+		for (qint64 row = rowBegin; row < rowEnd;) {
+			const int count = int(qMin<qint64>(blockRows, rowEnd - row));
+			if (directCopy) {
+				if (!stream->read(reinterpret_cast<char*>(values.data()), qint64(count) * elemSize)) {
+					return false;
+				}
+			}
+			else {
+				if (!stream->read(raw.data(), qint64(count) * elemSize)) {
+					return false;
+				}
+				const char* src = raw.constData();
+				switch (var.dataType)
+				{
+				case miINT8: convertSamples<qint8>(src, values.data(), count, _swap); break;
+				case miUINT8: convertSamples<quint8>(src, values.data(), count, _swap); break;
+				case miINT16: convertSamples<qint16>(src, values.data(), count, _swap); break;
+				case miUINT16: convertSamples<quint16>(src, values.data(), count, _swap); break;
+				case miINT32: convertSamples<qint32>(src, values.data(), count, _swap); break;
+				case miUINT32: convertSamples<quint32>(src, values.data(), count, _swap); break;
+				case miSINGLE: convertSamples<float>(src, values.data(), count, _swap); break;
+				case miDOUBLE: convertSamples<double>(src, values.data(), count, _swap); break;
+				case miINT64: convertSamples<qint64>(src, values.data(), count, _swap); break;
+				case miUINT64: convertSamples<quint64>(src, values.data(), count, _swap); break;
+				default: return false;
+				}
+			}
+			consumed += count;
+			if (!handler(int(col), row, values.constData(), count)) {
+				return false;
+			}
+			row += count;
+		}
+	}
+	return true;
+}
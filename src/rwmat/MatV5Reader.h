@@ -0,0 +1,176 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+namespace RWMAT
+{
+	// MAT v5 数据元素类型(miXXX)
+	enum MatDataType
+	{
+		miINT8 = 1,
+		miUINT8 = 2,
+		miINT16 = 3,
+		miUINT16 = 4,
+		miINT32 = 5,
+		miUINT32 = 6,
+		miSINGLE = 7,
+		miDOUBLE = 9,
+		miINT64 = 12,
+		miUINT64 = 13,
+		miMATRIX = 14,
+		miCOMPRESSED = 15,
+		miUTF8 = 16,
+		miUTF16 = 17,
+		miUTF32 = 18
+	};
+
+	// MAT v5 数组类型(mxXXX_CLASS)
+	enum MatClass
+	{
+		mxCELL_CLASS = 1,
+		mxSTRUCT_CLASS = 2,
+		mxOBJECT_CLASS = 3,
+		mxCHAR_CLASS = 4,
+		mxSPARSE_CLASS = 5,
+		mxDOUBLE_CLASS = 6,
+		mxSINGLE_CLASS = 7,
+		mxINT8_CLASS = 8,
+		mxUINT8_CLASS = 9,
+		mxINT16_CLASS = 10,
+		mxUINT16_CLASS = 11,
+		mxINT32_CLASS = 12,
+		mxUINT32_CLASS = 13,
+		mxINT64_CLASS = 14,
+		mxUINT64_CLASS = 15
+	};
+
+	// 顶层变量的头信息(只解析数组标志、维度与名称，不解码数据)
+	struct MatVariable
+	{
+		QString name{ "" };				//变量名
+		int mxClass{ 0 };				//数组类型(mxXXX_CLASS)
+		int dataType{ 0 };				//实部数据的存储类型(miXXX)，MATLAB会把整数值的double压成更小的类型存储
+		bool complex{ false };			//是否为复数
+		quint64 rows{ 0 };				//行数(二维以上的维度折叠进列数)
+		quint64 cols{ 0 };				//列数
+		bool compressed{ false };		//是否为miCOMPRESSED压缩元素
+		qint64 elementOffset{ 0 };		//顶层数据元素(含tag)在文件中的偏移
+		qint64 elementSize{ 0 };		//顶层数据元素(含tag)的字节数
+		qint64 dataOffset{ -1 };		//实部数据在文件中的偏移，仅未压缩元素有效
+		quint64 dataBytes{ 0 };			//实部数据字节数(未压缩时的大小)
+	};
+
+	int matDataTypeSize(int dataType);
+
+	// 变量实部数据中一段元素的只读内存映射，析构时解除映射；同一读取器的映射共用一个文件句柄，最后一个映射析构时关闭
+	class MatMapping
+	{
+	public:
+		~MatMapping();
+
+		MatMapping(const MatMapping&) = delete;
+		MatMapping& operator=(const MatMapping&) = delete;
+
+		// 映射区起始处，即所映射的第一个元素(列主序)
+		const double* data() const { return _data; }
+		quint64 count() const { return _count; }
+
+	private:
+		friend class MatV5Reader;
+		MatMapping() = default;
+
+		std::shared_ptr<QFile> _file{};
+		uchar* _base{ nullptr };
+		const double* _data{ nullptr };
+		quint64 _count{ 0 };
+	};
+
+	/**
+	 * @brief 自实现的MAT v5文件读取器，替代libmat/libmx
+	 *
+	 * open()只扫描顶层变量的头部，数据按需顺序解码；
+	 * 支持未压缩元素与zlib压缩的miCOMPRESSED元素，支持大小端互换。
+	 * 只支持数值/字符类型的实数数组，稀疏、cell、struct等类型只记录头信息不解码。
+	 */
+	class MatV5Reader
+	{
+	public:
+		// 列数据块回调：col为列号，row为该块第一个元素的行号，返回false中止解码
+		using BlockHandler = std::function<bool(int col, qint64 row, const double* values, int count)>;
+
+		explicit MatV5Reader(const QString& filepath);
+		~MatV5Reader();
+
+		MatV5Reader(const MatV5Reader&) = delete;
+		MatV5Reader& operator=(const MatV5Reader&) = delete;
+
+		// 校验文件头并扫描全部顶层变量头
+		bool open();
+		void close();
+
+		QString filePath() const { return _filepath; }
+		// 文件字节序与本机不一致
+		bool byteSwapped() const { return _swap; }
+		const QVector<MatVariable>& variables() const { return _variables; }
+		// 按变量名查找，找不到返回nullptr
+		const MatVariable* variable(const QString& name) const;
+
+		// 变量能否零拷贝映射：未压缩、miDOUBLE存储、字节序与本机一致且8字节对齐
+		bool isMappable(const MatVariable& var) const;
+		// 映射变量实部数据中[first, first + count)的元素(列主序)，每个映射单独释放；不可映射或映射失败时返回nullptr
+		std::shared_ptr<MatMapping> mapRealPart(const MatVariable& var, quint64 first, quint64 count);
+
+		// 读取字符数组变量(如SampleFrequency)
+		bool readText(const MatVariable& var, QString& text);
+		// 读取数值变量的第一个元素
+		bool readScalar(const MatVariable& var, double& value);
+
+		/**
+		 * @brief 按列(列主序)顺序解码实数数据
+		 *
+		 * 每列只回调[rowBegin, rowEnd)范围内的行，按blockRows分块；
+		 * 未选中的列直接跳过(未压缩时seek，压缩时解压丢弃)，最后一个选中列之后不再解码。
+		 *
+		 * @param var 要解码的变量
+		 * @param rowBegin 起始行(含)
+		 * @param rowEnd 结束行(不含)
+		 * @param columnFilter 列选择标记，为空时表示全部列
+		 * @param blockRows 每次回调的最大行数
+		 * @param handler 数据块回调
+		 * @return bool 是否完整解码(handler中止也返回false)
+		 */
+		bool readColumns(
+			const MatVariable& var,
+			qint64 rowBegin,
+			qint64 rowEnd,
+			const QVector<bool>& columnFilter,
+			int blockRows,
+			const BlockHandler& handler
+		);
+
+	private:
+		class ElementStream;
+		class FileStream;
+		class InflateStream;
+		class MemoryStream;
+
+		bool scanVariables();
+		bool parseMatrixHeader(ElementStream& stream, MatVariable& var, QByteArray* smallData = nullptr);
+		// 打开变量的数据流，并定位到实部数据起始处
+		std::unique_ptr<ElementStream> openDataStream(const MatVariable& var);
+		bool readRealPart(const MatVariable& var, QByteArray& bytes);
+
+	private:
+		QString _filepath{};
+		QFile* _file{ nullptr };
+		std::shared_ptr<QFile> _mapFile{};	//映射使用的独立文件句柄，由各映射共同持有
+		bool _swap{ false };
+		QVector<MatVariable> _variables{};
+	};
+};
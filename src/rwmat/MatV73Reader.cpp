@@ -0,0 +1,637 @@
+#include "MatV73Reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <zlib.h>
+
+#ifdef SENSORVIZ_HAS_HDF5
+#include <hdf5.h>
+#endif
+
+namespace
+{
+	// v7.3文件仍以128字节MAT头开头(HDF5的user block)，版本号为0x0200
+	constexpr qint64 MAT_HEADER_SIZE = 128;
+	constexpr quint16 MAT_V73_VERSION = 0x0200;
+	constexpr quint64 MAX_TEXT_ELEMENTS = 1024 * 1024;
+
+	template<typename T>
+	inline T loadValue(const char* raw, bool swap)
+	{
+		T v;
+		std::memcpy(&v, raw, sizeof(T));
+		return swap ? qbswap(v) : v;
+	}
+
+	template<>
+	inline double loadValue<double>(const char* raw, bool swap)
+	{
+		quint64 bits = loadValue<quint64>(raw, swap);
+		double v;
+		std::memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	template<>
+	inline float loadValue<float>(const char* raw, bool swap)
+	{
+		quint32 bits = loadValue<quint32>(raw, swap);
+		float v;
+		std::memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	template<typename T>
+	void convertRun(const char* src, double* dst, qint64 count, bool swap)
+	{
+		for (qint64 i = 0; i < count; ++i) {
+			dst[i] = static_cast<double>(loadValue<T>(src + i * sizeof(T), swap));
+		}
+	}
+
+	// MATLAB_class属性值与mxClass的对应
+	int matlabClassId(const QByteArray& name)
+	{
+		static const QMap<QByteArray, int> classes = {
+			{ "double", RWMAT::mxDOUBLE_CLASS }, { "single", RWMAT::mxSINGLE_CLASS },
+			{ "int8", RWMAT::mxINT8_CLASS }, { "uint8", RWMAT::mxUINT8_CLASS },
+			{ "int16", RWMAT::mxINT16_CLASS }, { "uint16", RWMAT::mxUINT16_CLASS },
+			{ "int32", RWMAT::mxINT32_CLASS }, { "uint32", RWMAT::mxUINT32_CLASS },
+			{ "int64", RWMAT::mxINT64_CLASS }, { "uint64", RWMAT::mxUINT64_CLASS },
+			{ "char", RWMAT::mxCHAR_CLASS }, { "logical", RWMAT::mxUINT8_CLASS },
+			{ "cell", RWMAT::mxCELL_CLASS }, { "struct", RWMAT::mxSTRUCT_CLASS }
+		};
+		return classes.value(name, 0);
+	}
+
+	// HDF5的shuffle过滤器：各元素的第k个字节集中存放，解码时还原
+	void unshuffle(QByteArray& bytes, int elementSize)
+	{
+		const int count = bytes.size() / elementSize;
+		if (elementSize <= 1 || count <= 1) {
+			return;
+		}
+		QByteArray out(bytes.size(), Qt::Uninitialized);
+		const char* src = bytes.constData();
+		char* dst = out.data();
+		for (int b = 0; b < elementSize; ++b) {
+			const char* plane = src + qint64(b) * count;
+			for (int i = 0; i < count; ++i) {
+				dst[qint64(i) * elementSize + b] = plane[i];
+			}
+		}
+		// 不足一个元素的尾部字节原样保留
+		const int tail = bytes.size() - count * elementSize;
+		std::memcpy(dst + qint64(count) * elementSize, src + qint64(count) * elementSize, tail);
+		bytes.swap(out);
+	}
+
+	bool inflateChunk(const QByteArray& raw, int expectedSize, QByteArray& out)
+	{
+		out.resize(expectedSize);
+		uLongf destLen = uLongf(expectedSize);
+		const int ret = uncompress(reinterpret_cast<Bytef*>(out.data()), &destLen,
+			reinterpret_cast<const Bytef*>(raw.constData()), uLong(raw.size()));
+		return ret == Z_OK && destLen == uLongf(expectedSize);
+	}
+
+#ifdef SENSORVIZ_HAS_HDF5
+	// HDF5库通常不是线程安全编译，所有HDF5调用(即使是不同文件)都必须串行
+	QMutex& hdf5Mutex()
+	{
+		static QMutex mutex;
+		return mutex;
+	}
+
+	QByteArray readStringAttribute(hid_t obj, const char* name)
+	{
+		QByteArray value;
+		if (H5Aexists(obj, name) <= 0) {
+			return value;
+		}
+		hid_t attr = H5Aopen(obj, name, H5P_DEFAULT);
+		hid_t type = H5Aget_type(attr);
+		if (H5Tget_class(type) == H5T_STRING && !H5Tis_variable_str(type)) {
+			value.resize(int(H5Tget_size(type)));
+			if (H5Aread(attr, type, value.data()) < 0) {
+				value.clear();
+			}
+			value = value.left(int(qstrnlen(value.constData(), uint(value.size()))));
+		}
+		H5Tclose(type);
+		H5Aclose(attr);
+		return value;
+	}
+#endif
+}
+
+struct RWMAT::MatV73Reader::Layout
+{
+	qint64 dataset{ -1 };
+	int rank{ 0 };
+	bool chunked{ false };
+	quint64 chunkCols{ 1 };
+	quint64 chunkRows{ 1 };
+	int elementSize{ 0 };
+	bool isFloat{ false };
+	bool isSigned{ false };
+	bool swap{ false };
+	QVector<int> filters{};		//过滤器(写入时的应用顺序)
+	bool parallel{ false };		//分块存储且过滤器都能自行解码
+};
+
+struct RWMAT::MatV73Reader::ChunkTask
+{
+	quint64 colOffset{ 0 };
+	quint64 rowOffset{ 0 };
+};
+
+RWMAT::MatV73Reader::MatV73Reader(const QString& filepath)
+	: _filepath(filepath)
+{
+}
+
+RWMAT::MatV73Reader::~MatV73Reader()
+{
+	close();
+}
+
+bool RWMAT::MatV73Reader::isV73File(const QString& filepath)
+{
+	QFile file(filepath);
+	char header[MAT_HEADER_SIZE];
+	if (!file.open(QIODevice::ReadOnly) || file.read(header, MAT_HEADER_SIZE) != MAT_HEADER_SIZE) {
+		return false;
+	}
+	const bool fileLittleEndian = (header[126] == 'I' && header[127] == 'M');
+	const bool fileBigEndian = (header[126] == 'M' && header[127] == 'I');
+	if (!fileLittleEndian && !fileBigEndian) {
+		return false;
+	}
+	const quint16 version = fileLittleEndian ? qFromLittleEndian<quint16>(header + 124) : qFromBigEndian<quint16>(header + 124);
+	return version == MAT_V73_VERSION;
+}
+
+#ifdef SENSORVIZ_HAS_HDF5
+
+bool RWMAT::MatV73Reader::open()
+{
+	close();
+	QMutexLocker locker(&hdf5Mutex());
+	// 找不到对象等预期内的失败由返回值处理，不打印HDF5错误栈
+	H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);
+
+	const QByteArray path = QFile::encodeName(_filepath);
+	_file = H5Fopen(path.constData(), H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (_file < 0) {
+		qWarning() << "Failed to open MAT v7.3 file:" << _filepath;
+		return false;
+	}
+
+	// 1. 遍历根组下的全部链接，只保留数据集(struct/cell等为组或引用，只有#refs#里的数据，这里不解析)
+	H5G_info_t groupInfo;
+	if (H5Gget_info(hid_t(_file), &groupInfo) < 0) {
+		qWarning() << "Failed to list MAT v7.3 variables:" << _filepath;
+		locker.unlock();
+		close();
+		return false;
+	}
+	for (hsize_t i = 0; i < groupInfo.nlinks; ++i) {
+		const ssize_t nameSize = H5Lget_name_by_idx(hid_t(_file), ".", H5_INDEX_NAME, H5_ITER_INC, i, nullptr, 0, H5P_DEFAULT);
+		if (nameSize <= 0) {
+			continue;
+		}
+		QByteArray name(int(nameSize) + 1, '\0');
+		H5Lget_name_by_idx(hid_t(_file), ".", H5_INDEX_NAME, H5_ITER_INC, i, name.data(), size_t(name.size()), H5P_DEFAULT);
+		name.resize(int(nameSize));
+		if (name.startsWith('#')) {
+			continue;
+		}
+		hid_t obj = H5Oopen(hid_t(_file), name.constData(), H5P_DEFAULT);
+		if (obj < 0) {
+			continue;
+		}
+		if (H5Iget_type(obj) != H5I_DATASET) {
+			H5Oclose(obj);
+			continue;
+		}
+
+		// 2. 变量头：MATLAB类型、维度(与HDF5相反)
+		MatVariable var;
+		Layout* layout = new Layout;
+		layout->dataset = obj;
+		var.name = QString::fromUtf8(name);
+		var.mxClass = matlabClassId(readStringAttribute(obj, "MATLAB_class"));
+
+		hid_t space = H5Dget_space(obj);
+		layout->rank = H5Sget_simple_extent_ndims(space);
+		hsize_t dims[2] = { 0, 0 };
+		if (layout->rank == 1 || layout->rank == 2) {
+			H5Sget_simple_extent_dims(space, dims, nullptr);
+			var.cols = layout->rank == 2 ? dims[0] : 1;
+			var.rows = layout->rank == 2 ? dims[1] : dims[0];
+		}
+		H5Sclose(space);
+		// 空数组在文件里保存的是维度本身
+		if (H5Aexists(obj, "MATLAB_empty") > 0) {
+			var.rows = var.cols = 0;
+		}
+
+		// 3. 元素类型
+		hid_t type = H5Dget_type(obj);
+		const H5T_class_t typeClass = H5Tget_class(type);
+		layout->elementSize = int(H5Tget_size(type));
+		layout->isFloat = (typeClass == H5T_FLOAT);
+		layout->isSigned = (typeClass == H5T_INTEGER && H5Tget_sign(type) != H5T_SGN_NONE);
+		layout->swap = ((H5Tget_order(type) == H5T_ORDER_BE) != (Q_BYTE_ORDER == Q_BIG_ENDIAN));
+		var.complex = (typeClass == H5T_COMPOUND);
+		if (layout->isFloat) {
+			var.dataType = layout->elementSize == 8 ? miDOUBLE : miSINGLE;
+		}
+		else if (typeClass == H5T_INTEGER) {
+			switch (layout->elementSize)
+			{
+			case 1: var.dataType = layout->isSigned ? miINT8 : miUINT8; break;
+			case 2: var.dataType = layout->isSigned ? miINT16 : miUINT16; break;
+			case 4: var.dataType = layout->isSigned ? miINT32 : miUINT32; break;
+			case 8: var.dataType = layout->isSigned ? miINT64 : miUINT64; break;
+			default: break;
+			}
+		}
+		H5Tclose(type);
+
+		// 4. 存储布局与过滤器
+		hid_t dcpl = H5Dget_create_plist(obj);
+		layout->chunked = (H5Pget_layout(dcpl) == H5D_CHUNKED);
+		if (layout->chunked) {
+			hsize_t chunkDims[2] = { 1, 1 };
+			H5Pget_chunk(dcpl, layout->rank, chunkDims);
+			layout->chunkCols = layout->rank == 2 ? chunkDims[0] : 1;
+			layout->chunkRows = layout->rank == 2 ? chunkDims[1] : chunkDims[0];
+			bool supported = true;
+			const int filterCount = H5Pget_nfilters(dcpl);
+			for (int f = 0; f < filterCount; ++f) {
+				unsigned int flags = 0;
+				size_t cdCount = 0;
+				unsigned int filterConfig = 0;
+				const H5Z_filter_t filter = H5Pget_filter2(dcpl, unsigned(f), &flags, &cdCount, nullptr, 0, nullptr, &filterConfig);
+				layout->filters.append(int(filter));
+				supported = supported && (filter == H5Z_FILTER_DEFLATE || filter == H5Z_FILTER_SHUFFLE || filter == H5Z_FILTER_FLETCHER32);
+			}
+			var.compressed = layout->filters.contains(H5Z_FILTER_DEFLATE);
+			layout->parallel = supported && !var.complex && var.dataType != 0;
+		}
+		H5Pclose(dcpl);
+
+		var.dataBytes = var.rows * var.cols * quint64(layout->elementSize);
+		_variables.append(var);
+		_layouts.append(layout);
+	}
+	return true;
+}
+
+void RWMAT::MatV73Reader::close()
+{
+	QMutexLocker locker(&hdf5Mutex());
+	for (Layout* layout : _layouts) {
+		H5Dclose(hid_t(layout->dataset));
+		delete layout;
+	}
+	_layouts.clear();
+	_variables.clear();
+	if (_file >= 0) {
+		H5Fclose(hid_t(_file));
+		_file = -1;
+	}
+}
+
+bool RWMAT::MatV73Reader::readAll(const MatVariable& var, qint64 nativeType, void* dst)
+{
+	const Layout* lay = layout(var);
+	if (!lay) {
+		return false;
+	}
+	QMutexLocker locker(&hdf5Mutex());
+	return H5Dread(hid_t(lay->dataset), hid_t(nativeType), H5S_ALL, H5S_ALL, H5P_DEFAULT, dst) >= 0;
+}
+
+bool RWMAT::MatV73Reader::readText(const MatVariable& var, QString& text)
+{
+	const quint64 count = var.rows * var.cols;
+	if (var.mxClass != mxCHAR_CLASS || count == 0 || count > MAX_TEXT_ELEMENTS) {
+		return false;
+	}
+	// MATLAB的char为UTF-16码元
+	QVector<ushort> chars(static_cast<int>(count));
+	if (!readAll(var, H5T_NATIVE_USHORT, chars.data())) {
+		return false;
+	}
+	text = QString::fromUtf16(chars.constData(), int(count));
+	return true;
+}
+
+bool RWMAT::MatV73Reader::readHyperslab(const MatVariable& var, quint64 col, qint64 rowBegin, qint64 count, double* dst)
+{
+	const Layout* lay = layout(var);
+	if (!lay || count <= 0) {
+		return false;
+	}
+	QMutexLocker locker(&hdf5Mutex());
+	hid_t space = H5Dget_space(hid_t(lay->dataset));
+	hsize_t start[2] = { col, hsize_t(rowBegin) };
+	hsize_t counts[2] = { 1, hsize_t(count) };
+	if (lay->rank == 1) {
+		start[0] = hsize_t(rowBegin);
+		counts[0] = hsize_t(count);
+	}
+	hsize_t memCount = hsize_t(count);
+	hid_t memSpace = H5Screate_simple(1, &memCount, nullptr);
+	bool ok = H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, counts, nullptr) >= 0
+		&& H5Dread(hid_t(lay->dataset), H5T_NATIVE_DOUBLE, memSpace, space, H5P_DEFAULT, dst) >= 0;
+	H5Sclose(memSpace);
+	H5Sclose(space);
+	return ok;
+}
+
+bool RWMAT::MatV73Reader::decodeChunk(const Layout& layout, quint64 colOffset, quint64 rowOffset, QByteArray& chunk)
+{
+	const int expectedSize = int(layout.chunkCols * layout.chunkRows) * layout.elementSize;
+	QByteArray raw;
+	uint32_t filterMask = 0;
+
+	// 1. 读取分块的原始(过滤后)字节，HDF5调用串行
+	{
+		QMutexLocker locker(&hdf5Mutex());
+		hsize_t offset[2] = { colOffset, rowOffset };
+		if (layout.rank == 1) {
+			offset[0] = rowOffset;
+		}
+		hsize_t storageSize = 0;
+		if (H5Dget_chunk_storage_size(hid_t(layout.dataset), offset, &storageSize) < 0) {
+			return false;
+		}
+		// 未分配的分块为填充值(MATLAB写出的文件不会出现)
+		if (storageSize == 0) {
+			chunk.fill('\0', expectedSize);
+			return true;
+		}
+		raw.resize(int(storageSize));
+#if H5_VERSION_GE(2, 0, 0)
+		size_t bufSize = size_t(storageSize);
+		if (H5Dread_chunk2(hid_t(layout.dataset), H5P_DEFAULT, offset, &filterMask, raw.data(), &bufSize) < 0) {
+			return false;
+		}
+#else
+		if (H5Dread_chunk(hid_t(layout.dataset), H5P_DEFAULT, offset, &filterMask, raw.data()) < 0) {
+			return false;
+		}
+#endif
+	}
+
+	// 2. 逆序撤销过滤器(filterMask第i位为1表示该分块跳过了第i个过滤器)
+	for (int i = layout.filters.size() - 1; i >= 0; --i) {
+		if (filterMask & (1u << i)) {
+			continue;
+		}
+		switch (layout.filters[i])
+		{
+		case H5Z_FILTER_FLETCHER32:
+			raw.chop(4);
+			break;
+		case H5Z_FILTER_DEFLATE:
+		{
+			QByteArray inflated;
+			if (!inflateChunk(raw, expectedSize, inflated)) {
+				return false;
+			}
+			raw.swap(inflated);
+			break;
+		}
+		case H5Z_FILTER_SHUFFLE:
+			unshuffle(raw, layout.elementSize);
+			break;
+		default:
+			return false;
+		}
+	}
+	if (raw.size() != expectedSize) {
+		return false;
+	}
+	chunk.swap(raw);
+	return true;
+}
+
+#else
+
+bool RWMAT::MatV73Reader::open()
+{
+	qWarning() << "MAT v7.3 files need HDF5 support, which is not enabled in this build:" << _filepath;
+	return false;
+}
+
+void RWMAT::MatV73Reader::close()
+{
+	_variables.clear();
+	qDeleteAll(_layouts);
+	_layouts.clear();
+}
+
+bool RWMAT::MatV73Reader::readAll(const MatVariable&, qint64, void*)
+{
+	return false;
+}
+
+bool RWMAT::MatV73Reader::readText(const MatVariable&, QString&)
+{
+	return false;
+}
+
+bool RWMAT::MatV73Reader::readHyperslab(const MatVariable&, quint64, qint64, qint64, double*)
+{
+	return false;
+}
+
+bool RWMAT::MatV73Reader::decodeChunk(const Layout&, quint64, quint64, QByteArray&)
+{
+	return false;
+}
+
+#endif
+
+const RWMAT::MatVariable* RWMAT::MatV73Reader::variable(const QString& name) const
+{
+	for (const auto& var : _variables) {
+		if (var.name == name) {
+			return &var;
+		}
+	}
+	return nullptr;
+}
+
+const RWMAT::MatV73Reader::Layout* RWMAT::MatV73Reader::layout(const MatVariable& var) const
+{
+	const int index = int(&var - _variables.constData());
+	return (index >= 0 && index < _layouts.size()) ? _layouts[index] : nullptr;
+}
+
+bool RWMAT::MatV73Reader::readScalar(const MatVariable& var, double& value)
+{
+	if (var.mxClass < mxDOUBLE_CLASS || var.mxClass > mxUINT64_CLASS || var.rows == 0 || var.cols == 0) {
+		return false;
+	}
+	return readHyperslab(var, 0, 0, 1, &value);
+}
+
+bool RWMAT::MatV73Reader::readColumns(
+	const MatVariable& var,
+	qint64 rowBegin,
+	qint64 rowEnd,
+	const QVector<bool>& columnFilter,
+	const QVector<double*>& outputs
+)
+{
+	const Layout* lay = layout(var);
+	rowEnd = qMin(rowEnd, qint64(var.rows));
+	if (!lay || rowBegin < 0 || rowBegin >= rowEnd) {
+		return false;
+	}
+	auto selected = [&](quint64 col) {
+		return col < quint64(outputs.size()) && outputs[int(col)]
+			&& (columnFilter.isEmpty() || (col < quint64(columnFilter.size()) && columnFilter[int(col)]));
+	};
+
+	// 1. 不能自行解码时逐列走HDF5
+	if (!lay->parallel) {
+		for (quint64 col = 0; col < var.cols; ++col) {
+			if (selected(col) && !readHyperslab(var, col, rowBegin, rowEnd - rowBegin, outputs[int(col)])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 2. 只列出与所选列、行范围相交的分块
+	QVector<ChunkTask> tasks;
+	for (quint64 colOffset = 0; colOffset < var.cols; colOffset += lay->chunkCols) {
+		bool any = false;
+		for (quint64 col = colOffset; col < qMin(colOffset + lay->chunkCols, var.cols) && !any; ++col) {
+			any = selected(col);
+		}
+		if (!any) {
+			continue;
+		}
+		for (quint64 rowOffset = quint64(rowBegin) / lay->chunkRows * lay->chunkRows; rowOffset < quint64(rowEnd); rowOffset += lay->chunkRows) {
+			tasks.append({ colOffset, rowOffset });
+		}
+	}
+
+	// 3. 并行解压，各分块写入outputs中互不重叠的区域
+	std::atomic<bool> failed{ false };
+	QtConcurrent::blockingMap(tasks, [&](const ChunkTask& task) {
+		if (failed.load()) {
+			return;
+		}
+		QByteArray chunk;
+		if (!decodeChunk(*lay, task.colOffset, task.rowOffset, chunk)) {
+			failed.store(true);
+			return;
+		}
+		const qint64 first = qMax<qint64>(rowBegin, qint64(task.rowOffset));
+		const qint64 last = qMin<qint64>(rowEnd, qint64(task.rowOffset + lay->chunkRows));
+		for (quint64 col = task.colOffset; col < qMin(task.colOffset + lay->chunkCols, var.cols); ++col) {
+			if (!selected(col)) {
+				continue;
+			}
+			const char* src = chunk.constData() + ((col - task.colOffset) * lay->chunkRows + (first - task.rowOffset)) * lay->elementSize;
+			double* dst = outputs[int(col)] + (first - rowBegin);
+			switch (var.dataType)
+			{
+			case miDOUBLE: convertRun<double>(src, dst, last - first, lay->swap); break;
+			case miSINGLE: convertRun<float>(src, dst, last - first, lay->swap); break;
+			case miINT8: convertRun<qint8>(src, dst, last - first, lay->swap); break;
+			case miUINT8: convertRun<quint8>(src, dst, last - first, lay->swap); break;
+			case miINT16: convertRun<qint16>(src, dst, last - first, lay->swap); break;
+			case miUINT16: convertRun<quint16>(src, dst, last - first, lay->swap); break;
+			case miINT32: convertRun<qint32>(src, dst, last - first, lay->swap); break;
+			case miUINT32: convertRun<quint32>(src, dst, last - first, lay->swap); break;
+			case miINT64: convertRun<qint64>(src, dst, last - first, lay->swap); break;
+			case miUINT64: convertRun<quint64>(src, dst, last - first, lay->swap); break;
+			default: failed.store(true); return;
+			}
+		}
+		});
+	if (failed.load()) {
+		qWarning() << "Failed to decode MAT v7.3 variable" << var.name << "in" << _filepath;
+		return false;
+	}
+	return true;
+}
+
+bool RWMAT::MatV73Reader::readColumns(
+	const MatVariable& var,
+	qint64 rowBegin,
+	qint64 rowEnd,
+	const QVector<bool>& columnFilter,
+	int blockRows,
+	const MatV5Reader::BlockHandler& handler
+)
+{
+	const Layout* lay = layout(var);
+	rowEnd = qMin(rowEnd, qint64(var.rows));
+	if (!lay || rowBegin < 0 || rowBegin >= rowEnd || blockRows <= 0) {
+		return false;
+	}
+
+	// 1. 按分块列组处理：组内所选列共用每个解压后的分块，窗口结尾对齐到分块边界，保证每个分块只解压一次
+	const qint64 chunkRows = qint64(lay->chunkRows);
+	const quint64 groupCols = lay->parallel ? lay->chunkCols : 1;
+	std::vector<double> window;
+	QVector<double*> outputs(int(var.cols), nullptr);
+	QVector<int> groupColumns;
+	for (quint64 colOffset = 0; colOffset < var.cols; colOffset += groupCols) {
+		groupColumns.clear();
+		for (quint64 col = colOffset; col < qMin(colOffset + groupCols, var.cols); ++col) {
+			if (columnFilter.isEmpty() || (col < quint64(columnFilter.size()) && columnFilter[int(col)])) {
+				groupColumns.append(int(col));
+			}
+		}
+		if (groupColumns.isEmpty()) {
+			continue;
+		}
+
+		// 2. 逐窗口解码组内所选列，再按列号顺序回调
+		for (qint64 start = rowBegin; start < rowEnd;) {
+			qint64 end = start + blockRows;
+			if (lay->parallel) {
+				end = (end + chunkRows - 1) / chunkRows * chunkRows;
+			}
+			end = qMin(end, rowEnd);
+			const qint64 count = end - start;
+			window.resize(size_t(count * groupColumns.size()));
+			for (int k = 0; k < groupColumns.size(); ++k) {
+				outputs[groupColumns[k]] = window.data() + k * count;
+			}
+			if (!readColumns(var, start, end, QVector<bool>(), outputs)) {
+				return false;
+			}
+			for (int k = 0; k < groupColumns.size(); ++k) {
+				if (!handler(groupColumns[k], start, window.data() + k * count, int(count))) {
+					return false;
+				}
+			}
+			start = end;
+		}
+		for (int col : groupColumns) {
+			outputs[col] = nullptr;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "MatV5Reader.h"
+
+namespace RWMAT
+{
+	/**
+	 * @brief MAT v7.3(HDF5)文件读取器
+	 *
+	 * HDF5库只用于解析元数据以及按分块读取原始字节，分块的解压(deflate/shuffle/fletcher32)与类型转换
+	 * 在线程池中并行完成，且只读取与所选列、所选行范围相交的分块。
+	 * 分块使用了其他过滤器(如szip)或数据集不是分块存储时，退回HDF5按超平面串行读取。
+	 *
+	 * MATLAB按列主序保存矩阵，HDF5中的维度顺序与MATLAB相反：rows x cols的Datas在HDF5中为[cols][rows]，
+	 * 即每个传感器(列)在文件中是连续的，分块为[chunkCols][chunkRows]。
+	 */
+	class MatV73Reader
+	{
+	public:
+		explicit MatV73Reader(const QString& filepath);
+		~MatV73Reader();
+
+		MatV73Reader(const MatV73Reader&) = delete;
+		MatV73Reader& operator=(const MatV73Reader&) = delete;
+
+		// 文件头版本为0x0200(HDF5格式)
+		static bool isV73File(const QString& filepath);
+
+		// 打开文件并读取全部顶层数值/字符变量的头信息
+		bool open();
+		void close();
+
+		QString filePath() const { return _filepath; }
+		const QVector<MatVariable>& variables() const { return _variables; }
+		// 按变量名查找，找不到返回nullptr
+		const MatVariable* variable(const QString& name) const;
+
+		// 读取字符数组变量(如SampleFrequency)
+		bool readText(const MatVariable& var, QString& text);
+		// 读取数值变量的第一个元素
+		bool readScalar(const MatVariable& var, double& value);
+
+		/**
+		 * @brief 把所选列的[rowBegin, rowEnd)直接解码到outputs
+		 *
+		 * 每个相交分块只解压一次，分块之间并行；outputs[col]为nullptr的列不输出，
+		 * 非空时须能容纳rowEnd - rowBegin个元素。
+		 */
+		bool readColumns(
+			const MatVariable& var,
+			qint64 rowBegin,
+			qint64 rowEnd,
+			const QVector<bool>& columnFilter,
+			const QVector<double*>& outputs
+		);
+
+		/**
+		 * @brief 按分块列组顺序解码
+		 *
+		 * 同一分块列组([chunkCols]列)内的所选列按blockRows(向上取整到分块行数)为一个窗口一起解码，
+		 * 窗口内的分块并行解压且每个分块只解压一次，再按列号顺序逐列回调该窗口的数据。
+		 * 因此每列的数据块按行号递增下发，但组内各列的数据块交替下发(chunkCols为1时与MatV5Reader::readColumns一致)；
+		 * 内存占用为组内所选列数 x 窗口行数，与数据量无关。
+		 */
+		bool readColumns(
+			const MatVariable& var,
+			qint64 rowBegin,
+			qint64 rowEnd,
+			const QVector<bool>& columnFilter,
+			int blockRows,
+			const MatV5Reader::BlockHandler& handler
+		);
+
+	private:
+		struct Layout;
+		struct ChunkTask;
+
+		const Layout* layout(const MatVariable& var) const;
+		// 读取并解压一个分块，chunk为[chunkCols][chunkRows]的原始元素字节
+		bool decodeChunk(const Layout& layout, quint64 colOffset, quint64 rowOffset, QByteArray& chunk);
+		// 不支持并行解码时的退回路径：HDF5按超平面读取一列中的一段
+		bool readHyperslab(const MatVariable& var, quint64 col, qint64 rowBegin, qint64 count, double* dst);
+		bool readAll(const MatVariable& var, qint64 nativeType, void* dst);
+
+	private:
+		QString _filepath{};
+		qint64 _file{ -1 };
+		QVector<MatVariable> _variables{};
+		QVector<Layout*> _layouts{};	//与_variables一一对应
+	};
+};
@@ -1,14 +1,315 @@
 #include "ReadWriteMatFile.h"
 
-#include <cmath>
+#include <algorithm>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
-#include <QScopeGuard>
 #include <QDebug>
 
-#include <mat.h>
-#include <matrix.h>
+#include "MatV5Reader.h"
+#include "MatV73Reader.h"
+#include "MatBlockConsumers.h"
+#include "app/StatsKernel.h"
 
+namespace
+{
+	// 每次从文件解码的行数，控制中间缓冲区大小
+	constexpr int MAT_DECODE_BLOCK_ROWS = 64 * 1024;
+
+	// 超出[minValue, maxValue]的异常值置零
+	inline double clampValue(double value, double minValue, double maxValue)
+	{
+		return (value<minValue || value>maxValue) ? 0.0 : value;
+	}
+
+	// Datas在文件中的位置以及裁剪后的有效行范围
+	struct DatasLayout
+	{
+		const RWMAT::MatVariable* var{ nullptr };
+		int frequency{ 100 };
+		size_t valueRows{ 0 };
+		size_t removeSize{ 0 };		//前端裁剪行数
+		int redundancy{ 0 };		//末尾额外丢弃的行数
+		int dataCount{ 0 };			//裁剪后的行数
+	};
+
+	/**
+	 * @brief 查找Datas与SampleFrequency并计算裁剪范围，readMatFile与streamMatFile共用
+	 *
+	 * 固定前后各丢弃五秒数据frequency * 5，同时在末尾再移除不能被频率及分段频率整除的部分redundancy
+	 */
+	template<typename Reader>
+	bool locateDatas(Reader& reader, const QString& filepath, int sensorCount, DatasLayout& layout)
+	{
+		// 1. 文件打开与基础校验(只扫描变量头，不解码数据)
+		if (!reader.open()) {
+			qWarning() << "Failed to open MAT file:" << filepath;
+			return false;
+		}
+
+		// 2. 查找数据数组
+		layout.var = reader.variable("Datas");
+		if (!layout.var) {
+			qWarning() << "Variable 'Datas' not found in MAT file";
+			return false;
+		}
+
+		// 3. 读取采样频率（带默认值）
+		layout.frequency = 100; // 默认值
+		if (const RWMAT::MatVariable* freqVar = reader.variable("SampleFrequency")) {
+			bool ok = false;
+			QString freqStr;
+			double freqValue = 0.0;
+			if (reader.readText(*freqVar, freqStr)) {
+				layout.frequency = freqStr.toDouble(&ok);
+			}
+			else if (reader.readScalar(*freqVar, freqValue)) {
+				layout.frequency = freqValue;
+				ok = true;
+			}
+			if (!ok || layout.frequency <= 0) {
+				qWarning() << "Invalid SampleFrequency format, using default 100Hz";
+				layout.frequency = 100;
+			}
+		}
+
+		// 4. 数据维度校验
+		const size_t valueCols = layout.var->cols;
+		const size_t expectedCols = sensorCount;
+		if (valueCols != expectedCols) {
+			qWarning() << "Data columns mismatch. Expected:" << expectedCols
+				<< "Actual:" << valueCols;
+			return false;
+		}
+
+		// 5. 数据预处理(固定前后各丢弃五秒数据frequency * 5，同时在末尾再移除不能被频率及分段频率整除的部分redundancy)
+		layout.valueRows = layout.var->rows;
+		layout.redundancy = layout.valueRows % (layout.frequency * SEGMENT_COUNT);
+		layout.removeSize = std::min<size_t>(layout.frequency * 5, layout.valueRows / 2);
+		layout.dataCount = (int)layout.valueRows - ((int)layout.removeSize * 2) - layout.redundancy;
+		if (layout.dataCount <= 0) {
+			qWarning() << "Not enough samples in MAT file:" << filepath << "rows:" << layout.valueRows;
+			return false;
+		}
+		return true;
+	}
+}
+
+namespace
+{
+	/**
+	 * @brief 按列顺序分块解码到T(double或float)精度的数据块，越界置零与统计在同一遍完成
+	 *
+	 * 每个有效传感器单独一块内存，淘汰一列即释放该列；统计始终以double计算且基于置零后、降精度前的值，与存储精度无关
+	 */
+	template<typename T, typename Reader>
+	bool decodeDatas(
+		Reader& reader,
+		const DatasLayout& layout,
+		RawData& fp,
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		double minValue,
+		double maxValue
+	)
+	{
+		const int valueCols = int(layout.var->cols);
+		QVector<bool> columnFilter(valueCols, false);
+		QVector<T*> newdatas(valueCols, nullptr);
+		QVector<STATS::Moments> moments(valueCols);
+		QVector<int> validCols;
+		for (int i = 0; i < sensorNames.size(); ++i) {
+			if (i < sensorValid.size() && sensorValid[i] == "1") {
+				validCols.append(i);
+			}
+		}
+		const SampleType storage = std::is_same<T, float>::value ? SampleType::Float32 : SampleType::Float64;
+		QVector<std::shared_ptr<SampleBlock>> blocks(valueCols);
+		for (int i : validCols) {
+			columnFilter[i] = true;
+			blocks[i] = std::make_shared<SampleBlock>(1, fp.dataCount, storage);
+			newdatas[i] = blocks[i]->column<T>(0);
+		}
+
+		// 传感器数据处理：按列顺序解码，越界置零与统计在同一遍完成
+		const qint64 rowBegin = qint64(layout.removeSize);
+		const qint64 rowEnd = rowBegin + layout.dataCount;
+		bool decoded = reader.readColumns(*layout.var, rowBegin, rowEnd, columnFilter, MAT_DECODE_BLOCK_ROWS,
+			[&](int col, qint64 row, const double* values, int count) {
+				STATS::accumulate(values, count, minValue, maxValue, moments[col], newdatas[col] + (row - rowBegin));
+				return true;
+			});
+		if (!decoded) {
+			qWarning() << "Failed to decode 'Datas' in MAT file:" << filepath;
+			return false;
+		}
+
+		// 最终统计计算
+		for (int i : validCols) {
+			fp.statistics[sensorNames[i]] = moments[i].toStatistics();
+			fp.data.insert(sensorNames[i], newdatas[i], blocks[i]);
+			++fp.senseCount;
+		}
+		return fp.senseCount > 0;
+	}
+
+	/**
+	 * @brief v7.3(HDF5)文件的读取：分块并行解码到各列缓冲后，再做越界置零与统计
+	 *
+	 * v7.3不支持内存映射(数据均为压缩分块)，裁剪与统计规则与v5完全一致；
+	 * float存储时没有double缓冲可供并行解码直接写入，改为按列顺序解码并转换
+	 */
+	bool readMatFileV73(
+		RawData& fp,
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		double minValue,
+		double maxValue,
+		SampleType storage
+	)
+	{
+		// 1. 打开文件、读取采样频率并计算裁剪范围
+		RWMAT::MatV73Reader reader(filepath);
+		DatasLayout layout;
+		if (!locateDatas(reader, filepath, sensorNames.size(), layout)) {
+			return false;
+		}
+		fp.frequency = layout.frequency;
+		fp.dataCount = layout.dataCount;
+		fp.startTime = QDateTime::currentDateTime();
+		fp.senseCount = 0;
+		if (storage == SampleType::Float32) {
+			return decodeDatas<float>(reader, layout, fp, filepath, sensorNames, sensorValid, minValue, maxValue);
+		}
+
+		// 2. 每个有效传感器单独一块内存，并行解码直接写入
+		const int valueCols = int(layout.var->cols);
+		QVector<bool> columnFilter(valueCols, false);
+		QVector<int> validCols;
+		for (int i = 0; i < sensorNames.size(); ++i) {
+			if (i < sensorValid.size() && sensorValid[i] == "1") {
+				validCols.append(i);
+			}
+		}
+		QVector<std::shared_ptr<SampleBlock>> blocks(valueCols);
+		QVector<double*> outputs(valueCols, nullptr);
+		for (int i : validCols) {
+			columnFilter[i] = true;
+			blocks[i] = std::make_shared<SampleBlock>(1, fp.dataCount);
+			outputs[i] = blocks[i]->column<double>(0);
+		}
+		const qint64 rowBegin = qint64(layout.removeSize);
+		const qint64 rowEnd = rowBegin + layout.dataCount;
+		if (!reader.readColumns(*layout.var, rowBegin, rowEnd, columnFilter, outputs)) {
+			qWarning() << "Failed to decode 'Datas' in MAT file:" << filepath;
+			return false;
+		}
+
+		// 3. 越界置零与统计(原地)
+		for (int i : validCols) {
+			double* newdata = outputs[i];
+			STATS::Moments moments;
+			STATS::accumulate(newdata, fp.dataCount, minValue, maxValue, moments, newdata);
+			fp.statistics[sensorNames[i]] = moments.toStatistics();
+			fp.data.insert(sensorNames[i], newdata, blocks[i]);
+			++fp.senseCount;
+		}
+		return fp.senseCount > 0;
+	}
+
+	template<typename Reader>
+	bool readHeader(
+		Reader& reader,
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		RWMAT::StreamInfo& info
+	)
+	{
+		DatasLayout layout;
+		if (!locateDatas(reader, filepath, sensorNames.size(), layout)) {
+			return false;
+		}
+		info.frequency = layout.frequency;
+		info.dataCount = layout.dataCount;
+		info.sensorNames.clear();
+		for (int i = 0; i < sensorNames.size(); ++i) {
+			if (i < sensorValid.size() && sensorValid[i] == "1") {
+				info.sensorNames.append(sensorNames[i]);
+			}
+		}
+		return !info.sensorNames.isEmpty();
+	}
+
+	template<typename Reader>
+	bool streamDatas(
+		Reader& reader,
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		double minValue,
+		double maxValue,
+		const QVector<RWMAT::BlockConsumer*>& consumers,
+		RWMAT::StreamInfo& info,
+		int blockRows
+	)
+	{
+		// 1. 打开文件、读取采样频率并计算裁剪范围
+		DatasLayout layout;
+		if (!locateDatas(reader, filepath, sensorNames.size(), layout)) {
+			return false;
+		}
+
+		// 2. 只解码有效传感器，列号映射为下发给消费者的传感器下标
+		QVector<bool> columnFilter(int(layout.var->cols), false);
+		QVector<int> sensorIndex(int(layout.var->cols), -1);
+		info.frequency = layout.frequency;
+		info.dataCount = layout.dataCount;
+		info.sensorNames.clear();
+		for (int i = 0; i < sensorNames.size(); ++i) {
+			if (i >= sensorValid.size() || sensorValid[i] != "1") {
+				continue;
+			}
+			columnFilter[i] = true;
+			sensorIndex[i] = info.sensorNames.size();
+			info.sensorNames.append(sensorNames[i]);
+		}
+		if (info.sensorNames.isEmpty()) {
+			return false;
+		}
+		for (auto consumer : consumers) {
+			consumer->begin(info);
+		}
+
+		// 3. 按列顺序解码，越界置零后交给全部消费者
+		std::vector<double> block;
+		const qint64 rowBegin = qint64(layout.removeSize);
+		const qint64 rowEnd = qint64(layout.valueRows - layout.removeSize - layout.redundancy);
+		bool decoded = reader.readColumns(*layout.var, rowBegin, rowEnd, columnFilter, blockRows,
+			[&](int col, qint64 row, const double* values, int count) {
+				block.resize(count);
+				for (int k = 0; k < count; ++k) {
+					block[k] = clampValue(values[k], minValue, maxValue);
+				}
+				for (auto consumer : consumers) {
+					consumer->consume(sensorIndex[col], row - rowBegin, block.data(), count);
+				}
+				return true;
+			});
+		if (!decoded) {
+			qWarning() << "Failed to decode 'Datas' in MAT file:" << filepath;
+			return false;
+		}
+
+		for (auto consumer : consumers) {
+			consumer->finish();
+		}
+		return true;
+	}
+}
 
 bool RWMAT::readMatFile(
 	RawData& fp,
@@ -17,110 +318,106 @@ bool RWMAT::readMatFile(
 	const QStringList& sensorValid,
 	double minValue,
 	double maxValue,
-	ResType type
+	ResType type,
+	bool useMapping,
+	SampleType storage
 )
 {
-	// 1. 文件打开与基础校验
-	MATFile* pmat = matOpen(filepath.toUtf8().constData(), "r");
-	if (!pmat) {
-		qWarning() << "Failed to open MAT file:" << filepath;
-		return false;
+	// v7.3(HDF5)文件走分块并行解码
+	if (MatV73Reader::isV73File(filepath)) {
+		return readMatFileV73(fp, filepath, sensorNames, sensorValid, minValue, maxValue, storage);
 	}
 
-	// 使用智能指针管理MAT资源
-	auto matCloser = qScopeGuard([&]() { matClose(pmat); });
-
-	// 2. 读取数据数组
-	mxArray* datasArray = matGetVariable(pmat, "Datas");
-	if (!datasArray) {
-		qWarning() << "Variable 'Datas' not found in MAT file";
-		return false;
-	}
-	auto arrayDeleter = qScopeGuard([&]() { mxDestroyArray(datasArray); });
-
-	// 3. 读取采样频率（带默认值）
-	fp.frequency = 100; // 默认值
-	mxArray* sampleFrequencyArray = matGetVariable(pmat, "SampleFrequency");
-	if (sampleFrequencyArray) {
-		auto freqDeleter = qScopeGuard([&]() { mxDestroyArray(sampleFrequencyArray); });
-		if (char* freqStr = mxArrayToString(sampleFrequencyArray)) {
-			auto strDeleter = qScopeGuard([&]() { mxFree(freqStr); });
-			bool ok = false;
-			fp.frequency = QString(freqStr).toDouble(&ok);
-			if (!ok) {
-				qWarning() << "Invalid SampleFrequency format, using default 100Hz";
-				fp.frequency = 100;
-			}
-		}
-	}
-
-	// 4. 数据维度校验
-	const size_t valueCols = mxGetN(datasArray);
-	const size_t expectedCols = sensorNames.size();
-	if (valueCols != expectedCols) {
-		qWarning() << "Data columns mismatch. Expected:" << expectedCols
-			<< "Actual:" << valueCols;
+	// 1~5. 打开文件、读取采样频率并计算裁剪范围
+	MatV5Reader reader(filepath);
+	DatasLayout layout;
+	if (!locateDatas(reader, filepath, sensorNames.size(), layout)) {
 		return false;
 	}
-
-	// 5. 数据预处理(固定前后各丢弃五秒数据fp.frequency * 5，同时在末尾再移除不能被频率及分段频率整除的部分redundancy)
-	const size_t valueRows = mxGetM(datasArray);
-	int redundancy = valueRows % (fp.frequency * SEGMENT_COUNT);
-	const size_t removeSize = std::min<size_t>(fp.frequency * 5, valueRows / 2);
-	fp.dataCount = (int)valueRows - ((int)removeSize * 2) - redundancy;
+	const MatVariable* datasVar = layout.var;
+	const size_t valueRows = layout.valueRows;
+	const size_t removeSize = layout.removeSize;
+	fp.frequency = layout.frequency;
+	fp.dataCount = layout.dataCount;
 	fp.startTime = QDateTime::currentDateTime();
 	fp.senseCount = 0;
 
-	// 6. 数据指针获取
-	double* resValues = mxGetPr(datasArray);
-	if (!resValues) {
-		qWarning() << "Failed to get data pointer";
-		return false;
-	}
-
-	// 7. 传感器数据处理
-	for (int i = 0; i < sensorNames.size(); ++i) {
-		if (sensorValid[i] != "1") {
-			continue;
-		}
-
-		// 7.1 分配数据内存
-		std::unique_ptr<double[]> newdata(new double[fp.dataCount]);
-		Statistics stats;
-		bool statsInitialized = false;
-
-		// 7.2 处理每行数据
-		auto endSeq = valueRows - removeSize - redundancy;
-		for (size_t row = removeSize, newIdx = 0; row < endSeq; ++row, ++newIdx) {
-			// 计算向量幅值
-			double dataValue = 0.0;
-			dataValue = resValues[i * valueRows + row];
-			if (dataValue<minValue || dataValue>maxValue)
-			{
-				dataValue = 0.0;
+	// 6. 映射模式：每个传感器只映射裁剪后的区间，各列单独持有映射，只有需要越界置零的传感器才拷贝
+	//    映射区固定为double，float存储时不映射
+	if (useMapping && storage == SampleType::Float64 && reader.isMappable(*datasVar)) {
+		bool mapped = true;
+		for (int i = 0; i < sensorNames.size(); ++i) {
+			if (i >= sensorValid.size() || sensorValid[i] != "1") {
+				continue;
 			}
-			// 存储数据
-			newdata[newIdx] = dataValue;
-
-			// 更新统计信息
-			if (!statsInitialized) {
-				stats = { dataValue, dataValue, dataValue * dataValue };
-				statsInitialized = true;
+			auto mapping = reader.mapRealPart(*datasVar, quint64(i) * valueRows + removeSize, quint64(fp.dataCount));
+			if (!mapping) {
+				mapped = false;
+				break;
+			}
+			const double* column = mapping->data();
+			STATS::Moments moments;
+			const qint64 clamped = STATS::accumulate(column, fp.dataCount, minValue, maxValue, moments);
+			fp.statistics[sensorNames[i]] = moments.toStatistics();
+			// 存在越界值时才拷贝一份置零后的数据
+			if (clamped > 0) {
+				auto copy = std::make_shared<SampleBlock>(1, fp.dataCount);
+				STATS::Moments unused;
+				STATS::accumulate(column, fp.dataCount, minValue, maxValue, unused, copy->column<double>(0));
+				fp.data.insert(sensorNames[i], copy->view(0), copy);
 			}
 			else {
-				stats.max = std::max(stats.max, dataValue);
-				stats.min = std::min(stats.min, dataValue);
-				stats.rms += dataValue * dataValue;
+				fp.data.insert(sensorNames[i], column, mapping);
 			}
-		}
-
-		// 7.3 最终统计计算
-		if (statsInitialized) {
-			stats.rms = std::sqrt(stats.rms / fp.dataCount);
-			fp.statistics[sensorNames[i]] = stats;
-			fp.data[sensorNames[i]] = newdata.release();
 			++fp.senseCount;
 		}
+		if (mapped) {
+			return fp.senseCount > 0;
+		}
+		fp.statistics.clear();
+		fp.data.clear();
+		fp.senseCount = 0;
+		qDebug() << "MAT data can not be mapped, fallback to copy:" << filepath;
+	}
+
+	// 7~9. 每个有效传感器单独一块内存，按存储精度解码、越界置零并统计
+	if (storage == SampleType::Float32) {
+		return decodeDatas<float>(reader, layout, fp, filepath, sensorNames, sensorValid, minValue, maxValue);
+	}
+	return decodeDatas<double>(reader, layout, fp, filepath, sensorNames, sensorValid, minValue, maxValue);
+}
+
+bool RWMAT::readMatHeader(
+	const QString& filepath,
+	const QStringList& sensorNames,
+	const QStringList& sensorValid,
+	StreamInfo& info
+)
+{
+	if (MatV73Reader::isV73File(filepath)) {
+		MatV73Reader reader(filepath);
+		return readHeader(reader, filepath, sensorNames, sensorValid, info);
+	}
+	MatV5Reader reader(filepath);
+	return readHeader(reader, filepath, sensorNames, sensorValid, info);
+}
+
+bool RWMAT::streamMatFile(
+	const QString& filepath,
+	const QStringList& sensorNames,
+	const QStringList& sensorValid,
+	double minValue,
+	double maxValue,
+	const QVector<BlockConsumer*>& consumers,
+	StreamInfo& info,
+	int blockRows
+)
+{
+	// v7.3(HDF5)文件与v5文件的下发方式一致，只是解码器不同
+	if (MatV73Reader::isV73File(filepath)) {
+		MatV73Reader reader(filepath);
+		return streamDatas(reader, filepath, sensorNames, sensorValid, minValue, maxValue, consumers, info, blockRows);
 	}
-	return fp.senseCount > 0;
-}
\ No newline at end of file
+	MatV5Reader reader(filepath);
+	return streamDatas(reader, filepath, sensorNames, sensorValid, minValue, maxValue, consumers, info, blockRows);
+}
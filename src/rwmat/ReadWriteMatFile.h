@@ -4,7 +4,13 @@
 
 namespace RWMAT
 {
+	struct StreamInfo;
+	class BlockConsumer;
+
 	//ExtraData
+	//useMapping为true且Datas为未压缩double存储时，fp.data直接指向文件映射区(前后5秒的裁剪只是指针偏移)，
+	//只有存在越界值需要置零的传感器才会拷贝一份；不满足映射条件时自动退回拷贝读取
+	//storage为Float32时数据以float存储(统计仍按double计算)，此时不使用映射
 	bool readMatFile(
 		RawData& fp,
 		const QString& filepath,
@@ -12,7 +18,43 @@ namespace RWMAT
 		const QStringList& sensorValid,
 		double minValue,
 		double maxValue,
-		ResType type
+		ResType type,
+		bool useMapping = false,
+		SampleType storage = SampleType::Float64
+	);
+
+	/**
+	 * @brief 只读取MAT文件头部信息，不解码Datas
+	 *
+	 * 只扫描变量头并读取SampleFrequency，裁剪规则与readMatFile一致，用于在加载数据前建立数据包索引
+	 *
+	 * @param info [out] 采样频率、裁剪后的数据点数与有效传感器列表
+	 */
+	bool readMatHeader(
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		StreamInfo& info
+	);
+
+	/**
+	 * @brief 流式读取MAT文件的Datas，不保留原始数据
+	 *
+	 * 裁剪规则、越界置零规则与readMatFile完全一致，数据按blockRows分块解码后依次交给consumers(见MatBlockConsumers.h)，
+	 * 整个过程只顺序读一遍文件，内存占用只有一个解码块加上各消费者自身的状态。
+	 *
+	 * @param info [out] 采样频率、数据点数与下发的传感器列表
+	 * @return bool 是否完整读取
+	 */
+	bool streamMatFile(
+		const QString& filepath,
+		const QStringList& sensorNames,
+		const QStringList& sensorValid,
+		double minValue,
+		double maxValue,
+		const QVector<BlockConsumer*>& consumers,
+		StreamInfo& info,
+		int blockRows = 64 * 1024
 	);
 };
 
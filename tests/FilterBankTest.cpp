@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "app/StatsKernel.h"
+#include "charts/FilterBank.h"
+
+/**
+ * 二阶节滤波器组单元测试
+ *
+ * 1. designFilter的巴特沃斯低通、高通、带通幅频响应与解析式|H|²比较；
+ * 2. FilterBank::filter/filtfilt的多通道结果与测试中逐通道的参考实现(转置直接II型，sosfiltfilt的奇延拓与稳态初始状态)比较；
+ * 3. 各指令集、单通道、原位滤波的结果与多通道结果逐点相同。
+ */
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	int failures = 0;
+
+	void check(bool condition, const char* what, const char* config)
+	{
+		if (!condition) {
+			++failures;
+			std::printf("FAILED %s [%s]\n", what, config);
+		}
+	}
+
+	// 级联二阶节在频率f处的|H|²
+	double magnitude2(const QVector<PSDA::Biquad>& sections, double f, double fs)
+	{
+		const std::complex<double> z1 = std::polar(1.0, -2.0 * PI * f / fs);
+		const std::complex<double> z2 = z1 * z1;
+		std::complex<double> h = 1.0;
+		for (const PSDA::Biquad& q : sections) {
+			h *= (q.b0 + q.b1 * z1 + q.b2 * z2) / (1.0 + q.a1 * z1 + q.a2 * z2);
+		}
+		return std::norm(h);
+	}
+
+	// 逐节、逐点滤波，z为各节的(z1, z2)
+	void sosfilt(const QVector<PSDA::Biquad>& sections, std::vector<double>& x, std::vector<double> z, bool reverse)
+	{
+		const size_t n = x.size();
+		for (size_t k = 0; k < n; ++k) {
+			double& v = x[reverse ? n - 1 - k : k];
+			for (int s = 0; s < sections.count(); ++s) {
+				const PSDA::Biquad& q = sections[s];
+				double& z1 = z[size_t(2 * s)];
+				double& z2 = z[size_t(2 * s + 1)];
+				const double y = q.b0 * v + z1;
+				z1 = q.b1 * v - q.a1 * y + z2;
+				z2 = q.b2 * v - q.a2 * y;
+				v = y;
+			}
+		}
+	}
+
+	// 输入恒为value时各节的稳态状态
+	std::vector<double> steadyState(const QVector<PSDA::Biquad>& sections, double value)
+	{
+		std::vector<double> z;
+		for (const PSDA::Biquad& q : sections) {
+			const double gain = (q.b0 + q.b1 + q.b2) / (1.0 + q.a1 + q.a2);
+			const double z2 = (q.b2 - q.a2 * gain) * value;
+			const double z1 = (q.b1 - q.a1 * gain) * value + z2;
+			z.push_back(z1);
+			z.push_back(z2);
+			value *= gain;
+		}
+		return z;
+	}
+
+	// scipy.signal.sosfiltfilt(sos, x, padtype='odd')
+	std::vector<double> sosfiltfilt(const QVector<PSDA::Biquad>& sections, const std::vector<double>& x)
+	{
+		const int n = int(x.size());
+		int taps = 2 * sections.count() + 1;
+		for (const PSDA::Biquad& q : sections) {
+			taps -= (q.b2 == 0.0 && q.a2 == 0.0) ? 1 : 0;
+		}
+		const int pad = std::min(3 * taps, n - 1);
+
+		std::vector<double> ext;
+		for (int i = pad; i >= 1; --i) {
+			ext.push_back(2.0 * x.front() - x[size_t(i)]);
+		}
+		ext.insert(ext.end(), x.begin(), x.end());
+		for (int i = n - 2; i >= n - 1 - pad; --i) {
+			ext.push_back(2.0 * x.back() - x[size_t(i)]);
+		}
+
+		sosfilt(sections, ext, steadyState(sections, ext.front()), false);
+		sosfilt(sections, ext, steadyState(sections, ext.back()), true);
+		return std::vector<double>(ext.begin() + pad, ext.begin() + pad + n);
+	}
+
+	double maxAbs(const std::vector<double>& x)
+	{
+		double m = 0.0;
+		for (double v : x) {
+			m = std::max(m, std::fabs(v));
+		}
+		return m;
+	}
+
+	bool near(const std::vector<double>& a, const std::vector<double>& b, double tolerance)
+	{
+		if (a.size() != b.size()) {
+			return false;
+		}
+		const double limit = tolerance * std::max(1.0, maxAbs(b));
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (!(std::fabs(a[i] - b[i]) <= limit)) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	const double fs = 1000.0;
+
+	// 1. 巴特沃斯幅频响应：|H|² = 1/(1+Ω^2N)，Ω为预畸变后的原型频率
+	for (PSDA::FilterBand band : { PSDA::FilterBand::LowPass, PSDA::FilterBand::HighPass, PSDA::FilterBand::BandPass }) {
+		for (int order = 1; order <= 8; ++order) {
+			PSDA::FilterDesign design;
+			design.band = band;
+			design.order = order;
+			design.low = 40.0;
+			design.high = 150.0;
+			QVector<PSDA::Biquad> sections;
+			if (!PSDA::designFilter(design, fs, sections)) {
+				check(false, "design", "butterworth");
+				continue;
+			}
+			auto prewarp = [fs](double f) { return std::tan(PI * f / fs); };
+			double worst = 0.0;
+			for (double f = 1.0; f < fs / 2.0 - 1.0; f += 3.7) {
+				double omega = 0.0;
+				switch (band)
+				{
+				case PSDA::FilterBand::LowPass: omega = prewarp(f) / prewarp(design.low); break;
+				case PSDA::FilterBand::HighPass: omega = prewarp(design.low) / prewarp(f); break;
+				case PSDA::FilterBand::BandPass:
+				{
+					const double w = prewarp(f), w1 = prewarp(design.low), w2 = prewarp(design.high);
+					omega = (w * w - w1 * w2) / (w * (w2 - w1));
+					break;
+				}
+				}
+				const double expected = 1.0 / (1.0 + std::pow(omega * omega, order));
+				worst = std::max(worst, std::fabs(magnitude2(sections, f, fs) - expected));
+			}
+			check(worst < 1e-9, "butterworth |H|^2", band == PSDA::FilterBand::LowPass ? "lowpass" : band == PSDA::FilterBand::HighPass ? "highpass" : "bandpass");
+		}
+	}
+
+	// 2. 多通道(不是LANES的整数倍)与逐通道参考实现
+	std::mt19937 engine(1);
+	std::normal_distribution<double> normal(0.0, 1.0);
+	const int channelCount = 13, n = 3000;
+	std::vector<std::vector<double>> x(channelCount, std::vector<double>(n));
+	for (std::vector<double>& channel : x) {
+		for (int i = 0; i < n; ++i) {
+			channel[size_t(i)] = normal(engine) + 3.0 * std::sin(i * 0.01) + 5.0;
+		}
+	}
+
+	struct Case { const char* name; PSDA::FilterFamily family; PSDA::FilterBand band; int order; };
+	const Case cases[] = {
+		{ "butterworth highpass 5", PSDA::FilterFamily::Butterworth, PSDA::FilterBand::HighPass, 5 },
+		{ "chebyshev1 bandpass 3", PSDA::FilterFamily::Chebyshev1, PSDA::FilterBand::BandPass, 3 },
+		{ "bessel lowpass 4", PSDA::FilterFamily::Bessel, PSDA::FilterBand::LowPass, 4 },
+	};
+	for (const Case& c : cases) {
+		PSDA::FilterDesign design;
+		design.family = c.family;
+		design.band = c.band;
+		design.order = c.order;
+		design.low = c.band == PSDA::FilterBand::BandPass ? 20.0 : 60.0;
+		design.high = 120.0;
+		design.rippleDb = 0.5;
+		PSDA::FilterBank bank;
+		if (!bank.design(design, fs)) {
+			check(false, "design", c.name);
+			continue;
+		}
+
+		std::vector<std::vector<double>> zeroPhase(channelCount, std::vector<double>(n)), causal = zeroPhase;
+		QVector<const double*> inputs;
+		QVector<double*> outputs, causalOutputs;
+		for (int ch = 0; ch < channelCount; ++ch) {
+			inputs.append(x[size_t(ch)].data());
+			outputs.append(zeroPhase[size_t(ch)].data());
+			causalOutputs.append(causal[size_t(ch)].data());
+		}
+		bank.filtfilt(inputs, outputs, n);
+		bank.filter(inputs, causalOutputs, n);
+
+		for (int ch = 0; ch < channelCount; ++ch) {
+			check(near(zeroPhase[size_t(ch)], sosfiltfilt(bank.sections(), x[size_t(ch)]), 1e-10), "filtfilt vs reference", c.name);
+			std::vector<double> expected = x[size_t(ch)];
+			sosfilt(bank.sections(), expected, std::vector<double>(size_t(2 * bank.sections().count()), 0.0), false);
+			check(near(causal[size_t(ch)], expected, 1e-10), "filter vs reference", c.name);
+		}
+
+		// 3. 各指令集原位滤波、单通道滤波与上面的结果逐点相同
+		for (STATS::Isa isa : { STATS::Isa::Scalar, STATS::Isa::SSE2, STATS::Isa::AVX2 }) {
+			STATS::setIsa(isa);
+			std::vector<std::vector<double>> inPlace = x;
+			QVector<const double*> sources;
+			QVector<double*> targets;
+			for (std::vector<double>& channel : inPlace) {
+				sources.append(channel.data());
+				targets.append(channel.data());
+			}
+			bank.filtfilt(sources, targets, n);
+			check(inPlace == zeroPhase, "isa / in-place equality", c.name);
+
+			// 不足一组的通道数(按向量宽度补空路)
+			for (int lanes : { 2, 3, 5 }) {
+				std::vector<std::vector<double>> partial(static_cast<size_t>(lanes), std::vector<double>(static_cast<size_t>(n)));
+				QVector<const double*> partialInputs;
+				QVector<double*> partialOutputs;
+				for (int ch = 0; ch < lanes; ++ch) {
+					partialInputs.append(x[size_t(ch)].data());
+					partialOutputs.append(partial[size_t(ch)].data());
+				}
+				bank.filtfilt(partialInputs, partialOutputs, n);
+				check(std::equal(partial.begin(), partial.end(), zeroPhase.begin()), "partial group equality", c.name);
+			}
+		}
+		std::vector<double> single(static_cast<size_t>(n));
+		bank.filtfilt({ x[7].data() }, { single.data() }, n);
+		check(single == zeroPhase[7], "single channel equality", c.name);
+
+		// 数据短于补点长度
+		std::vector<double> shortInput(x[0].begin(), x[0].begin() + 10), shortOutput(shortInput.size());
+		bank.filtfilt({ shortInput.data() }, { shortOutput.data() }, int(shortInput.size()));
+		check(near(shortOutput, sosfiltfilt(bank.sections(), shortInput), 1e-10), "short filtfilt vs reference", c.name);
+	}
+
+	std::printf("%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+
+#include "charts/SpectralPeaks.h"
+
+/**
+ * 功率谱峰值查找单元测试
+ *
+ * 1. 频率落在两个频点之间的正弦信号(汉宁窗直接DFT)，插值后的峰值频率误差在频点间隔的一小部分以内；
+ * 2. 平坦的峰顶取平台中点，不做插值；
+ * 3. 突出度与峰宽低于条件的峰被剔除，minFrequency以下的峰不输出；
+ * 4. 结果按功率从大到小排列，maxPeaks截取前若干个，<=0时不限制。
+ */
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	int failures = 0;
+
+	void check(bool condition, const char* what, const char* config)
+	{
+		if (!condition) {
+			++failures;
+			std::printf("FAILED %s [%s]\n", what, config);
+		}
+	}
+
+	struct Bump { double center; double height; double sigma; };
+
+	// 等间隔频率轴上的基线加若干高斯形峰(sigma以频点为单位)
+	void makeSpectrum(int count, double df, double base, std::initializer_list<Bump> bumps, QVector<double>& freqs, QVector<double>& pxx)
+	{
+		freqs.resize(count);
+		pxx.fill(base, count);
+		for (int i = 0; i < count; ++i) {
+			freqs[i] = i * df;
+			for (const Bump& bump : bumps) {
+				const double r = (i - bump.center) / bump.sigma;
+				pxx[i] += bump.height * std::exp(-0.5 * r * r);
+			}
+		}
+	}
+}
+
+int main()
+{
+	// 1. 频点之间的正弦信号
+	const int nfft = 1024;
+	const double fs = 1000.0, df = fs / nfft;
+	for (double offset : { 0.0, 0.1, 0.25, 0.4, -0.3 }) {
+		const double f0 = (100.0 + offset) * df;
+		QVector<double> freqs(nfft / 2 + 1), pxx(nfft / 2 + 1);
+		for (int k = 0; k <= nfft / 2; ++k) {
+			double re = 0.0, im = 0.0;
+			for (int i = 0; i < nfft; ++i) {
+				const double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / (nfft - 1));
+				const double v = w * std::sin(2.0 * PI * f0 * i / fs);
+				re += v * std::cos(2.0 * PI * k * i / nfft);
+				im -= v * std::sin(2.0 * PI * k * i / nfft);
+			}
+			freqs[k] = k * df;
+			pxx[k] = re * re + im * im;
+		}
+		QVector<PSDA::SpectralPeak> peaks;
+		PSDA::findPeaks(freqs, pxx, PSDA::PeakCriteria(), peaks);
+		check(peaks.count() == 1, "single sinusoid peak", "sinusoid");
+		if (!peaks.isEmpty()) {
+			const double error = std::fabs(peaks[0].frequency - f0) / df;
+			// 汉宁窗功率谱的抛物线插值偏差最大约0.12个频点，但总比最近的频点更准
+			check(error < 0.15 && error <= std::fabs(freqs[peaks[0].index] - f0) / df + 1e-6, "interpolated frequency", "sinusoid");
+			check(peaks[0].power >= pxx[peaks[0].index], "interpolated power", "sinusoid");
+		}
+	}
+
+	// 2. 平坦的峰顶
+	for (int plateau : { 1, 4, 5 }) {
+		QVector<double> freqs, pxx;
+		// 以平台为中心的三角形基底，平台两侧单调
+		makeSpectrum(200, 0.5, 0.1, {}, freqs, pxx);
+		for (int i = 0; i < 200; ++i) {
+			pxx[i] += std::max(0.0, 1.0 - std::fabs(i - 90.0 - (plateau - 1) / 2.0) / 20.0);
+		}
+		for (int i = 90; i < 90 + plateau; ++i) {
+			pxx[i] = 2.0;
+		}
+		QVector<PSDA::SpectralPeak> peaks;
+		PSDA::findPeaks(freqs, pxx, PSDA::PeakCriteria(), peaks);
+		const int middle = 90 + (plateau - 1) / 2;
+		check(peaks.count() == 1 && peaks[0].index == middle && peaks[0].frequency == freqs[middle] && peaks[0].power == 2.0,
+			"plateau midpoint", plateau == 1 ? "plateau 1" : "plateau 4/5");
+	}
+
+	// 3. 突出度、峰宽与最低频率
+	{
+		QVector<double> freqs, pxx;
+		// 主峰，突出度为最大值3%的小峰，单频点的窄峰，低频的峰
+		makeSpectrum(400, 0.25, 1.0, { { 200.0, 100.0, 8.0 }, { 300.0, 3.1, 6.0 }, { 350.0, 20.0, 0.3 }, { 20.0, 50.0, 5.0 } }, freqs, pxx);
+		const double maxValue = pxx[200];
+		QVector<PSDA::SpectralPeak> peaks;
+		PSDA::PeakCriteria criteria;
+		criteria.maxPeaks = 0;
+		PSDA::findPeaks(freqs, pxx, criteria, peaks);
+		bool found = peaks.count() == 3;
+		for (const PSDA::SpectralPeak& peak : peaks) {
+			found = found && peak.index != 300 && peak.prominence >= criteria.minProminence * maxValue;
+		}
+		check(found, "min prominence", "default");
+
+		criteria.minProminence = 0.01;
+		PSDA::findPeaks(freqs, pxx, criteria, peaks);
+		check(peaks.count() == 4, "lower min prominence", "0.01");
+		for (const PSDA::SpectralPeak& peak : peaks) {
+			// 高斯峰半突出度处的宽度约为2.355σ
+			if (peak.index == 200) {
+				check(std::fabs(peak.width - 2.355 * 8.0 * 0.25) < 0.1, "half prominence width", "gaussian");
+			}
+		}
+
+		criteria.minWidth = 1.0;
+		PSDA::findPeaks(freqs, pxx, criteria, peaks);
+		bool wide = peaks.count() == 3;
+		for (const PSDA::SpectralPeak& peak : peaks) {
+			wide = wide && peak.index != 350 && peak.width >= criteria.minWidth;
+		}
+		check(wide, "min width", "1 Hz");
+
+		criteria.minFrequency = 10.0;
+		PSDA::findPeaks(freqs, pxx, criteria, peaks);
+		bool high = peaks.count() == 2;
+		for (const PSDA::SpectralPeak& peak : peaks) {
+			high = high && peak.frequency >= criteria.minFrequency;
+		}
+		check(high, "min frequency", "10 Hz");
+	}
+
+	// 4. 排序与个数限制
+	{
+		QVector<double> freqs, pxx;
+		makeSpectrum(500, 1.0, 0.0, { { 50.0, 3.0, 4.0 }, { 150.0, 9.0, 4.0 }, { 250.0, 1.0, 4.0 }, { 350.0, 7.0, 4.0 }, { 450.0, 5.0, 4.0 } },
+			freqs, pxx);
+		QVector<PSDA::SpectralPeak> peaks;
+		PSDA::PeakCriteria criteria;
+		criteria.maxPeaks = 0;
+		check(PSDA::findPeaks(freqs, pxx, criteria, peaks) == 5, "all peaks", "maxPeaks=0");
+		const int order[] = { 150, 350, 450, 50, 250 };
+		bool sorted = peaks.count() == 5;
+		for (int i = 0; sorted && i < 5; ++i) {
+			sorted = peaks[i].index == order[i] && (i == 0 || peaks[i - 1].power > peaks[i].power);
+		}
+		check(sorted, "ordered by power", "maxPeaks=0");
+
+		criteria.maxPeaks = 2;
+		PSDA::findPeaks(freqs, pxx, criteria, peaks);
+		check(peaks.count() == 2 && peaks[0].index == 150 && peaks[1].index == 350, "max peaks", "maxPeaks=2");
+	}
+
+	// 数据不足与全为0的谱线
+	{
+		QVector<double> freqs{ 0.0, 1.0 }, pxx{ 0.0, 1.0 };
+		QVector<PSDA::SpectralPeak> peaks;
+		check(PSDA::findPeaks(freqs, pxx, PSDA::PeakCriteria(), peaks) == 0 && peaks.isEmpty(), "too few bins", "2 bins");
+		makeSpectrum(64, 1.0, 0.0, {}, freqs, pxx);
+		check(PSDA::findPeaks(freqs, pxx, PSDA::PeakCriteria(), peaks) == 0, "zero spectrum", "zeros");
+	}
+
+	std::printf("%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "app/StatsIndex.h"
+
+/**
+ * 区间统计索引单元测试
+ *
+ * 任意区间的索引结果与直接扫描(STATS::accumulate)比较，最值须完全一致，均值与中心矩按相对误差比较；
+ * toBytes/fromBytes恢复的索引(缓存文件中的格式)与原索引的查询结果须完全一致。
+ */
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, const char* what, qint64 begin, qint64 end)
+	{
+		if (!condition) {
+			++failures;
+			std::printf("FAILED %s [%lld, %lld)\n", what, static_cast<long long>(begin), static_cast<long long>(end));
+		}
+	}
+
+	bool close(double value, double expected, double scale, double tolerance)
+	{
+		return std::fabs(value - expected) <= tolerance * std::max(1.0, scale);
+	}
+
+	bool same(const STATS::Moments& a, const STATS::Moments& b)
+	{
+		return a.count == b.count && a.min == b.min && a.max == b.max && a.mean == b.mean
+			&& a.m2 == b.m2 && a.m3 == b.m3 && a.m4 == b.m4;
+	}
+
+	template<typename T>
+	void testColumn(const std::vector<T>& values, std::mt19937_64& engine)
+	{
+		const qint64 count = qint64(values.size());
+		const SampleColumn column(values.data());
+		const StatsIndex index(column, count);
+
+		// 序列化后恢复
+		const QByteArray bytes = index.toBytes();
+		check(bytes.size() == StatsIndex::serializedBytes(count), "serialized size", 0, count);
+		const auto restored = StatsIndex::fromBytes(reinterpret_cast<const uchar*>(bytes.constData()), count);
+		check(restored && restored->bytes() == index.bytes(), "fromBytes", 0, count);
+
+		std::uniform_int_distribution<qint64> position(0, count);
+		for (int i = 0; i < 500; ++i) {
+			qint64 begin = position(engine), end = position(engine);
+			if (begin > end) {
+				std::swap(begin, end);
+			}
+			STATS::Moments scanned;
+			if (begin < end) {
+				STATS::accumulate(values.data() + begin, end - begin, scanned);
+			}
+			const STATS::Moments indexed = index.window(column, begin, end);
+			const double scale = std::fabs(scanned.m2);
+			check(indexed.count == scanned.count, "count", begin, end);
+			check(indexed.min == scanned.min && indexed.max == scanned.max, "min/max", begin, end);
+			check(close(indexed.mean, scanned.mean, std::fabs(scanned.mean), 1e-12), "mean", begin, end);
+			check(close(indexed.m2, scanned.m2, scale, 1e-10), "m2", begin, end);
+			check(close(indexed.m3, scanned.m3, scale * std::sqrt(scale), 1e-10), "m3", begin, end);
+			check(close(indexed.m4, scanned.m4, scale * scale, 1e-10), "m4", begin, end);
+			if (restored) {
+				check(same(restored->window(column, begin, end), indexed), "restored window", begin, end);
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937_64 engine(42);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	const qint64 sizes[] = { 0, 1, 1000, StatsIndex::BLOCK_SIZE, 3 * StatsIndex::BLOCK_SIZE + 17, 300000 };
+	for (const qint64 count : sizes) {
+		// 带较大直流分量与漂移，检验参考点平移与补偿求和
+		std::vector<double> values(static_cast<size_t>(count));
+		for (qint64 i = 0; i < count; ++i) {
+			values[size_t(i)] = 1000.0 + 1e-4 * double(i) + 5.0 * noise(engine);
+		}
+		testColumn(values, engine);
+		testColumn(std::vector<float>(values.begin(), values.end()), engine);
+	}
+
+	// 缓存内容不合法时不恢复
+	std::vector<double> invalid(size_t(StatsIndex::serializedBytes(5000) / sizeof(double)), 1.0);
+	check(!StatsIndex::fromBytes(reinterpret_cast<const uchar*>(invalid.data()), 5000), "reject invalid", 0, 5000);
+
+	std::printf("%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
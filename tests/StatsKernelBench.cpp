@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "app/StatsKernel.h"
+
+/**
+ * 统计内核吞吐量基准
+ *
+ * 对每个CPU支持的指令集分别测量：置零+统计+写出(readMatFile路径)、只统计(double/float)，
+ * 按读取的字节数计算GB/s，取多次运行中的最好成绩。用法：StatsKernelBench [数据点数量，默认16M]
+ */
+namespace
+{
+	const char* isaName(STATS::Isa isa)
+	{
+		switch (isa)
+		{
+		case STATS::Isa::SSE2: return "SSE2";
+		case STATS::Isa::AVX2: return "AVX2";
+		default: return "Scalar";
+		}
+	}
+
+	// 重复repeat次，返回最好一次的GB/s
+	template<typename F>
+	double measure(qint64 bytes, int repeat, F&& work)
+	{
+		double best = 0.0;
+		for (int i = 0; i < repeat; ++i) {
+			const auto start = std::chrono::steady_clock::now();
+			work();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = std::max(best, double(bytes) / seconds / 1e9);
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const qint64 count = argc > 1 ? std::atoll(argv[1]) : (qint64(1) << 24);
+	const int repeat = 5;
+	std::mt19937_64 engine(7);
+	std::normal_distribution<double> noise(0.0, 50.0);
+	std::vector<double> src(static_cast<size_t>(count)), dst(static_cast<size_t>(count));
+	for (double& value : src) {
+		value = noise(engine);
+	}
+	std::vector<float> floats(src.begin(), src.end());
+
+	std::printf("%lld points, best of %d runs (GB/s of input read)\n", static_cast<long long>(count), repeat);
+	std::printf("%-8s %16s %16s %16s\n", "isa", "clamp+stats+copy", "stats(double)", "stats(float)");
+	for (const STATS::Isa isa : { STATS::Isa::Scalar, STATS::Isa::SSE2, STATS::Isa::AVX2 }) {
+		if (STATS::setIsa(isa) != isa) {
+			std::printf("%-8s not supported by this CPU\n", isaName(isa));
+			continue;
+		}
+		const double clampCopy = measure(count * qint64(sizeof(double)), repeat, [&]() {
+			STATS::Moments moments;
+			STATS::accumulate(src.data(), count, -100.0, 100.0, moments, dst.data());
+			});
+		const double statsDouble = measure(count * qint64(sizeof(double)), repeat, [&]() {
+			STATS::Moments moments;
+			STATS::accumulate(src.data(), count, moments);
+			});
+		const double statsFloat = measure(count * qint64(sizeof(float)), repeat, [&]() {
+			STATS::Moments moments;
+			STATS::accumulate(floats.data(), count, moments);
+			});
+		std::printf("%-8s %16.2f %16.2f %16.2f\n", isaName(isa), clampCopy, statsDouble, statsFloat);
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "app/StatsKernel.h"
+
+/**
+ * 统计内核单元测试
+ *
+ * 以标量实现(STATS::Isa::Scalar)为基准，SSE2/AVX2实现的最值、置零个数、写出的数据须完全一致，
+ * 均值与中心矩只有求和顺序不同，按相对误差比较；标量实现本身与long double两遍扫描的参考结果比较。
+ */
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, const char* what, const char* isa, qint64 count)
+	{
+		if (!condition) {
+			++failures;
+			std::printf("FAILED %s [%s, count=%lld]\n", what, isa, static_cast<long long>(count));
+		}
+	}
+
+	bool close(double value, double expected, double tolerance)
+	{
+		return std::fabs(value - expected) <= tolerance * std::max(1.0, std::fabs(expected));
+	}
+
+	const char* isaName(STATS::Isa isa)
+	{
+		switch (isa)
+		{
+		case STATS::Isa::SSE2: return "SSE2";
+		case STATS::Isa::AVX2: return "AVX2";
+		default: return "Scalar";
+		}
+	}
+
+	// 一次统计的全部输出
+	struct Result
+	{
+		STATS::Moments moments{};
+		qint64 clamped{ 0 };
+		std::vector<double> clampedData{};
+		std::vector<float> clampedFloats{};
+		STATS::Moments floatMoments{};
+	};
+
+	Result run(STATS::Isa isa, const std::vector<double>& src, const std::vector<float>& floats, double minValue, double maxValue)
+	{
+		STATS::setIsa(isa);
+		Result result;
+		const qint64 count = qint64(src.size());
+		result.clampedData.resize(src.size());
+		result.clampedFloats.resize(src.size());
+		result.clamped = STATS::accumulate(src.data(), count, minValue, maxValue, result.moments, result.clampedData.data());
+		STATS::Moments unused;
+		STATS::accumulate(src.data(), count, minValue, maxValue, unused, result.clampedFloats.data());
+		STATS::accumulate(floats.data(), count, result.floatMoments);
+		return result;
+	}
+
+	// long double两遍扫描的参考结果
+	STATS::Moments reference(const std::vector<double>& src, double minValue, double maxValue)
+	{
+		STATS::Moments moments;
+		long double sum = 0.0L;
+		for (double value : src) {
+			const double v = (value < minValue || value > maxValue) ? 0.0 : value;
+			moments.min = std::min(moments.min, v);
+			moments.max = std::max(moments.max, v);
+			sum += v;
+		}
+		moments.count = qint64(src.size());
+		if (src.empty()) {
+			return moments;
+		}
+		const long double mean = sum / src.size();
+		long double m2 = 0.0L, m3 = 0.0L, m4 = 0.0L;
+		for (double value : src) {
+			const long double d = ((value < minValue || value > maxValue) ? 0.0 : value) - mean;
+			m2 += d * d;
+			m3 += d * d * d;
+			m4 += d * d * d * d;
+		}
+		moments.mean = double(mean);
+		moments.m2 = double(m2);
+		moments.m3 = double(m3);
+		moments.m4 = double(m4);
+		return moments;
+	}
+
+	void compareMoments(const STATS::Moments& value, const STATS::Moments& expected, double tolerance, const char* what, const char* isa)
+	{
+		const double scale = std::max(1.0, std::fabs(expected.m2));
+		check(value.count == expected.count, what, isa, expected.count);
+		check(value.min == expected.min && value.max == expected.max, what, isa, expected.count);
+		check(close(value.mean, expected.mean, tolerance), what, isa, expected.count);
+		check(std::fabs(value.m2 - expected.m2) <= tolerance * scale, what, isa, expected.count);
+		check(std::fabs(value.m3 - expected.m3) <= tolerance * scale * std::max(1.0, std::sqrt(scale)), what, isa, expected.count);
+		check(std::fabs(value.m4 - expected.m4) <= tolerance * scale * scale, what, isa, expected.count);
+	}
+}
+
+int main()
+{
+	std::mt19937_64 engine(20240611);
+	std::normal_distribution<double> noise(3.0, 40.0);
+	const qint64 sizes[] = { 0, 1, 3, 7, 8, 31, STATS::CHUNK_SIZE - 1, STATS::CHUNK_SIZE, STATS::CHUNK_SIZE + 5, 100003 };
+	const double minValue = -80.0, maxValue = 90.0;
+
+	for (const qint64 count : sizes) {
+		// 含越界值、NaN之外的全部情况(NaN按逐点比较不置零，参与统计后结果为NaN，单独验证)
+		std::vector<double> src(static_cast<size_t>(count));
+		for (double& value : src) {
+			value = noise(engine);
+		}
+		std::vector<float> floats(src.begin(), src.end());
+
+		const Result scalar = run(STATS::Isa::Scalar, src, floats, minValue, maxValue);
+		compareMoments(scalar.moments, reference(src, minValue, maxValue), 1e-12, "scalar vs long double", "Scalar");
+		std::vector<double> widened(floats.begin(), floats.end());
+		compareMoments(scalar.floatMoments, reference(widened, -INFINITY, INFINITY), 1e-12, "scalar float vs long double", "Scalar");
+
+		for (const STATS::Isa isa : { STATS::Isa::SSE2, STATS::Isa::AVX2 }) {
+			if (STATS::setIsa(isa) != isa) {
+				std::printf("skip %s: not supported by this CPU\n", isaName(isa));
+				continue;
+			}
+			const Result simd = run(isa, src, floats, minValue, maxValue);
+			check(simd.clamped == scalar.clamped, "clamped count", isaName(isa), count);
+			check(simd.clampedData == scalar.clampedData, "clamped data", isaName(isa), count);
+			check(simd.clampedFloats == scalar.clampedFloats, "clamped floats", isaName(isa), count);
+			compareMoments(simd.moments, scalar.moments, 1e-13, "moments", isaName(isa));
+			compareMoments(simd.floatMoments, scalar.floatMoments, 1e-13, "float moments", isaName(isa));
+		}
+	}
+
+	// NaN不置零，统计结果为NaN(与逐点比较一致)
+	for (const STATS::Isa isa : { STATS::Isa::Scalar, STATS::Isa::SSE2, STATS::Isa::AVX2 }) {
+		if (STATS::setIsa(isa) != isa) {
+			continue;
+		}
+		std::vector<double> src(37, 1.0);
+		src[17] = NAN;
+		STATS::Moments moments;
+		const qint64 clamped = STATS::accumulate(src.data(), qint64(src.size()), minValue, maxValue, moments);
+		check(clamped == 0 && std::isnan(moments.mean), "NaN passthrough", isaName(isa), qint64(src.size()));
+	}
+
+	// 分块累加与一次累加、合并与顺序无关
+	{
+		STATS::setIsa(STATS::Isa::Scalar);
+		std::vector<double> src(50000);
+		for (double& value : src) {
+			value = noise(engine);
+		}
+		STATS::Moments whole, parts, left, right;
+		STATS::accumulate(src.data(), qint64(src.size()), whole);
+		for (size_t begin = 0; begin < src.size(); begin += 3001) {
+			STATS::accumulate(src.data() + begin, qint64(std::min<size_t>(3001, src.size() - begin)), parts);
+		}
+		STATS::accumulate(src.data(), 20000, left);
+		STATS::accumulate(src.data() + 20000, 30000, right);
+		right.merge(left);
+		compareMoments(parts, whole, 1e-12, "blockwise accumulate", "Scalar");
+		compareMoments(right, whole, 1e-12, "merge", "Scalar");
+	}
+
+	std::printf("%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "charts/PSDAnalyzer.h"
+
+/**
+ * Welch功率谱单元测试
+ *
+ * 1. calculatePowerSpectralDensity/calculatePowerSpectralDensities与测试中独立实现的参考结果(逐段直接DFT，
+ *    窗函数、去趋势、平均方式、单边谱与输出范围按WelchConfig的定义)比较；
+ * 2. WelchAccumulator任意分块追加的结果与整段计算一致；
+ * 3. parseWelchConfig拒绝无效取值；
+ * 4. 互谱：自谱与按段平均的功率谱一致，互谱与参考实现一致，信号与其缩放的相干函数为1、传递函数幅值为缩放系数，
+ *    pairIndex按行存放上三角，分多块(blockSegments < segmentCount)、任意块大小与信号/信号对区间划分时结果相同；
+ * 5. 时频谱：每列一帧时各列等于该帧的功率谱，多帧合并时各列为所含帧(含不满的最后一列)的平均，
+ *    computeSpectrogramColumns分列区间计算与一次计算全部列的结果相同；
+ * 6. 单精度FFT(WelchConfig::precision)的批量功率谱与时频谱与双精度结果之差在峰值的1e-6以内。
+ */
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	int failures = 0;
+
+	void check(bool condition, const char* what, const char* config)
+	{
+		if (!condition) {
+			++failures;
+			std::printf("FAILED %s [%s]\n", what, config);
+		}
+	}
+
+	// 第一类零阶修正贝塞尔函数(级数)
+	double besselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 200 && term > 1e-18 * sum; ++k) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// 对称窗
+	std::vector<double> window(PSDA::WindowType type, int n, double beta)
+	{
+		std::vector<double> w(size_t(n), 1.0);
+		auto cosineSum = [&](std::initializer_list<double> a) {
+			for (int i = 0; i < n; ++i) {
+				double value = 0.0, sign = 1.0;
+				int k = 0;
+				for (double ak : a) {
+					value += sign * ak * std::cos(2.0 * PI * k * i / (n - 1));
+					sign = -sign;
+					++k;
+				}
+				w[size_t(i)] = value;
+			}
+		};
+		switch (type)
+		{
+		case PSDA::WindowType::Hann: cosineSum({ 0.5, 0.5 }); break;
+		case PSDA::WindowType::Hamming: cosineSum({ 0.54, 0.46 }); break;
+		case PSDA::WindowType::BlackmanHarris: cosineSum({ 0.35875, 0.48829, 0.14128, 0.01168 }); break;
+		case PSDA::WindowType::FlatTop: cosineSum({ 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 }); break;
+		case PSDA::WindowType::Kaiser:
+			for (int i = 0; i < n; ++i) {
+				const double r = 2.0 * i / (n - 1) - 1.0;
+				w[size_t(i)] = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+			}
+			break;
+		}
+		return w;
+	}
+
+	// 参考实现的分段：逐段去趋势、加窗后直接DFT，返回各段的频谱(未归一化)，nfft输出实际的每段点数，scale为归一化系数
+	std::vector<std::vector<std::complex<double>>> referenceFrames(const std::vector<double>& x, double fs, const PSDA::WelchConfig& config,
+		int& nfft, double& scale)
+	{
+		const int n = int(x.size());
+		nfft = config.nfft;
+		if (nfft <= 0) {
+			int p = 1;
+			while (p < n) {
+				p *= 2;
+			}
+			nfft = std::min(std::max(config.minNfft, std::min(p, n)), config.maxNfft);
+		}
+		const int overlap = int(nfft * config.overlap);
+		const int step = nfft - overlap;
+		const int segments = std::max(1, (n - overlap) / step);
+		const std::vector<double> w = window(config.window, nfft, config.kaiserBeta);
+		double power = 0.0;
+		for (double v : w) {
+			power += v * v;
+		}
+		scale = 1.0 / (fs * power * nfft);
+		const int bins = nfft / 2 + 1;
+
+		std::vector<double> cosines(static_cast<size_t>(nfft)), sines(static_cast<size_t>(nfft));
+		for (int j = 0; j < nfft; ++j) {
+			cosines[size_t(j)] = std::cos(2.0 * PI * j / nfft);
+			sines[size_t(j)] = -std::sin(2.0 * PI * j / nfft);
+		}
+		std::vector<std::vector<std::complex<double>>> frames(static_cast<size_t>(segments), std::vector<std::complex<double>>(static_cast<size_t>(bins)));
+		std::vector<double> segment(static_cast<size_t>(nfft));
+		for (int s = 0; s < segments; ++s) {
+			const double* src = x.data() + size_t(s) * step;
+			segment.assign(src, src + nfft);
+			if (config.detrend == PSDA::DetrendMode::Mean) {
+				double mean = 0.0;
+				for (double v : segment) {
+					mean += v;
+				}
+				mean /= nfft;
+				for (double& v : segment) {
+					v -= mean;
+				}
+			}
+			else if (config.detrend == PSDA::DetrendMode::Linear) {
+				double si = 0.0, sy = 0.0, sii = 0.0, siy = 0.0;
+				for (int i = 0; i < nfft; ++i) {
+					si += i;
+					sy += segment[size_t(i)];
+					sii += double(i) * i;
+					siy += i * segment[size_t(i)];
+				}
+				const double slope = (nfft * siy - si * sy) / (nfft * sii - si * si);
+				const double intercept = (sy - slope * si) / nfft;
+				for (int i = 0; i < nfft; ++i) {
+					segment[size_t(i)] -= intercept + slope * i;
+				}
+			}
+			for (int k = 0; k < bins; ++k) {
+				long double re = 0.0L, im = 0.0L;
+				for (int i = 0; i < nfft; ++i) {
+					const size_t j = size_t((qint64(k) * i) % nfft);
+					const double v = segment[size_t(i)] * w[size_t(i)];
+					re += v * cosines[j];
+					im += v * sines[j];
+				}
+				frames[size_t(s)][size_t(k)] = std::complex<double>(double(re), double(im));
+			}
+		}
+		return frames;
+	}
+
+	// 单边谱加倍、低频置零并截取输出范围
+	template<typename T>
+	void referenceOutput(std::vector<T>& spectrum, int nfft, const PSDA::WelchConfig& config)
+	{
+		const int bins = int(spectrum.size());
+		if (config.oneSided) {
+			const int last = nfft % 2 == 0 ? bins - 1 : bins;
+			for (int k = 1; k < last; ++k) {
+				spectrum[size_t(k)] *= 2.0;
+			}
+		}
+		for (int k = 0; k < std::min(config.zeroBins, bins); ++k) {
+			spectrum[size_t(k)] = T();
+		}
+		const int maxBin = std::min(int(config.maxFreqRatio * bins), bins - 1);
+		spectrum.resize(size_t(maxBin + 1));
+	}
+
+	// 参考功率谱，nfft输出实际的每段点数
+	std::vector<double> referencePsd(const std::vector<double>& x, double fs, const PSDA::WelchConfig& config, int& nfft)
+	{
+		double scale = 0.0;
+		const auto frames = referenceFrames(x, fs, config, nfft, scale);
+		const int segments = int(frames.size());
+		const int bins = nfft / 2 + 1;
+		std::vector<double> pxx(size_t(bins), 0.0);
+		for (int k = 0; k < bins; ++k) {
+			if (config.averaging == PSDA::Averaging::Median) {
+				std::vector<double> values;
+				for (const auto& frame : frames) {
+					values.push_back(std::norm(frame[size_t(k)]) * scale);
+				}
+				std::sort(values.begin(), values.end());
+				const size_t m = values.size();
+				const double median = m % 2 ? values[m / 2] : 0.5 * (values[m / 2 - 1] + values[m / 2]);
+				double bias = 1.0;
+				for (int j = 1; j <= (segments - 1) / 2; ++j) {
+					bias += 1.0 / (2 * j + 1) - 1.0 / (2 * j);
+				}
+				pxx[size_t(k)] = median / bias;
+			}
+			else {
+				for (const auto& frame : frames) {
+					pxx[size_t(k)] += std::norm(frame[size_t(k)]) * scale;
+				}
+				pxx[size_t(k)] /= segments;
+			}
+		}
+		referenceOutput(pxx, nfft, config);
+		return pxx;
+	}
+
+	// 参考互谱conj(Xa)·Xb(按段平均)
+	std::vector<std::complex<double>> referenceCross(const std::vector<double>& xa, const std::vector<double>& xb, double fs,
+		const PSDA::WelchConfig& config)
+	{
+		int nfft = 0;
+		double scale = 0.0;
+		const auto fa = referenceFrames(xa, fs, config, nfft, scale);
+		const auto fb = referenceFrames(xb, fs, config, nfft, scale);
+		std::vector<std::complex<double>> gab(size_t(nfft / 2 + 1));
+		for (size_t s = 0; s < fa.size(); ++s) {
+			for (size_t k = 0; k < gab.size(); ++k) {
+				gab[k] += std::conj(fa[s][k]) * fb[s][k] * scale;
+			}
+		}
+		for (auto& v : gab) {
+			v /= double(fa.size());
+		}
+		referenceOutput(gab, nfft, config);
+		return gab;
+	}
+
+	bool matches(const QVector<double>& value, const std::vector<double>& expected, double tolerance)
+	{
+		if (value.size() != int(expected.size())) {
+			return false;
+		}
+		const double peak = *std::max_element(expected.begin(), expected.end());
+		for (int i = 0; i < value.size(); ++i) {
+			if (std::fabs(value[i] - expected[size_t(i)]) > tolerance * peak) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool matchesCross(const QVector<std::complex<double>>& value, const std::vector<std::complex<double>>& expected, double tolerance)
+	{
+		if (value.size() != int(expected.size())) {
+			return false;
+		}
+		double peak = 0.0;
+		for (const auto& v : expected) {
+			peak = std::max(peak, std::abs(v));
+		}
+		for (int i = 0; i < value.size(); ++i) {
+			if (std::abs(value[i] - expected[size_t(i)]) > tolerance * peak) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool sameSpectrum(const QVector<double>& value, const QVector<double>& expected)
+	{
+		if (value.size() != expected.size()) {
+			return false;
+		}
+		for (int i = 0; i < value.size(); ++i) {
+			if (std::fabs(value[i] - expected[i]) > 1e-12 * std::fabs(expected[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	const double fs = 200.0;
+	const int n = 20000;
+	std::mt19937_64 engine(7);
+	std::normal_distribution<double> noise;
+	std::vector<std::vector<double>> channels(3, std::vector<double>(static_cast<size_t>(n)));
+	for (int s = 0; s < 3; ++s) {
+		for (int i = 0; i < n; ++i) {
+			channels[size_t(s)][size_t(i)] = noise(engine) + 0.001 * i * (s + 1) + std::sin(0.3 * i) * (s + 1);
+		}
+	}
+
+	// 1. 与参考实现比较
+	const char* configs[] = {
+		"",
+		"window=hamming,detrend=mean,nfft=512",
+		"window=blackmanharris,detrend=linear,averaging=median,nfft=1024",
+		"window=flattop,overlap=0.75,nfft=1000,onesided=1,zerobins=0,maxfreq=1",
+		"window=kaiser,beta=6,averaging=median,nfft=2048,detrend=linear,zerobins=1",
+		"averaging=median,nfft=4000,overlap=0",
+	};
+	for (const char* text : configs) {
+		PSDA::WelchConfig config;
+		check(PSDA::parseWelchConfig(QString(text), config), "parse", text);
+		QVector<const double*> inputs;
+		for (const auto& channel : channels) {
+			inputs.append(channel.data());
+		}
+		QVector<double> batchFreqs;
+		QVector<QVector<double>> batch;
+		PSDA::calculatePowerSpectralDensities(inputs, n, fs, batchFreqs, batch, config);
+		check(batch.size() == 3, "batch count", text);
+		for (int s = 0; s < 3 && s < batch.size(); ++s) {
+			QVector<double> freqs, pxx;
+			PSDA::calculatePowerSpectralDensity(channels[size_t(s)].data(), n, fs, config, freqs, pxx);
+			int nfft = 0;
+			const std::vector<double> expected = referencePsd(channels[size_t(s)], fs, config, nfft);
+			check(matches(pxx, expected, 1e-9), "single vs reference", text);
+			check(sameSpectrum(batch[s], pxx) && batchFreqs == freqs, "batch vs single", text);
+			bool freqsOk = freqs.size() == pxx.size();
+			for (int i = 0; freqsOk && i < freqs.size(); ++i) {
+				freqsOk = std::fabs(freqs[i] - i * fs / nfft) <= 1e-12 * fs;
+			}
+			check(freqsOk, "freqs", text);
+		}
+	}
+
+	// 2. 分块追加的结果等于整段计算(流式读取时的功率谱)
+	std::uniform_int_distribution<int> blockSize(1, 3000);
+	for (const char* text : { "nfft=1024", "nfft=500,overlap=0.3,window=hamming,detrend=linear", "averaging=median,nfft=256", "" }) {
+		PSDA::WelchConfig config;
+		PSDA::parseWelchConfig(QString(text), config);
+		const int count = 60000;
+		std::vector<double> x(static_cast<size_t>(count));
+		for (double& v : x) {
+			v = noise(engine);
+		}
+		PSDA::WelchAccumulator accumulator(count, 100.0, config);
+		int position = 0;
+		while (position < count) {
+			const int size = std::min(blockSize(engine), count - position);
+			accumulator.append(x.data() + position, size);
+			position += size;
+		}
+		QVector<double> freqs, pxx, expectedFreqs, expected;
+		accumulator.result(freqs, pxx);
+		PSDA::calculatePowerSpectralDensity(x.data(), count, 100.0, config, expectedFreqs, expected);
+		check(sameSpectrum(pxx, expected) && freqs == expectedFreqs, "blockwise append", text);
+	}
+
+	// 3. 无效参数
+	for (const char* text : { "window=foo", "overlap=1.5", "nfft=1", "nfft=-8", "nfft=abc", "minnfft=1", "minnfft=512,maxnfft=256", "beta" }) {
+		PSDA::WelchConfig config;
+		config.nfft = 123;
+		check(!PSDA::parseWelchConfig(QString(text), config) && config.nfft == 123, "reject invalid", text);
+	}
+	PSDA::WelchConfig automatic;
+	check(PSDA::parseWelchConfig(QString("nfft=0"), automatic) && automatic.nfft == 0, "nfft=0 (automatic)", "nfft=0");
+
+	// 4. 互谱
+	for (const char* text : { "", "window=hamming,detrend=linear,nfft=512,onesided=1", "window=kaiser,beta=6,overlap=0.75,nfft=1000,zerobins=0,maxfreq=1" }) {
+		PSDA::WelchConfig config;
+		PSDA::parseWelchConfig(QString(text), config);
+		QVector<const double*> inputs;
+		for (const auto& channel : channels) {
+			inputs.append(channel.data());
+		}
+		PSDA::CrossSpectra spectra;
+		check(PSDA::calculateCrossSpectra(inputs, n, fs, config, spectra) && spectra.signalCount == 3 && spectra.spectra.size() == 6,
+			"cross spectra", text);
+		QVector<double> freqs;
+		QVector<QVector<double>> psd;
+		PSDA::calculatePowerSpectralDensities(inputs, n, fs, freqs, psd, config);
+		check(spectra.freqs == freqs, "cross freqs", text);
+		for (int a = 0; a < 3 && spectra.spectra.size() == 6; ++a) {
+			QVector<double> autoSpectrum;
+			bool real = true;
+			for (int i = 0; i < spectra.freqs.size(); ++i) {
+				autoSpectrum.append(spectra.cross(a, a, i).real());
+				real = real && spectra.cross(a, a, i).imag() == 0.0;
+			}
+			check(real && matches(autoSpectrum, std::vector<double>(psd[a].begin(), psd[a].end()), 1e-12), "auto spectrum vs psd", text);
+			for (int b = a + 1; b < 3; ++b) {
+				const std::vector<std::complex<double>> expected = referenceCross(channels[size_t(a)], channels[size_t(b)], fs, config);
+				check(matchesCross(spectra.spectra[PSDA::CrossSpectra::pairIndex(a, b, 3)], expected, 1e-9), "cross vs reference", text);
+				check(std::conj(spectra.cross(a, b, 5)) == spectra.cross(b, a, 5), "cross conjugate", text);
+			}
+		}
+
+		// 信号与其缩放：相干函数为1，以原信号为输入的传递函数幅值为缩放系数、相位为0
+		const double gain = 2.5;
+		std::vector<double> scaled(channels[0]);
+		for (double& v : scaled) {
+			v *= gain;
+		}
+		PSDA::CrossSpectra pair;
+		PSDA::calculateCrossSpectra({ channels[0].data(), scaled.data() }, n, fs, config, pair);
+		QVector<double> coherence, magnitude, phase;
+		pair.coherence(0, 1, coherence);
+		pair.transferFunction(0, 1, magnitude, phase);
+		bool unit = true, transfer = true;
+		for (int i = 0; i < pair.freqs.size(); ++i) {
+			if (pair.cross(0, 0, i).real() <= 0.0) {
+				unit = unit && coherence[i] == 0.0;
+				continue;
+			}
+			unit = unit && std::fabs(coherence[i] - 1.0) < 1e-9;
+			transfer = transfer && std::fabs(magnitude[i] - gain) < 1e-9 * gain && std::fabs(phase[i]) < 1e-9;
+		}
+		const double from = pair.freqs[std::min(config.zeroBins, int(pair.freqs.size()) - 1)];
+		check(unit && std::fabs(pair.meanCoherence(0, 1, from, pair.freqs.last()) - 1.0) < 1e-9, "coherence of scaled copy", text);
+		check(transfer, "transfer function of scaled copy", text);
+	}
+
+	// pairIndex：a<=b按行排列依次编号
+	for (int signalCount : { 1, 2, 5 }) {
+		int index = 0;
+		bool ordered = true;
+		for (int a = 0; a < signalCount; ++a) {
+			for (int b = a; b < signalCount; ++b) {
+				ordered = ordered && PSDA::CrossSpectra::pairIndex(a, b, signalCount) == index++;
+			}
+		}
+		check(ordered && index == signalCount * (signalCount + 1) / 2, "pairIndex", signalCount == 5 ? "5 signals" : "few signals");
+	}
+
+	// 段数超过一块时分块累加，结果与参考实现(一次累加全部段)一致，且不随块大小与区间划分变化
+	{
+		const char* text = "nfft=64,overlap=0.5";
+		PSDA::WelchConfig config;
+		PSDA::parseWelchConfig(QString(text), config);
+		QVector<const double*> inputs;
+		for (const auto& channel : channels) {
+			inputs.append(channel.data());
+		}
+		PSDA::CrossSpectralAccumulator accumulator(3, n, fs, config);
+		check(accumulator.blockSegments() < accumulator.segmentCount(), "several blocks", text);
+		PSDA::CrossSpectra blocks;
+		PSDA::calculateCrossSpectra(inputs, n, fs, config, blocks);
+		for (int a = 0; a < 3 && blocks.spectra.size() == 6; ++a) {
+			for (int b = a; b < 3; ++b) {
+				const std::vector<std::complex<double>> expected = referenceCross(channels[size_t(a)], channels[size_t(b)], fs, config);
+				check(matchesCross(blocks.spectra[PSDA::CrossSpectra::pairIndex(a, b, 3)], expected, 1e-9), "blocks vs reference", text);
+			}
+		}
+
+		std::uniform_int_distribution<int> segmentsPerBlock(1, accumulator.blockSegments());
+		for (int first = 0; first < accumulator.segmentCount();) {
+			const int last = std::min(first + segmentsPerBlock(engine), accumulator.segmentCount());
+			accumulator.beginBlock(first, last);
+			accumulator.transform(inputs, 0, 1);
+			accumulator.transform(inputs, 1, 3);
+			accumulator.accumulate(0, 4);
+			accumulator.accumulate(4, accumulator.pairCount());
+			first = last;
+		}
+		PSDA::CrossSpectra split;
+		accumulator.result(split);
+		bool same = split.freqs == blocks.freqs && split.spectra.size() == blocks.spectra.size();
+		for (int p = 0; same && p < split.spectra.size(); ++p) {
+			for (int i = 0; same && i < split.freqs.size(); ++i) {
+				same = std::abs(split.spectra[p][i] - blocks.spectra[p][i]) <= 1e-12 * std::abs(blocks.spectra[p][i]);
+			}
+		}
+		check(same, "block size / range split", text);
+	}
+
+	// 5. 时频谱
+	for (const char* text : { "nfft=256", "window=hamming,detrend=linear,nfft=300,overlap=0.25,onesided=1", "window=kaiser,nfft=512,zerobins=0,maxfreq=1" }) {
+		PSDA::WelchConfig config;
+		PSDA::parseWelchConfig(QString(text), config);
+		const std::vector<double>& x = channels[1];
+		// 单帧的功率谱(一段时平均方式不影响结果)
+		PSDA::WelchConfig frameConfig = config;
+		auto framePsd = [&](int frame, int nfft, int step) {
+			frameConfig.nfft = nfft;
+			QVector<double> freqs, pxx;
+			PSDA::calculatePowerSpectralDensity(x.data() + qint64(frame) * step, nfft, fs, frameConfig, freqs, pxx);
+			return pxx;
+		};
+		auto column = [](const PSDA::Spectrogram& result, int c) {
+			const int count = result.freqs.count();
+			return QVector<double>(result.power.begin() + qint64(c) * count, result.power.begin() + qint64(c + 1) * count);
+		};
+
+		// 每列一帧
+		PSDA::Spectrogram single;
+		check(PSDA::calculateSpectrogram(x.data(), n, fs, config, 100000, single) && single.framesPerColumn == 1
+			&& single.columnCount() == single.frameCount, "spectrogram layout", text);
+		bool framesOk = true, timesOk = true;
+		for (int c = 0; c < single.columnCount(); ++c) {
+			const QVector<double> expected = framePsd(c, single.nfft, single.step);
+			framesOk = framesOk && matches(column(single, c), std::vector<double>(expected.begin(), expected.end()), 1e-12);
+			timesOk = timesOk && std::fabs(single.times[c] - (c * single.step + single.nfft / 2.0) / fs) < 1e-9;
+		}
+		check(framesOk, "spectrogram column vs frame psd", text);
+		check(timesOk, "spectrogram times", text);
+
+		// 多帧合并为一列，选取使最后一列不满的列数
+		int maxColumns = single.frameCount / 4;
+		while (single.frameCount % ((single.frameCount + maxColumns - 1) / maxColumns) == 0) {
+			--maxColumns;
+		}
+		PSDA::Spectrogram merged;
+		PSDA::calculateSpectrogram(x.data(), n, fs, config, maxColumns, merged);
+		check(merged.framesPerColumn > 1 && merged.columnCount() <= maxColumns
+			&& merged.frameCount % merged.framesPerColumn != 0, "merged layout", text);
+		bool averageOk = true;
+		for (int c = 0; c < merged.columnCount(); ++c) {
+			const int first = c * merged.framesPerColumn;
+			const int last = std::min(first + merged.framesPerColumn, merged.frameCount);
+			std::vector<double> expected(size_t(merged.freqs.count()), 0.0);
+			for (int frame = first; frame < last; ++frame) {
+				const QVector<double> pxx = framePsd(frame, merged.nfft, merged.step);
+				for (size_t i = 0; i < expected.size(); ++i) {
+					expected[i] += pxx[int(i)] / (last - first);
+				}
+			}
+			averageOk = averageOk && matches(column(merged, c), expected, 1e-12);
+		}
+		check(averageOk, "merged column average", text);
+
+		// 分列区间计算(可在多个线程中同时进行)
+		PSDA::Spectrogram layout;
+		PSDA::prepareSpectrogram(n, fs, config, maxColumns, layout);
+		for (int first = 0, size = 1; first < layout.columnCount(); first += size, size += 2) {
+			PSDA::computeSpectrogramColumns(x.data(), fs, config, layout, first, std::min(first + size, layout.columnCount()),
+				layout.power.data());
+		}
+		check(layout.power == merged.power && layout.times == merged.times && layout.freqs == merged.freqs, "spectrogram column ranges", text);
+	}
+
+	// 6. 单精度与双精度
+	for (const char* text : { "", "window=blackmanharris,detrend=linear,averaging=median,nfft=1024", "window=flattop,nfft=300,onesided=1,zerobins=0,maxfreq=1" }) {
+		PSDA::WelchConfig config;
+		PSDA::parseWelchConfig(QString(text), config);
+		PSDA::WelchConfig single = config;
+		single.precision = PSDA::Precision::Float;
+		QVector<const double*> inputs;
+		for (const auto& channel : channels) {
+			inputs.append(channel.data());
+		}
+		QVector<double> freqs, floatFreqs;
+		QVector<QVector<double>> psd, floatPsd;
+		PSDA::calculatePowerSpectralDensities(inputs, n, fs, freqs, psd, config);
+		PSDA::calculatePowerSpectralDensities(inputs, n, fs, floatFreqs, floatPsd, single);
+		bool close = floatFreqs == freqs && floatPsd.size() == psd.size();
+		for (int s = 0; close && s < psd.size(); ++s) {
+			close = matches(floatPsd[s], std::vector<double>(psd[s].begin(), psd[s].end()), 1e-6);
+		}
+		// 结果不完全相同说明确实使用了单精度计划
+		check(close && floatPsd != psd, "float psd vs double", text);
+
+		PSDA::Spectrogram spectrogram, floatSpectrogram;
+		PSDA::calculateSpectrogram(channels[2].data(), n, fs, config, 50, spectrogram);
+		PSDA::calculateSpectrogram(channels[2].data(), n, fs, single, 50, floatSpectrogram);
+		check(floatSpectrogram.times == spectrogram.times && floatSpectrogram.freqs == spectrogram.freqs
+			&& matches(floatSpectrogram.power, std::vector<double>(spectrogram.power.begin(), spectrogram.power.end()), 1e-6)
+			&& floatSpectrogram.power != spectrogram.power,
+			"float spectrogram vs double", text);
+	}
+
+	std::printf("%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}